@@ -0,0 +1,158 @@
+#! /usr/bin/env python
+
+import sys
+import os
+import getopt
+import subprocess
+from host.host_build import buildHostProgram, readAppinfo, watchStyles, configureStyle
+
+help = """
+bench_watch.py
+
+This script benchmarks the bitmap pipeline on the development host,
+for each bitmap resource (.png or .rle) in the watch as currently
+configured by config_watch.py: decoding, flipping, color remapping,
+and copying, along with the heap cost of each decode.  The real code
+in src/ is compiled natively against the SDK stand-in in host/, and
+each operation is timed over a fixed number of iterations, so that
+the results of two different commits may be compared directly.
+
+The results are written as CSV, one row per asset, followed by a
+TOTAL row for each style and platform.  Times are in microseconds per
+call; byte counts are per decode.
+
+bench_watch.py [opts]
+
+Options:
+
+    -p platform[,platform...]
+        Specifies the platform(s) to benchmark (aplite, basalt, and/or
+        chalk).  The default is all of the platforms targeted by the
+        current build.
+
+    -s style[,style...]
+        Reconfigures the watch to each of the indicated styles in
+        turn, and benchmarks each one.  The style names are %(styles)s,
+        or "all" for all of them.  This leaves the last style
+        configured.  The default is to benchmark the watch as it is
+        currently configured, labeled as style "current".
+
+    -n iterations
+        The number of timed iterations of each operation.  The default
+        is 50.
+
+    -o filename
+        Writes the CSV to the indicated file, instead of to stdout.
+
+    -v
+        Verbose: show the compile commands and the watch's log output.
+
+""" % { 'styles' : ', '.join([style for style, configArgs in watchStyles]) }
+
+def usage(code, msg = ''):
+    print >> sys.stderr, help
+    print >> sys.stderr, msg
+    sys.exit(code)
+
+# The columns that are summed into the TOTAL row; the others are left
+# blank there, except for decode_peak_bytes, which takes the maximum.
+sumColumns = [ 'file_bytes', 'decode_us', 'flip_x_us', 'flip_y_us', 'remap_us', 'copy_us', 'decode_alloc_bytes', 'resident_bytes' ]
+maxColumns = [ 'decode_peak_bytes' ]
+
+def benchPlatform(style, platform, iterations, output, writeHeader, verbose):
+    """ Builds and runs the benchmark for the indicated platform, and
+    writes its rows, followed by a TOTAL row, to output. """
+
+    program, manifestFilename = buildHostProgram(platform, 'bench_bwd.c', 'bench_bwd', verbose = verbose)
+    cmd = [ program, '-R', manifestFilename, '-n', str(iterations) ]
+    if verbose:
+        cmd.append('-v')
+        print >> sys.stderr, ' '.join(cmd)
+
+    process = subprocess.Popen(cmd, stdout = subprocess.PIPE)
+    lines = process.communicate()[0].splitlines()
+    if process.returncode != 0 or not lines:
+        print >> sys.stderr, "Benchmark failed for %s %s." % (style, platform)
+        sys.exit(1)
+
+    columns = lines[0].split(',')
+    if writeHeader:
+        print >> output, 'style,platform,' + lines[0]
+
+    totals = {}
+    for line in lines[1:]:
+        print >> output, '%s,%s,%s' % (style, platform, line)
+        row = dict(zip(columns, line.split(',')))
+        for column in sumColumns + maxColumns:
+            if not row[column]:
+                continue
+            value = float(row[column])
+            if column in maxColumns:
+                totals[column] = max(totals.get(column, 0), value)
+            else:
+                totals[column] = totals.get(column, 0) + value
+
+    row = []
+    for column in columns:
+        if column == 'asset':
+            row.append('TOTAL')
+        elif column in totals:
+            if column.endswith('_us'):
+                row.append('%.2f' % (totals[column]))
+            else:
+                row.append('%d' % (totals[column]))
+        else:
+            row.append('')
+    print >> output, '%s,%s,%s' % (style, platform, ','.join(row))
+    output.flush()
+
+    print >> sys.stderr, "%s %s: %s assets" % (style, platform, len(lines) - 1)
+
+# Main.
+try:
+    opts, args = getopt.getopt(sys.argv[1:], 'p:s:n:o:vh')
+except getopt.error, msg:
+    usage(1, msg)
+
+targetPlatforms = []
+styles = []
+iterations = 50
+outputFilename = None
+verbose = False
+for opt, arg in opts:
+    if opt == '-p':
+        targetPlatforms += arg.split(',')
+    elif opt == '-s':
+        if arg == 'all':
+            styles += [style for style, configArgs in watchStyles]
+        else:
+            styles += arg.split(',')
+    elif opt == '-n':
+        iterations = int(arg)
+    elif opt == '-o':
+        outputFilename = arg
+    elif opt == '-v':
+        verbose = True
+    elif opt == '-h':
+        usage(0)
+
+for style in styles:
+    if style not in dict(watchStyles):
+        usage(1, "Unknown style '%s'." % (style))
+
+output = sys.stdout
+if outputFilename:
+    output = open(outputFilename, 'w')
+
+writeHeader = True
+for style in styles or [ 'current' ]:
+    if style != 'current':
+        configureStyle(style, verbose = verbose)
+
+    appinfo = readAppinfo()
+    platforms = targetPlatforms or appinfo['targetPlatforms']
+    for platform in platforms:
+        if platform not in appinfo['targetPlatforms']:
+            continue
+        benchPlatform(style, platform, iterations, output, writeHeader, verbose)
+        writeHeader = False
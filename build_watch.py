@@ -0,0 +1,187 @@
+#! /usr/bin/env python
+
+import sys
+import os
+import glob
+import time
+import shutil
+import getopt
+import subprocess
+import multiprocessing
+import multiprocessing.pool
+
+help = """
+build_watch.py
+
+This script makes the release builds of the watch: it configures each
+of the builds listed below into a directory of its own, with
+config_watch.py -o, and builds it there with "pebble build".  Since
+the builds don't share any generated files, they all run in parallel;
+the image resources common to several of them (the indicators, the
+moon wheel, and so on) are generated only once, and shared through the
+asset cache in resources/build/cache.  The resulting .pbw files are
+collected into build/, as rosewright_<build>.pbw.
+
+The release builds are:
+  %(builds)s
+
+build_watch.py [opts]
+
+Options:
+
+    -b build[,build...]
+        Makes only the indicated builds.  The default is all of them.
+
+    -p platform[,platform...]
+        Targets only the indicated platforms (aplite, basalt, and/or
+        chalk) in each build.  The default is all three.
+
+    -j jobs
+        Runs this many builds at once.  The default is the number of
+        CPUs on the host, or the number of builds, whichever is
+        smaller; each build's config_watch.py gets an equal share of
+        the CPUs.
+
+    -d dir
+        Configures each build into a subdirectory of this directory.
+        The default is build/configs.
+
+    -c
+        Configures each build, but doesn't run "pebble build".
+
+    -v
+        Verbose: show each command, and the output of each build as
+        it finishes.
+
+"""
+
+# The release builds, each listed with its config_watch.py options.
+releaseBuilds = [
+    ('a', ['-s', 'a', '-x']),
+    ('b', ['-s', 'b', '-x']),
+    ('c2', ['-s', 'c', '-c', '-x']),
+    ('d', ['-s', 'd', '-x']),
+    ('e', ['-s', 'e']),
+    ]
+
+rootDir = os.path.abspath(os.path.dirname(__file__) or '.')
+
+def usage(code, msg = ''):
+    print >> sys.stderr, help % {
+        'builds' : '\n  '.join(['%s: config_watch.py %s' % (build, ' '.join(configArgs)) for build, configArgs in releaseBuilds]),
+        }
+    print >> sys.stderr, msg
+    sys.exit(code)
+
+def runStep(cmd, cwd, log):
+    """ Runs one step of a build, with its output appended to log.
+    Returns true on success. """
+
+    if verbose:
+        print >> sys.stderr, ' '.join(cmd)
+    print >> log, '$ %s' % (' '.join(cmd))
+    log.flush()
+    return subprocess.call(cmd, cwd = cwd, stdout = log, stderr = subprocess.STDOUT) == 0
+
+def makeBuild(build):
+    """ Configures and builds the indicated release build in its own
+    project directory.  Returns (build, pbwFilename, seconds), where
+    pbwFilename is None if the build failed.  This runs in a worker
+    thread. """
+
+    startTime = time.time()
+    projectDir = os.path.join(configsDir, build)
+    if not os.path.isdir(projectDir):
+        os.makedirs(projectDir)
+    logFilename = os.path.join(projectDir, 'build.log')
+    log = open(logFilename, 'w')
+
+    configArgs = dict(releaseBuilds)[build]
+    cmd = [ sys.executable, os.path.join(rootDir, 'config_watch.py'), '-o', projectDir, '-j', str(configJobs) ] + configArgs
+    for platform in targetPlatforms:
+        cmd += [ '-p', platform ]
+
+    pbwFilename = None
+    if runStep(cmd, rootDir, log):
+        if configureOnly:
+            pbwFilename = projectDir
+        else:
+            # Remove any .pbw left from a previous build, so we can't
+            # mistake it for the result of this one.
+            for filename in glob.glob(os.path.join(projectDir, 'build', '*.pbw')):
+                os.remove(filename)
+            if runStep([ 'pebble', 'build' ], projectDir, log):
+                pbws = glob.glob(os.path.join(projectDir, 'build', '*.pbw'))
+                if len(pbws) == 1:
+                    pbwFilename = os.path.join(outputDir, 'rosewright_%s.pbw' % (build))
+                    shutil.copyfile(pbws[0], pbwFilename)
+                else:
+                    print >> log, "Expected one .pbw file in %s." % (os.path.join(projectDir, 'build'))
+    log.close()
+
+    if verbose or not pbwFilename:
+        sys.stderr.write(open(logFilename, 'r').read())
+    return build, pbwFilename, time.time() - startTime
+
+# Main.
+try:
+    opts, args = getopt.getopt(sys.argv[1:], 'b:p:j:d:cvh')
+except getopt.error, msg:
+    usage(1, msg)
+
+builds = []
+targetPlatforms = []
+numJobs = None
+configsDir = os.path.join(rootDir, 'build', 'configs')
+configureOnly = False
+verbose = False
+for opt, arg in opts:
+    if opt == '-b':
+        builds += arg.split(',')
+    elif opt == '-p':
+        targetPlatforms += arg.split(',')
+    elif opt == '-j':
+        numJobs = int(arg)
+    elif opt == '-d':
+        configsDir = os.path.abspath(arg)
+    elif opt == '-c':
+        configureOnly = True
+    elif opt == '-v':
+        verbose = True
+    elif opt == '-h':
+        usage(0)
+
+if not builds:
+    builds = [build for build, configArgs in releaseBuilds]
+for build in builds:
+    if build not in dict(releaseBuilds):
+        usage(1, "Unknown build '%s'." % (build))
+
+numCpus = multiprocessing.cpu_count()
+if not numJobs:
+    numJobs = min(numCpus, len(builds))
+configJobs = max(1, numCpus / numJobs)
+
+outputDir = os.path.join(rootDir, 'build')
+if not os.path.isdir(outputDir):
+    os.makedirs(outputDir)
+
+startTime = time.time()
+pool = multiprocessing.pool.ThreadPool(numJobs)
+try:
+    results = pool.map(makeBuild, builds, 1)
+finally:
+    pool.close()
+    pool.join()
+
+failed = []
+for build, pbwFilename, seconds in results:
+    if pbwFilename:
+        print '%s: %s (%.1f s)' % (build, os.path.relpath(pbwFilename, rootDir), seconds)
+    else:
+        print '%s: failed (%.1f s); see %s' % (build, seconds, os.path.relpath(os.path.join(configsDir, build, 'build.log'), rootDir))
+        failed.append(build)
+
+print '%s of %s builds succeeded in %.1f s.' % (len(builds) - len(failed), len(builds), time.time() - startTime)
+if failed:
+    sys.exit(1)
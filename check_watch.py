@@ -0,0 +1,110 @@
+#! /usr/bin/env python
+
+import sys
+import os
+import getopt
+import subprocess
+from host.host_build import buildHostProgram, readAppinfo, watchStyles, configureStyle
+
+help = """
+check_watch.py
+
+This script checks, on the development host, that the hand placement
+in compute_hands() and compute_chrono_hands() agrees exactly with the
+plain division arithmetic it replaces, for the watch as currently
+configured by config_watch.py.  The watch computes each hand index
+with a multiply and a shift, using constants that config_watch.py
+derives from the step counts of each build; this compares every hand
+index for every millisecond of the day, and of the chronograph's
+12-hour cycle, in each of the relevant config settings, and also
+checks each constant over its full range.
+
+The real code in src/ is compiled natively against the SDK stand-in
+in host/.  Any mismatch is reported, and the script exits with a
+nonzero status.
+
+check_watch.py [opts]
+
+Options:
+
+    -p platform[,platform...]
+        Specifies the platform(s) to check (aplite, basalt, and/or
+        chalk).  The default is all of the platforms targeted by the
+        current build.
+
+    -s style[,style...]
+        Reconfigures the watch to each of the indicated styles in
+        turn, and checks each one.  The style names are %(styles)s,
+        or "all" for all of them.  This leaves the last style
+        configured.  The default is to check the watch as it is
+        currently configured.
+
+    -v
+        Verbose: show the compile commands and the watch's log output.
+
+""" % { 'styles' : ', '.join([style for style, configArgs in watchStyles]) }
+
+def usage(code, msg = ''):
+    print >> sys.stderr, help
+    print >> sys.stderr, msg
+    sys.exit(code)
+
+def checkPlatform(style, platform, verbose):
+    """ Builds and runs the check for the indicated platform.  Returns
+    true on success, false if it found a mismatch. """
+
+    program, manifestFilename = buildHostProgram(platform, 'check_hands.c', 'check_hands', verbose = verbose)
+    cmd = [ program, '-R', manifestFilename ]
+    if verbose:
+        cmd.append('-v')
+        print >> sys.stderr, ' '.join(cmd)
+
+    print "%s %s:" % (style, platform)
+    sys.stdout.flush()
+    result = subprocess.call(cmd)
+    if result != 0:
+        print "%s %s: failed." % (style, platform)
+        return False
+    return True
+
+# Main.
+try:
+    opts, args = getopt.getopt(sys.argv[1:], 'p:s:vh')
+except getopt.error, msg:
+    usage(1, msg)
+
+targetPlatforms = []
+styles = []
+verbose = False
+for opt, arg in opts:
+    if opt == '-p':
+        targetPlatforms += arg.split(',')
+    elif opt == '-s':
+        if arg == 'all':
+            styles += [style for style, configArgs in watchStyles]
+        else:
+            styles += arg.split(',')
+    elif opt == '-v':
+        verbose = True
+    elif opt == '-h':
+        usage(0)
+
+for style in styles:
+    if style not in dict(watchStyles):
+        usage(1, "Unknown style '%s'." % (style))
+
+failed = False
+for style in styles or [ 'current' ]:
+    if style != 'current':
+        configureStyle(style, verbose = verbose)
+
+    appinfo = readAppinfo()
+    platforms = targetPlatforms or appinfo['targetPlatforms']
+    for platform in platforms:
+        if platform not in appinfo['targetPlatforms']:
+            continue
+        if not checkPlatform(style, platform, verbose):
+            failed = True
+
+if failed:
+    sys.exit(1)
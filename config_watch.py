@@ -5,7 +5,12 @@ import PIL.ImageChops
 import sys
 import os
 import getopt
+import multiprocessing
+from resources import make_rle as rle_encoder
 from resources.make_rle import make_rle, make_rle_trans
+from resources import asset_cache
+from resources import resource_budget
+from resources import resource_dedupe
 
 help = """
 config_watch.py
@@ -39,9 +44,75 @@ Options:
     -x
         Perform no RLE compression of images.
 
+    -R weight
+        Trade RLE size against decode speed: each unit of estimated
+        decode cost counts as this many bytes when choosing how to
+        encode each image.  The default is 0, for the smallest
+        resources.  The encoding chosen for each image is listed in
+        resources/build/rle_report.txt.
+
+    -U
+        Don't try the unscreened (checkerboard-xored) RLE encoding of
+        1-bit images.
+
+    -P
+        Encode all of the rotations of each color bitmap hand (and of
+        its mask) with one shared palette, stored once in the code
+        instead of in every resource, wherever that doesn't cost any
+        rotation a deeper pixel format.  The watch then allocates and
+        remaps one palette per hand, instead of one per bitmap
+        decoded.
+
+    -r hand[,hand...]
+        Rotates the indicated bitmap hands (hour, minute, second,
+        chrono_minute, chrono_second, and/or chrono_tenth) on the
+        watch at runtime, from a single master bitmap, instead of
+        baking a bitmap for every step into the resources.  This
+        costs some CPU time and heap at each step, and the rotations
+        are sampled less smoothly than the baked ones, but the
+        resources no longer grow with the number of steps.
+
+    -A
+        Don't look for image resources that are identical to another
+        resource.  Normally, each such copy is made an alias of the
+        first resource with the same contents, which is loaded in its
+        place, and the copy's own file is replaced with an empty
+        placeholder.
+
     -p platform[,platform...]
         Specifies the build platform (aplite, basalt, and/or chalk).
 
+    -o dir
+        Writes the configured watch to the indicated directory, as a
+        Pebble project of its own, instead of into this tree.  The
+        generated appinfo.json, tables, and image resources are
+        written there, and everything else is linked from this tree;
+        run "pebble build" in that directory to build it.  Several
+        watches may be configured into different directories at once;
+        they all share the asset cache in this tree (see -n).
+
+    -B bytes
+    -B platform=bytes[,platform=bytes...]
+        Fail if the estimated worst-case heap use of the watch's
+        bitmaps exceeds this many bytes, on any platform or on the
+        indicated platforms.  The estimate is written, along with the
+        size and decoded size of every resource and the cost of the
+        second-hand resource caches, to resources/build/budget.json,
+        whether or not a limit is given.
+
+    -n
+        Ignore the asset cache in resources/build/cache, and
+        regenerate every image resource from scratch.  The cache is
+        refreshed with the results.  Normally, an image whose source
+        and parameters are unchanged since any previous run is simply
+        copied from the cache.
+
+    -j jobs
+        Renders the rotations of each bitmap hand in this many
+        parallel processes.  The default is the number of CPUs on the
+        host; -j 1 renders them serially.  The output is the same
+        either way.
+
     -d
         Compile for debugging.  Specifically this enables "fast time",
         so the hands move quickly about the face of the watch.  It
@@ -406,6 +477,10 @@ numStepsSweep = {
 # type, if we are enabling caching.
 resourceCacheSize = {}
 
+# The inputs to the bitmap hand currently being generated, shared with
+# the worker processes that render each of its rotations.
+handWork = {}
+
 thresholdMask = [0] + [255] * 255
 threshold1Bit = [0] * 128 + [255] * 128
 threshold2Bit = [0] * 64 + [85] * 64 + [170] * 64 + [255] * 64
@@ -419,6 +494,51 @@ buildDir = os.path.join(resourcesDir, 'build')
 if not os.path.isdir(buildDir):
     os.mkdir(buildDir)
 
+# This tree, which holds the sources, even if rootDir is changed to
+# another project directory with -o.
+sourceRootDir = os.path.abspath(rootDir)
+
+# The html config pages are the same for every configured watch, so
+# they are always written into this tree, even with -o.
+htmlDir = os.path.join(sourceRootDir, 'html')
+
+# The files that config_watch.py generates in a project's top level,
+# src, and resources directories; see makeProjectDir().
+generatedFiles = [ 'appinfo.json', 'build', 'pebble-js-app.js', 'generated_table.c', 'generated_defs.h', 'generated_config.h' ]
+
+def linkTree(sourceDir, targetDir):
+    """ Fills targetDir with symbolic links to the files in sourceDir,
+    except for the generated ones, recreating its subdirectories as real
+    directories, so that any file generated alongside the sources
+    (such as an .rle next to its png) lands in targetDir. """
+
+    if not os.path.isdir(targetDir):
+        os.makedirs(targetDir)
+    for name in os.listdir(sourceDir):
+        if name.startswith('.') or name in generatedFiles or name.endswith('.rle'):
+            # Generated files (every .rle is generated) are left out;
+            # the project gets its own.
+            continue
+        source = os.path.join(sourceDir, name)
+        target = os.path.join(targetDir, name)
+        if os.path.isdir(source):
+            linkTree(source, target)
+        elif not os.path.lexists(target):
+            os.symlink(source, target)
+
+def makeProjectDir(projectDir):
+    """ Sets up projectDir as a Pebble project of its own, for -o:
+    wscript, and the src and resources trees, linked from this
+    tree. """
+
+    if not os.path.isdir(projectDir):
+        os.makedirs(projectDir)
+    target = os.path.join(projectDir, 'wscript')
+    if not os.path.lexists(target):
+        os.symlink(os.path.join(sourceRootDir, 'wscript'), target)
+    for subdir in [ 'src', 'resources' ]:
+        linkTree(os.path.join(sourceRootDir, subdir), os.path.join(projectDir, subdir))
+
 def formatUuId(uuId):
     return '%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x' % tuple(uuId)
 
@@ -591,6 +711,78 @@ def getNumSteps(hand):
 
     return numStepsHand
 
+def computeStepDivisor(numer, denom, limit):
+    """ Returns (m, s), the multiplier and shift such that (x * m) >>
+    s == (x * numer) / denom, exactly, for every integer 0 <= x <
+    limit, with m no larger than 32 bits.  This lets the watch compute
+    each hand index with a single 32 x 32 -> 64-bit multiply instead
+    of a division.  The fraction is reduced first, since a smaller
+    denom needs a smaller m for the same precision.
+
+    With m = ceil((numer << s) / denom), x * m / (1 << s) exceeds x *
+    numer / denom by x * e / (denom << s), where e = m * denom -
+    (numer << s); and x * numer / denom falls at least 1 / denom
+    short of the next integer.  So the quotient is exact as long as
+    (limit - 1) * e < (1 << s). """
+
+    g = gcd(numer, denom)
+    numer, denom = numer / g, denom / g
+
+    for s in range(64):
+        m = -(-(numer << s) // denom)
+        if m >= (1 << 32):
+            break
+        e = m * denom - (numer << s)
+        if (limit - 1) * e < (1 << s):
+            return m, s
+
+    print >> sys.stderr, "No 32-bit step divisor for %s / %s over %s." % (numer, denom, limit)
+    sys.exit(1)
+
+def gcd(a, b):
+    while b:
+        a, b = b, a % b
+    return a
+
+def makeStepDivisors():
+    """ Returns the #define lines for the STEP_DIV_* constants, used by
+    the STEP_DIV() macro in wright.h, for the current step counts. """
+
+    msPerHour = 3600 * 1000
+
+    # Each entry is the name, numerator, and denominator of a division
+    # done in compute_hands() or compute_chrono_hands(), along with
+    # the upper bound (exclusive) on the value it is applied to.
+    divisors = [
+        ('HOUR_HAND', getNumSteps('hour'), 12 * msPerHour, 12 * msPerHour),
+        ('MINUTE_HAND', getNumSteps('minute'), msPerHour, msPerHour),
+        ('SECOND_HAND', getNumSteps('second'), 60 * 1000, 60 * 1000),
+        ('MOON', getNumSteps('moon'), 2551443, 2551443),
+        ('CHRONO_MINUTE_HAND', getNumSteps('chrono_minute'), 1800 * 1000, 1800 * 1000),
+        ('CHRONO_SECOND_HAND', getNumSteps('chrono_second'), 60 * 1000, 60 * 1000),
+        ('CHRONO_TENTH_HAND', getNumSteps('chrono_tenth'), 1000, 1000),
+        ('CHRONO_HOURS_HAND', getNumSteps('chrono_tenth'), 12 * msPerHour, 12 * msPerHour),
+
+        # The ms of the day may run one second over, on a leap second.
+        ('MS_HOURS', 1, msPerHour, 24 * msPerHour + 1000),
+        ('MS_HALF_HOURS', 1, 1800 * 1000, 12 * msPerHour),
+        ('MS_MINUTES', 1, 60 * 1000, msPerHour),
+        ('MS_SECONDS', 1, 1000, 60 * 1000),
+        ('LUNAR_CYCLES', 1, 2551443, 1 << 32),
+        ]
+
+    lines = []
+    for name, numer, denom, limit in divisors:
+        m, s = computeStepDivisor(numer, denom, limit)
+        lines.append('#define STEP_DIV_%s_M %su' % (name, m))
+        lines.append('#define STEP_DIV_%s_S %s' % (name, s))
+
+    # Also list them all, for the host check in check_watch.py.
+    entries = ['  X(%s, %s, %s, %sull)' % (name, numer, denom, limit) for name, numer, denom, limit in divisors]
+    lines.append('#define STEP_DIV_LIST(X) \\\n' + ' \\\n'.join(entries))
+
+    return '\n'.join(lines)
+
 def getResourceCacheSize(hand):
     return resourceCacheSize.get(hand, [0, 0])[0]
 
@@ -622,67 +814,21 @@ def makeBitmapHands(generatedTable, generatedDefs, useRle, hand, sourceBasename,
 
     return resourceStr
 
-def makeBitmapHandsAplite(generatedTable, useRle, hand, sourceBasename, colorMode, asymmetric, pivot, scale):
-    resourceStr = ''
-    maskResourceStr = ''
-
-    resourceEntry = """
-    {
-      "name": "%(defName)s",
-      "file": "%(targetFilename)s",
-      "type": "%(ptype)s"
-    },"""
-
-    handLookupEntry = """  { %(cx)s, %(cy)s },  // %(symbolName)s"""
-    handTableEntry = """  { %(lookup_index)s, %(flip_x)s, %(flip_y)s },"""
-
-    handLookupLines = {}
-    maxLookupIndex = -1
-    handTableLines = []
-
-    paintChannel, useTransparency, dither = parseColorMode(colorMode)
-
-    source1Pathname = '%s/clock_hands/%s~bw.png' % (resourcesDir, sourceBasename)
-    if os.path.exists(source1Pathname):
-        # If there's an explicit ~bw source file, use it for the 1-bit
-        # version.
-        source1 = PIL.Image.open(source1Pathname)
-    else:
-        # Otherwise, use the original for the 1-bit version.
-        sourcePathname = '%s/clock_hands/%s.png' % (resourcesDir, sourceBasename)
-        source1 = PIL.Image.open(sourcePathname)
-
-    r, g, b, source1Mask = source1.convert('RGBA').split()
-    source1 = PIL.Image.merge('RGB', [r, g, b])
-
-    # Ensure that the source image is black anywhere its alpha channel
-    # is black.
-    black = PIL.Image.new('L', source1.size, 0)
-    r, g, b = source1.split()
-    mask = source1Mask.point(thresholdMask)
-    r = PIL.Image.composite(r, black, mask)
-    g = PIL.Image.composite(g, black, mask)
-    b = PIL.Image.composite(b, black, mask)
-    source1 = PIL.Image.merge('RGB', [r, g, b])
-
-    # In the aplite case, we don't need to make a distinction between
-    # the explicit and implicit masks.  An explicit mask completely
-    # replaces the implicit mask.
-    source1MaskPathname = '%s/clock_hands/%s_mask~bw.png' % (resourcesDir, sourceBasename)
-    if os.path.exists(source1MaskPathname):
-        source1Mask = PIL.Image.open(source1MaskPathname).convert('L')
-
-    # Center the source image on its pivot, and pad it with black.
-    border = (pivot[0], pivot[1], source1.size[0] - pivot[0], source1.size[1] - pivot[1])
-    size = (max(border[0], border[2]) * 2, max(border[1], border[3]) * 2)
-    center = (size[0] / 2, size[1] / 2)
-    large1 = PIL.Image.new('RGB', size, 0)
-    large1.paste(source1, (center[0] - pivot[0], center[1] - pivot[1]))
-
-    large1Mask = PIL.Image.new('L', size, 0)
-    large1Mask.paste(source1Mask, (center[0] - pivot[0], center[1] - pivot[1]))
-
-    numStepsHand = getNumSteps(hand)
+def planHandBitmaps(numStepsHand, asymmetric, runtime = False):
+    """ Works out which rotation of the source image each step of a
+    bitmap hand is drawn from, and how that rotation is flipped into
+    place.  Returns (rows, rotations), where rows is a list of (i,
+    flip_x, flip_y), one for each step, and rotations is the list of
+    distinct rotations i that must be generated, in the order they are
+    first needed.  If runtime is true, the watch rotates the hand
+    itself (see -r), so there are no rows, and the only rotation is
+    the master bitmap at 12:00. """
+
+    if runtime:
+        return [], [0]
+
+    rows = []
+    rotations = []
     for i in range(numStepsHand):
         flip_x = False
         flip_y = False
@@ -702,7 +848,6 @@ def makeBitmapHandsAplite(generatedTable, useRle, hand, sourceBasename, colorMod
                 # If we're outside of the first quadrant, maybe we can
                 # just flip a first-quadrant hand into the appropriate
                 # quadrant, and save a bit of resource memory.
-                i2 = i
                 if angle > 180:
                     # If we're in the right half of the circle, flip
                     # over from the left.
@@ -728,122 +873,87 @@ def makeBitmapHandsAplite(generatedTable, useRle, hand, sourceBasename, colorMod
                 flip_y = True
                 angle = i * 360.0 / numStepsHand
 
-        symbolName = '%s_%s' % (hand.upper(), i)
-        symbolMaskName = symbolName
-        if useTransparency:
-            symbolMaskName = '%s_%s_MASK' % (hand.upper(), i)
-
-        if i not in handLookupLines:
-            # Here we have a new rotation of the bitmap image to
-            # generate.  We might have decided to flip this image from
-            # another image i, but we still need to scale and rotate
-            # the source image now, if for no other reason than to
-            # compute cx, cy.
-
+        if i not in rotations:
             # We expect to encounter each i the first time in an
             # unflipped state, because we visit quadrant I first.
             assert not flip_x and not flip_y
+            rotations.append(i)
+        rows.append((i, flip_x, flip_y))
+
+    return rows, rotations
+
+def mapRotations(func, rotations):
+    """ Calls func(i) for each of the indicated rotations, and returns
+    the list of results, in the same order.  The rotations are
+    independent of each other, so they are farmed out to a pool of
+    numJobs processes.  The pool is forked afresh for each call, so
+    func can find its inputs in handWork. """
+
+    if numJobs <= 1 or len(rotations) <= 1:
+        return map(func, rotations)
+
+    pool = multiprocessing.Pool(min(numJobs, len(rotations)))
+    try:
+        return pool.map(func, rotations, 1)
+    finally:
+        pool.close()
+        pool.join()
+
+def writeHandTables(generatedTable, hand, rows, rotations, results, useTransparency, useMask, palette = None, maskPalette = None):
+    """ Writes the lookup and step tables for a bitmap hand, given the
+    plan from planHandBitmaps() and the (cx, cy) of each rotation, and
+    the shared palettes of its bitmaps and masks, if any.  useMask is
+    true if the watch must draw the masks on this platform, rather
+    than merely keep their resources in step with the other
+    platforms.  Returns the resource entries for the rotations and
+    their masks. """
 
-            p1 = large1.rotate(-angle, PIL.Image.BICUBIC, True)
-            scaledSize = (int(p1.size[0] * scale + 0.5), int(p1.size[1] * scale + 0.5))
-            p1 = p1.resize(scaledSize, PIL.Image.ANTIALIAS)
-
-            # Now make the 1-bit version for Aplite.
-            r, g, b = p1.split()
-            if not dither:
-                p1 = b.point(threshold1Bit).convert('1')
-            else:
-                p1 = b.convert('1')
-
-            cx, cy = p1.size[0] / 2, p1.size[1] / 2
-            cropbox = p1.getbbox()
+    resourceEntry = """
+    {
+      "name": "%(defName)s",
+      "file": "%(targetFilename)s",
+      "type": "%(ptype)s"
+    },"""
 
-            # Mask.
-            pm1 = large1Mask.rotate(-angle, PIL.Image.BICUBIC, True)
-            pm1 = pm1.resize(scaledSize, PIL.Image.ANTIALIAS)
+    handLookupEntry = """  { %(cx)s, %(cy)s },  // %(symbolName)s"""
+    handTableEntry = """  { %(lookup_index)s, %(flip_x)s, %(flip_y)s },"""
 
-            # And the 1-bit version of the mask.
-            if not dither or useTransparency:
-                pm1 = pm1.point(threshold1Bit).convert('1')
-            else:
-                pm1 = pm1.convert('1')
-
-            # It's important to take the crop from the alpha mask, not
-            # from the color.
-            cropbox = pm1.getbbox()
-            p1 = p1.crop(cropbox)
-            pm1 = pm1.crop(cropbox)
-
-            cx, cy = cx - cropbox[0], cy - cropbox[1]
-
-            # Now that we have scaled and rotated image i, write it
-            # out.
-
-            # We require our images to be an even multiple of 8 pixels
-            # wide, to make it easier to reverse the bits
-            # horizontally.  (Actually we only need it to be an even
-            # multiple of bytes, but the Aplite build is the lowest
-            # common denominator with 8 pixels per byte.)
-            w = 8 * ((p1.size[0] + 7) / 8)
-            if w != p1.size[0]:
-                pt = PIL.Image.new('1', (w, p1.size[1]), 0)
-                pt.paste(p1, (0, 0))
-                p1 = pt
-
-                pt = PIL.Image.new('1', (w, pm1.size[1]), 0)
-                pt.paste(pm1, (0, 0))
-                pm1 = pt
-
-            if not useTransparency:
-                # In the non-transparency case, the aplite mask is the
-                # aplite image we actually write out.
-                p1 = pm1
-            else:
-                # In the transparency case, we need to write the mask
-                # image separately.
-                targetMaskBasename = 'build/flat_%s_%s_%s_mask' % (handStyle, hand, i)
-
-                # Save the aplite mask.
-                pm1.save('%s/%s~bw.png' % (resourcesDir, targetMaskBasename))
-
-                rleFilename, ptype = make_rle(targetMaskBasename + '.png', useRle = useRle, modes = ['~bw'])
-                maskResourceStr += resourceEntry % {
-                    'defName' : symbolMaskName,
-                    'targetFilename' : rleFilename,
-                    'ptype' : ptype,
-                    }
-
-            targetBasename = 'build/flat_%s_%s_%s' % (handStyle, hand, i)
-            p1.save('%s/%s~bw.png' % (resourcesDir, targetBasename))
-            rleFilename, ptype = make_rle(targetBasename + '.png', useRle = useRle, modes = ['~bw'])
-
-            resourceStr += resourceEntry % {
-                'defName' : symbolName,
-                'targetFilename' : rleFilename,
-                'ptype' : ptype,
+    resourceStr = ''
+    maskResourceStr = ''
+    handLookupLines = {}
+    for i, (cx, cy, rleFilename, ptype, maskRleFilename, maskPtype) in zip(rotations, results):
+        symbolName = '%s_%s' % (hand.upper(), i)
+        if maskRleFilename:
+            symbolMaskName = '%s_%s_MASK' % (hand.upper(), i)
+            maskResourceStr += resourceEntry % {
+                'defName' : symbolMaskName,
+                'targetFilename' : maskRleFilename,
+                'ptype' : maskPtype,
                 }
 
-            line = handLookupEntry % {
-                'symbolName' : symbolName,
-                'cx' : cx,
-                'cy' : cy,
-                }
-            handLookupLines[i] = line
-            maxLookupIndex = max(maxLookupIndex, i)
+        resourceStr += resourceEntry % {
+            'defName' : symbolName,
+            'targetFilename' : rleFilename,
+            'ptype' : ptype,
+            }
 
-        line = handTableEntry % {
-            'lookup_index' : i,
-            'flip_x' : int(flip_x),
-            'flip_y' : int(flip_y),
+        handLookupLines[i] = handLookupEntry % {
+            'symbolName' : symbolName,
+            'cx' : cx,
+            'cy' : cy,
             }
-        handTableLines.append(line)
 
-    numBitmaps = maxLookupIndex + 1
+    numBitmaps = max(rotations) + 1
     if useTransparency:
         numMaskBitmaps = numBitmaps
     else:
         numMaskBitmaps = 0
-    resourceCacheSize[hand] = numBitmaps, numMaskBitmaps
+    if not rows:
+        # A hand rotated at runtime keeps its master bitmap for itself,
+        # so there's nothing to cache.
+        resourceCacheSize[hand] = 0, 0
+    else:
+        resourceCacheSize[hand] = numBitmaps, numMaskBitmaps
     
     print >> generatedTable, "struct BitmapHandCenterRow %s_hand_bitmap_lookup[] = {" % (hand)
     for i in range(numBitmaps):
@@ -851,31 +961,252 @@ def makeBitmapHandsAplite(generatedTable, useRle, hand, sourceBasename, colorMod
         print >> generatedTable, line
     print >> generatedTable, "};\n"
 
-    print >> generatedTable, "struct BitmapHandTableRow %s_hand_bitmap_table[NUM_STEPS_%s] = {" % (hand, hand.upper())
-    for line in handTableLines:
-        print >> generatedTable, line
-    print >> generatedTable, "};\n"
+    if rows:
+        print >> generatedTable, "struct BitmapHandTableRow %s_hand_bitmap_table[NUM_STEPS_%s] = {" % (hand, hand.upper())
+        for i, flip_x, flip_y in rows:
+            line = handTableEntry % {
+                'lookup_index' : i,
+                'flip_x' : int(flip_x),
+                'flip_y' : int(flip_y),
+                }
+            print >> generatedTable, line
+        print >> generatedTable, "};\n"
+
+    # The shared palettes, which the HandDef picks up through the
+    # HAND_PALETTE and HAND_MASK_PALETTE symbols.
+    for suffix, p in [('palette', palette), ('mask_palette', maskPalette)]:
+        symbolName = '%s_HAND_%s' % (hand.upper(), suffix.upper())
+        if p is None:
+            print >> generatedTable, "#define %s NULL, 0\n" % (symbolName)
+        else:
+            print >> generatedTable, "uint8_t %s_hand_%s[] = { %s };" % (hand, suffix, ', '.join(['0x%02x' % (v) for v in p]))
+            print >> generatedTable, "#define %s %s_hand_%s, %s\n" % (symbolName, hand, suffix, len(p))
+
+    print >> generatedTable, "#define %s_HAND_USE_MASK %s\n" % (hand.upper(), int(bool(useMask)))
 
     return resourceStr + maskResourceStr
 
-def makeBitmapHandsColor(generatedTable, useRle, hand, sourceBasename, colorMode, asymmetric, pivot, scale, mode):
-    resourceStr = ''
-    maskResourceStr = ''
+def makeBitmapHandsAplite(generatedTable, useRle, hand, sourceBasename, colorMode, asymmetric, pivot, scale):
+    paintChannel, useTransparency, dither = parseColorMode(colorMode)
 
-    resourceEntry = """
-    {
-      "name": "%(defName)s",
-      "file": "%(targetFilename)s",
-      "type": "%(ptype)s"
-    },"""
+    source1Pathname = '%s/clock_hands/%s~bw.png' % (resourcesDir, sourceBasename)
+    if os.path.exists(source1Pathname):
+        # If there's an explicit ~bw source file, use it for the 1-bit
+        # version.
+        source1 = PIL.Image.open(source1Pathname)
+    else:
+        # Otherwise, use the original for the 1-bit version.
+        sourcePathname = '%s/clock_hands/%s.png' % (resourcesDir, sourceBasename)
+        source1 = PIL.Image.open(sourcePathname)
 
-    handLookupEntry = """  { %(cx)s, %(cy)s },  // %(symbolName)s"""
-    handTableEntry = """  { %(lookup_index)s, %(flip_x)s, %(flip_y)s },"""
+    r, g, b, source1Mask = source1.convert('RGBA').split()
+    source1 = PIL.Image.merge('RGB', [r, g, b])
 
-    handLookupLines = {}
-    maxLookupIndex = -1
-    handTableLines = []
+    # Ensure that the source image is black anywhere its alpha channel
+    # is black.
+    black = PIL.Image.new('L', source1.size, 0)
+    r, g, b = source1.split()
+    mask = source1Mask.point(thresholdMask)
+    r = PIL.Image.composite(r, black, mask)
+    g = PIL.Image.composite(g, black, mask)
+    b = PIL.Image.composite(b, black, mask)
+    source1 = PIL.Image.merge('RGB', [r, g, b])
+
+    # In the aplite case, we don't need to make a distinction between
+    # the explicit and implicit masks.  An explicit mask completely
+    # replaces the implicit mask.
+    source1MaskPathname = '%s/clock_hands/%s_mask~bw.png' % (resourcesDir, sourceBasename)
+    if os.path.exists(source1MaskPathname):
+        source1Mask = PIL.Image.open(source1MaskPathname).convert('L')
+
+    # Center the source image on its pivot, and pad it with black.
+    border = (pivot[0], pivot[1], source1.size[0] - pivot[0], source1.size[1] - pivot[1])
+    size = (max(border[0], border[2]) * 2, max(border[1], border[3]) * 2)
+    center = (size[0] / 2, size[1] / 2)
+    large1 = PIL.Image.new('RGB', size, 0)
+    large1.paste(source1, (center[0] - pivot[0], center[1] - pivot[1]))
+
+    large1Mask = PIL.Image.new('L', size, 0)
+    large1Mask.paste(source1Mask, (center[0] - pivot[0], center[1] - pivot[1]))
+
+    numStepsHand = getNumSteps(hand)
+    rows, rotations = planHandBitmaps(numStepsHand, asymmetric, hand in runtimeHands)
+
+    handWork.clear()
+    handWork.update({
+        'hand' : hand,
+        'numStepsHand' : numStepsHand,
+        'useRle' : useRle,
+        'useTransparency' : useTransparency,
+        'dither' : dither,
+        'scale' : scale,
+        'mode' : '~bw',
+        'large1' : large1,
+        'large1Mask' : large1Mask,
+        'render' : makeBitmapHandAplite,
+        'inputs' : ('aplite', asset_cache.image_digest(large1), asset_cache.image_digest(large1Mask), scale, dither, useTransparency, numStepsHand, handStyle, hand),
+        })
+    results, palette, maskPalette = makeBitmapHandRotations(rotations, False)
+
+    return writeHandTables(generatedTable, hand, rows, rotations, results, useTransparency, useTransparency)
+
+def makeBitmapHandRotations(rotations, sharePalettes):
+    """ Renders and encodes the indicated rotations of the hand in
+    handWork.  If sharePalettes is true, the rotations (and, as a
+    separate set, their masks) are encoded with a shared palette
+    where possible.  Returns (results, palette, maskPalette), where
+    results is the list of (cx, cy, rleFilename, ptype,
+    maskRleFilename, maskPtype) for each rotation, and the palettes
+    are as returned by shared_palette(). """
+
+    centers = mapRotations(makeCachedBitmapHand, rotations)
+
+    # The shared palettes must be worked out from all of the rendered
+    # rotations before any of them can be encoded.
+    palette, maskPalette = None, None
+    if sharePalettes and handWork['useRle']:
+        mode = handWork['mode']
+        targetBasenames = map(getHandBasenames, rotations)
+        palette = rle_encoder.shared_palette([PIL.Image.open('%s/%s%s.png' % (resourcesDir, targetBasename, mode)) for targetBasename, targetMaskBasename in targetBasenames])
+        if handWork['useTransparency']:
+            maskPalette = rle_encoder.shared_palette([PIL.Image.open('%s/%s%s.png' % (resourcesDir, targetMaskBasename, mode)) for targetBasename, targetMaskBasename in targetBasenames])
+    handWork['palette'] = palette
+    handWork['maskPalette'] = maskPalette
+
+    encodings = mapRotations(encodeBitmapHand, rotations)
+    results = [center + encoding for center, encoding in zip(centers, encodings)]
+    return results, palette, maskPalette
+
+def getHandBasenames(i):
+    """ Returns (targetBasename, targetMaskBasename) for rotation i of
+    the hand in handWork; targetMaskBasename is None if the hand
+    doesn't use transparency. """
+
+    hand = handWork['hand']
+    targetBasename = 'build/flat_%s_%s_%s' % (handStyle, hand, i)
+    targetMaskBasename = None
+    if handWork['useTransparency']:
+        targetMaskBasename = 'build/flat_%s_%s_%s_mask' % (handStyle, hand, i)
+    return targetBasename, targetMaskBasename
+
+def makeCachedBitmapHand(i):
+    """ Restores the png files for rotation i of the hand in handWork
+    from the asset cache, if they're there; otherwise renders them
+    with handWork['render'] and adds them to the cache.  Returns (cx,
+    cy).  This runs in a worker process. """
+
+    mode = handWork['mode']
+    targetBasename, targetMaskBasename = getHandBasenames(i)
+
+    filenames = []
+    for basename in [targetBasename, targetMaskBasename]:
+        if basename:
+            filenames.append('%s/%s%s.png' % (resourcesDir, basename, mode))
+
+    inputs = handWork['inputs'] + (i,)
+    result = asset_cache.fetch('hand', inputs, filenames)
+    if result is None:
+        result = handWork['render'](i)
+        asset_cache.store('hand', inputs, filenames, result)
+    return result
+
+def encodeBitmapHand(i):
+    """ Encodes the png files for rotation i of the hand in handWork,
+    with the shared palettes in handWork, if any (the encoding has its
+    own cache).  Returns (rleFilename, ptype, maskRleFilename,
+    maskPtype).  This runs in a worker process. """
+
+    mode = handWork['mode']
+    targetBasename, targetMaskBasename = getHandBasenames(i)
+
+    maskRleFilename, maskPtype = None, None
+    if targetMaskBasename:
+        maskRleFilename, maskPtype = make_rle(targetMaskBasename + '.png', useRle = handWork['useRle'], modes = [mode], palette = handWork['maskPalette'])
+    rleFilename, ptype = make_rle(targetBasename + '.png', useRle = handWork['useRle'], modes = [mode], palette = handWork['palette'])
+
+    return rleFilename, ptype, maskRleFilename, maskPtype
+
+def makeBitmapHandAplite(i):
+    """ Scales and rotates the Aplite hand in handWork to rotation i,
+    and writes out its png (and its mask, if it uses transparency).
+    Returns (cx, cy).  This runs in a worker process. """
+
+    hand = handWork['hand']
+    useTransparency = handWork['useTransparency']
+    dither = handWork['dither']
+    scale = handWork['scale']
+    large1 = handWork['large1']
+    large1Mask = handWork['large1Mask']
+    angle = i * 360.0 / handWork['numStepsHand']
+
+    p1 = large1.rotate(-angle, PIL.Image.BICUBIC, True)
+    scaledSize = (int(p1.size[0] * scale + 0.5), int(p1.size[1] * scale + 0.5))
+    p1 = p1.resize(scaledSize, PIL.Image.ANTIALIAS)
+
+    # Now make the 1-bit version for Aplite.
+    r, g, b = p1.split()
+    if not dither:
+        p1 = b.point(threshold1Bit).convert('1')
+    else:
+        p1 = b.convert('1')
+
+    cx, cy = p1.size[0] / 2, p1.size[1] / 2
+    cropbox = p1.getbbox()
+
+    # Mask.
+    pm1 = large1Mask.rotate(-angle, PIL.Image.BICUBIC, True)
+    pm1 = pm1.resize(scaledSize, PIL.Image.ANTIALIAS)
 
+    # And the 1-bit version of the mask.
+    if not dither or useTransparency:
+        pm1 = pm1.point(threshold1Bit).convert('1')
+    else:
+        pm1 = pm1.convert('1')
+
+    # It's important to take the crop from the alpha mask, not
+    # from the color.
+    cropbox = pm1.getbbox()
+    p1 = p1.crop(cropbox)
+    pm1 = pm1.crop(cropbox)
+
+    cx, cy = cx - cropbox[0], cy - cropbox[1]
+
+    # Now that we have scaled and rotated image i, write it
+    # out.
+
+    # We require our images to be an even multiple of 8 pixels
+    # wide, to make it easier to reverse the bits
+    # horizontally.  (Actually we only need it to be an even
+    # multiple of bytes, but the Aplite build is the lowest
+    # common denominator with 8 pixels per byte.)
+    w = 8 * ((p1.size[0] + 7) / 8)
+    if w != p1.size[0]:
+        pt = PIL.Image.new('1', (w, p1.size[1]), 0)
+        pt.paste(p1, (0, 0))
+        p1 = pt
+
+        pt = PIL.Image.new('1', (w, pm1.size[1]), 0)
+        pt.paste(pm1, (0, 0))
+        pm1 = pt
+
+    if not useTransparency:
+        # In the non-transparency case, the aplite mask is the
+        # aplite image we actually write out.
+        p1 = pm1
+    else:
+        # In the transparency case, we need to write the mask
+        # image separately.
+        targetMaskBasename = 'build/flat_%s_%s_%s_mask' % (handStyle, hand, i)
+
+        # Save the aplite mask.
+        pm1.save('%s/%s~bw.png' % (resourcesDir, targetMaskBasename))
+
+    targetBasename = 'build/flat_%s_%s_%s' % (handStyle, hand, i)
+    p1.save('%s/%s~bw.png' % (resourcesDir, targetBasename))
+
+    return cx, cy
+
+def makeBitmapHandsColor(generatedTable, useRle, hand, sourceBasename, colorMode, asymmetric, pivot, scale, mode):
     paintChannel, useTransparency, dither = parseColorMode(colorMode)
 
     sourcePathname = '%s/clock_hands/%s.png' % (resourcesDir, sourceBasename)
@@ -912,216 +1243,153 @@ def makeBitmapHandsColor(generatedTable, useRle, hand, sourceBasename, colorMode
     largeMask = PIL.Image.new('L', size, 0)
     largeMask.paste(sourceMask, (center[0] - pivot[0], center[1] - pivot[1]))
 
+    largeMaskExplicit = None
     if sourceMaskExplicit:
         largeMaskExplicit = PIL.Image.new('RGBA', size, (0, 0, 0, 0))
         largeMaskExplicit.paste(sourceMaskExplicit, (center[0] - pivot[0], center[1] - pivot[1]))
 
     numStepsHand = getNumSteps(hand)
-    for i in range(numStepsHand):
-        flip_x = False
-        flip_y = False
-        angle = i * 360.0 / numStepsHand
+    rows, rotations = planHandBitmaps(numStepsHand, asymmetric, hand in runtimeHands)
+
+    handWork.clear()
+    handWork.update({
+        'hand' : hand,
+        'numStepsHand' : numStepsHand,
+        'useRle' : useRle,
+        'useTransparency' : useTransparency,
+        'paintChannel' : paintChannel,
+        'scale' : scale,
+        'mode' : mode,
+        'large' : large,
+        'largeMask' : largeMask,
+        'sourceMaskExplicit' : sourceMaskExplicit,
+        'largeMaskExplicit' : largeMaskExplicit,
+        'render' : makeBitmapHandColor,
+        'inputs' : ('color', mode, asset_cache.image_digest(large), asset_cache.image_digest(largeMask), largeMaskExplicit and asset_cache.image_digest(largeMaskExplicit), paintChannel, scale, useTransparency, numStepsHand, handStyle, hand),
+        })
+    results, palette, maskPalette = makeBitmapHandRotations(rotations, sharePalettes)
+
+    # Without an explicit mask, the color masks are only the trivial
+    # placeholders written by makeBitmapHandColor(), and the watch
+    # needn't ever load them.
+    useMask = useTransparency and sourceMaskExplicit is not None
+
+    return writeHandTables(generatedTable, hand, rows, rotations, results, useTransparency, useMask, palette, maskPalette)
+
+def makeBitmapHandColor(i):
+    """ Scales and rotates the Basalt/Chalk hand in handWork to
+    rotation i, and writes out its png (and its mask, if it uses
+    transparency).  Returns (cx, cy).  This runs in a worker
+    process. """
+
+    hand = handWork['hand']
+    useTransparency = handWork['useTransparency']
+    paintChannel = handWork['paintChannel']
+    scale = handWork['scale']
+    mode = handWork['mode']
+    large = handWork['large']
+    largeMask = handWork['largeMask']
+    sourceMaskExplicit = handWork['sourceMaskExplicit']
+    largeMaskExplicit = handWork['largeMaskExplicit']
+    angle = i * 360.0 / handWork['numStepsHand']
+
+    p = large.rotate(-angle, PIL.Image.BICUBIC, True)
+    scaledSize = (int(p.size[0] * scale + 0.5), int(p.size[1] * scale + 0.5))
+    p = p.resize(scaledSize, PIL.Image.ANTIALIAS)
+
+    # Now make the 2-bit version for Basalt and Chalk.
+    r, g, b = p.split()
+    r = r.point(threshold2Bit).convert('L')
+    g = g.point(threshold2Bit).convert('L')
+    b = b.point(threshold2Bit).convert('L')
+    p2 = PIL.Image.merge('RGB', [r, g, b])
+
+    cx, cy = p2.size[0] / 2, p2.size[1] / 2
+    cropbox = p2.getbbox()
+
+    # Mask.
+    pm = largeMask.rotate(-angle, PIL.Image.BICUBIC, True)
+    pm = pm.resize(scaledSize, PIL.Image.ANTIALIAS)
+
+    # And the 2-bit version of the mask.
+    pm2 = pm.point(threshold2Bit).convert('L')
+
+    # It's important to take the crop from the alpha mask, not
+    # from the color.
+    cropbox = pm2.getbbox()
+    p2 = p2.crop(cropbox)
+    pm2 = pm2.crop(cropbox)
 
-        # Check for quadrant symmetry, an easy resource-memory
-        # optimization.  Instead of generating bitmaps for all 360
-        # degrees of the hand, we may be able to generate the
-        # first quadrant only (or the first half only) and quickly
-        # flip it into the remaining quadrants.
-        if not asymmetric:
-            # If the hand is symmetric, we can treat the x and y
-            # flips independently, and this means we really only
-            # need a single quadrant.
-
-            if angle > 90:
-                # If we're outside of the first quadrant, maybe we can
-                # just flip a first-quadrant hand into the appropriate
-                # quadrant, and save a bit of resource memory.
-                i2 = i
-                if angle > 180:
-                    # If we're in the right half of the circle, flip
-                    # over from the left.
-                    i = (numStepsHand - i)
-                    flip_x = True
-                    angle = i * 360.0 / numStepsHand
-
-                if angle > 90 and angle < 270:
-                    # If we're in the bottom half of the circle, flip
-                    # over from the top.
-                    i = (numStepsHand / 2 - i) % numStepsHand
-                    flip_y = True
-                    angle = i * 360.0 / numStepsHand
-        else:
-            # If the hand is asymmetric, then it's important not
-            # to flip it an odd number of times.  But we can still
-            # apply both flips at once (which is really a
-            # 180-degree rotation), and this means we only need to
-            # generate the right half, and rotate into the left.
-            if angle >= 180:
-                i -= (numStepsHand / 2)
-                flip_x = True
-                flip_y = True
-                angle = i * 360.0 / numStepsHand
-
-        symbolName = '%s_%s' % (hand.upper(), i)
-        symbolMaskName = symbolName
-        if useTransparency:
-            symbolMaskName = '%s_%s_MASK' % (hand.upper(), i)
-
-        if i not in handLookupLines:
-            # Here we have a new rotation of the bitmap image to
-            # generate.  We might have decided to flip this image from
-            # another image i, but we still need to scale and rotate
-            # the source image now, if for no other reason than to
-            # compute cx, cy.
-
-            # We expect to encounter each i the first time in an
-            # unflipped state, because we visit quadrant I first.
-            assert not flip_x and not flip_y
-
-            p = large.rotate(-angle, PIL.Image.BICUBIC, True)
-            scaledSize = (int(p.size[0] * scale + 0.5), int(p.size[1] * scale + 0.5))
-            p = p.resize(scaledSize, PIL.Image.ANTIALIAS)
-
-            # Now make the 2-bit version for Basalt and Chalk.
-            r, g, b = p.split()
-            r = r.point(threshold2Bit).convert('L')
-            g = g.point(threshold2Bit).convert('L')
-            b = b.point(threshold2Bit).convert('L')
-            p2 = PIL.Image.merge('RGB', [r, g, b])
-
-            cx, cy = p2.size[0] / 2, p2.size[1] / 2
-            cropbox = p2.getbbox()
-
-            # Mask.
-            pm = largeMask.rotate(-angle, PIL.Image.BICUBIC, True)
-            pm = pm.resize(scaledSize, PIL.Image.ANTIALIAS)
-
-            # And the 2-bit version of the mask.
-            pm2 = pm.point(threshold2Bit).convert('L')
-
-            # It's important to take the crop from the alpha mask, not
-            # from the color.
-            cropbox = pm2.getbbox()
-            p2 = p2.crop(cropbox)
-            pm2 = pm2.crop(cropbox)
-
-            if sourceMaskExplicit:
-                pme = largeMaskExplicit.rotate(-angle, PIL.Image.BICUBIC, True)
-                pme = pme.resize(scaledSize, PIL.Image.ANTIALIAS)
-                r, g, b, a = pme.split()
-                r = r.point(threshold2Bit).convert('L')
-                g = g.point(threshold2Bit).convert('L')
-                b = b.point(threshold2Bit).convert('L')
-                a = a.point(threshold2Bit).convert('L')
-                pme2 = PIL.Image.merge('RGBA', [r, g, b, a])
-                pme2 = pme2.crop(cropbox)
-
-            if not useTransparency:
-                # Force the foreground pixels to the appropriate color
-                if paintChannel == 1:
-                    p2 = PIL.Image.new('RGB', p2.size, (255, 0, 0))
-                elif paintChannel == 2:
-                    p2 = PIL.Image.new('RGB', p2.size, (0, 255, 0))
-                elif paintChannel == 3:
-                    p2 = PIL.Image.new('RGB', p2.size, (0, 0, 255))
-
-            cx, cy = cx - cropbox[0], cy - cropbox[1]
-
-            # Now that we have scaled and rotated image i, write it
-            # out.
-
-            # We require our images to be an even multiple of 8 pixels
-            # wide, to make it easier to reverse the bits
-            # horizontally.  (Actually we only need it to be an even
-            # multiple of bytes, but the Aplite build is the lowest
-            # common denominator with 8 pixels per byte.)
-            w = 8 * ((p2.size[0] + 7) / 8)
-            if w != p2.size[0]:
-                pt = PIL.Image.new('RGB', (w, p2.size[1]), 0)
-                pt.paste(p2, (0, 0))
-                p2 = pt
-
-                pt = PIL.Image.new('L', (w, pm2.size[1]), 0)
-                pt.paste(pm2, (0, 0))
-                pm2 = pt
-                if sourceMaskExplicit:
-                    pt = PIL.Image.new('RGBA', (w, pme2.size[1]), (0, 0, 0, 0))
-                    pt.paste(pme2, (0, 0))
-                    pme2 = pt
-
-            # Apply the mask as the alpha channel.
-            r, g, b = p2.split()
-            p2 = PIL.Image.merge('RGBA', [r, g, b, pm2])
-
-            # And quantize to 16 colors, which looks almost as good
-            # for half the RAM.
-            p2 = p2.convert("P", palette = PIL.Image.ADAPTIVE, colors = 16)
-
-            if useTransparency:
-                # In the transparency case, we need to write the mask
-                # image separately.
-                targetMaskBasename = 'build/flat_%s_%s_%s_mask' % (handStyle, hand, i)
-                if sourceMaskExplicit:
-                    # An explicit color mask.
-                    pme2 = pme2.convert("P", palette = PIL.Image.ADAPTIVE, colors = 16)
-                    pme2.save('%s/%s%s.png' % (resourcesDir, targetMaskBasename, mode))
-                else:
-                    # With only an implicit color mask, we won't be
-                    # using the mask image in color, so save a
-                    # trivial image.
-                    trivialImage.save('%s/%s%s.png' % (resourcesDir, targetMaskBasename, mode))
-
-                rleFilename, ptype = make_rle(targetMaskBasename + '.png', useRle = useRle, modes = [mode])
-                maskResourceStr += resourceEntry % {
-                    'defName' : symbolMaskName,
-                    'targetFilename' : rleFilename,
-                    'ptype' : ptype,
-                    }
-
-            targetBasename = 'build/flat_%s_%s_%s' % (handStyle, hand, i)
-            p2.save('%s/%s%s.png' % (resourcesDir, targetBasename, mode))
-            rleFilename, ptype = make_rle(targetBasename + '.png', useRle = useRle, modes = [mode])
-
-            resourceStr += resourceEntry % {
-                'defName' : symbolName,
-                'targetFilename' : rleFilename,
-                'ptype' : ptype,
-                }
-
-            line = handLookupEntry % {
-                'symbolName' : symbolName,
-                'cx' : cx,
-                'cy' : cy,
-                }
-            handLookupLines[i] = line
-            maxLookupIndex = max(maxLookupIndex, i)
-
-        line = handTableEntry % {
-            'lookup_index' : i,
-            'flip_x' : int(flip_x),
-            'flip_y' : int(flip_y),
-            }
-        handTableLines.append(line)
+    if sourceMaskExplicit:
+        pme = largeMaskExplicit.rotate(-angle, PIL.Image.BICUBIC, True)
+        pme = pme.resize(scaledSize, PIL.Image.ANTIALIAS)
+        r, g, b, a = pme.split()
+        r = r.point(threshold2Bit).convert('L')
+        g = g.point(threshold2Bit).convert('L')
+        b = b.point(threshold2Bit).convert('L')
+        a = a.point(threshold2Bit).convert('L')
+        pme2 = PIL.Image.merge('RGBA', [r, g, b, a])
+        pme2 = pme2.crop(cropbox)
+
+    if not useTransparency:
+        # Force the foreground pixels to the appropriate color
+        if paintChannel == 1:
+            p2 = PIL.Image.new('RGB', p2.size, (255, 0, 0))
+        elif paintChannel == 2:
+            p2 = PIL.Image.new('RGB', p2.size, (0, 255, 0))
+        elif paintChannel == 3:
+            p2 = PIL.Image.new('RGB', p2.size, (0, 0, 255))
+
+    cx, cy = cx - cropbox[0], cy - cropbox[1]
+
+    # Now that we have scaled and rotated image i, write it
+    # out.
+
+    # We require our images to be an even multiple of 8 pixels
+    # wide, to make it easier to reverse the bits
+    # horizontally.  (Actually we only need it to be an even
+    # multiple of bytes, but the Aplite build is the lowest
+    # common denominator with 8 pixels per byte.)
+    w = 8 * ((p2.size[0] + 7) / 8)
+    if w != p2.size[0]:
+        pt = PIL.Image.new('RGB', (w, p2.size[1]), 0)
+        pt.paste(p2, (0, 0))
+        p2 = pt
+
+        pt = PIL.Image.new('L', (w, pm2.size[1]), 0)
+        pt.paste(pm2, (0, 0))
+        pm2 = pt
+        if sourceMaskExplicit:
+            pt = PIL.Image.new('RGBA', (w, pme2.size[1]), (0, 0, 0, 0))
+            pt.paste(pme2, (0, 0))
+            pme2 = pt
+
+    # Apply the mask as the alpha channel.
+    r, g, b = p2.split()
+    p2 = PIL.Image.merge('RGBA', [r, g, b, pm2])
+
+    # And quantize to 16 colors, which looks almost as good
+    # for half the RAM.
+    p2 = p2.convert("P", palette = PIL.Image.ADAPTIVE, colors = 16)
 
-    numBitmaps = maxLookupIndex + 1
     if useTransparency:
-        numMaskBitmaps = numBitmaps
-    else:
-        numMaskBitmaps = 0
-    resourceCacheSize[hand] = numBitmaps, numMaskBitmaps
-    
-    print >> generatedTable, "struct BitmapHandCenterRow %s_hand_bitmap_lookup[] = {" % (hand)
-    for i in range(numBitmaps):
-        line = handLookupLines.get(i, "  {},");
-        print >> generatedTable, line
-    print >> generatedTable, "};\n"
+        # In the transparency case, we need to write the mask
+        # image separately.
+        targetMaskBasename = 'build/flat_%s_%s_%s_mask' % (handStyle, hand, i)
+        if sourceMaskExplicit:
+            # An explicit color mask.
+            pme2 = pme2.convert("P", palette = PIL.Image.ADAPTIVE, colors = 16)
+            pme2.save('%s/%s%s.png' % (resourcesDir, targetMaskBasename, mode))
+        else:
+            # With only an implicit color mask, we won't be
+            # using the mask image in color, so save a
+            # trivial image.
+            trivialImage.save('%s/%s%s.png' % (resourcesDir, targetMaskBasename, mode))
 
-    print >> generatedTable, "struct BitmapHandTableRow %s_hand_bitmap_table[NUM_STEPS_%s] = {" % (hand, hand.upper())
-    for line in handTableLines:
-        print >> generatedTable, line
-    print >> generatedTable, "};\n"
+    targetBasename = 'build/flat_%s_%s_%s' % (handStyle, hand, i)
+    p2.save('%s/%s%s.png' % (resourcesDir, targetBasename, mode))
 
-    return resourceStr + maskResourceStr
+    return cx, cy
 
 def makeHands(generatedTable, generatedDefs):
     """ Generates the required resources and tables for the indicated
@@ -1137,8 +1405,10 @@ def makeHands(generatedTable, generatedDefs):
     #else
     %(rectPlaceX)s, %(rectPlaceY)s,
     #endif  // PBL_ROUND
-    %(useRle)s,
+    %(useRle)s, %(useMask)s, %(useRotation)s,
     %(bitmapCenters)s,
+    %(palette)s,
+    %(maskPalette)s,
     %(bitmapTable)s,
     %(vectorTable)s,
 };
@@ -1163,8 +1433,12 @@ def makeHands(generatedTable, generatedDefs):
 
         resourceId = '0'
         resourceMaskId = resourceId
+        useMask = '0'
+        useRotation = 0
         paintChannel = 0
         bitmapCenters = 'NULL'
+        palette = 'NULL, 0'
+        maskPalette = 'NULL, 0'
         bitmapTable = 'NULL'
         vectorTable = 'NULL'
 
@@ -1176,8 +1450,14 @@ def makeHands(generatedTable, generatedDefs):
             resourceMaskId = resourceId
             if useTransparency:
                 resourceMaskId = 'RESOURCE_ID_%s_0_MASK' % (hand.upper())
+            useMask = '%s_HAND_USE_MASK' % (hand.upper())
             bitmapCenters = '%s_hand_bitmap_lookup' % (hand)
+            palette = '%s_HAND_PALETTE' % (hand.upper())
+            maskPalette = '%s_HAND_MASK_PALETTE' % (hand.upper())
             bitmapTable = '%s_hand_bitmap_table' % (hand)
+            if hand in runtimeHands:
+                useRotation = 1
+                bitmapTable = 'NULL'
 
         if vectorParams:
             resourceStr += makeVectorHands(generatedTable, paintChannel, generatedDefs, hand, vectorParams)
@@ -1193,7 +1473,11 @@ def makeHands(generatedTable, generatedDefs):
             'roundPlaceX' : cxdRound.get(hand, roundCenterX),
             'roundPlaceY' : cydRound.get(hand, roundCenterY),
             'useRle' : int(bool(useRle)),
+            'useMask' : useMask,
+            'useRotation' : useRotation,
             'bitmapCenters' : bitmapCenters,
+            'palette' : palette,
+            'maskPalette' : maskPalette,
             'bitmapTable' : bitmapTable,
             'vectorTable' : vectorTable,
         }
@@ -1299,12 +1583,19 @@ def makeMoonWheel():
         subdialMaskBinary = subdialMask.point(thresholdMask)
         black = PIL.Image.new('L', subdialMask.size, 0)
         white = PIL.Image.new('L', subdialMask.size, 255)
+        subdialMaskDigest = asset_cache.image_digest(subdialMask)
 
         for cat in ['white', 'black']:
             wheelSourcePathname = '%s/clock_faces/moon_wheel_%s%s.png' % (resourcesDir, cat, mode)
             wheelSource = PIL.Image.open(wheelSourcePathname)
+            wheelSourceDigest = asset_cache.image_digest(wheelSource)
 
             for i in range(numStepsMoon):
+                targetPathname = '%s/build/rot_moon_wheel_%s_%s%s.png' % (resourcesDir, cat, i, mode)
+                inputs = (wheelSourceDigest, subdialMaskDigest, cat, mode, i, numStepsMoon)
+                if asset_cache.fetch('moon', inputs, [targetPathname]):
+                    continue
+
                 if cat == 'white' and mode != '~bw':
                     # Ignore the white image on Basalt.
                     p = wheelSource
@@ -1347,8 +1638,8 @@ def makeMoonWheel():
                         # And quantize to 16 colors.
                         p = p.convert("P", palette = PIL.Image.ADAPTIVE, colors = 16)
 
-                targetBasename = 'build/rot_moon_wheel_%s_%s%s.png' % (cat, i, mode)
-                p.save('%s/%s' % (resourcesDir, targetBasename))
+                p.save(targetPathname)
+                asset_cache.store('moon', inputs, [targetPathname])
 
 
     # Now encode to RLE and build the resource string (which is global
@@ -1435,7 +1726,7 @@ def configWatch():
     makeIndicatorTable(generatedTable, generatedDefs, 'bluetooth_table', (bluetooth_rect, bluetooth_round), numIndicatorFaces)
     makeIndicatorTable(generatedTable, generatedDefs, 'top_subdial', (top_subdial_rect, top_subdial_round), numFaces)
 
-    resourceIn = open('%s/appinfo.json.in' % (rootDir), 'r').read()
+    resourceIn = open('%s/appinfo.json.in' % (sourceRootDir), 'r').read()
     resource = open('%s/appinfo.json' % (rootDir), 'w')
 
     watchface = 'true'
@@ -1457,6 +1748,16 @@ def configWatch():
         'targetPlatforms' : ', '.join(enquoteStrings(targetPlatforms)),
         'generatedMedia' : generatedMedia,
         }
+    resource.close()
+
+    # Now that all of the resources are generated, find the ones that
+    # are copies of each other.
+    aliasesByPlatform = {}
+    if dedupeResources:
+        aliasesByPlatform, numFiles, numBytes = resource_dedupe.dedupe(targetPlatforms, os.path.abspath(rootDir))
+        print 'resource aliases: %s; %s files (%s bytes) replaced with placeholders' % (
+            ', '.join(['%s %s' % (platform, len(aliasesByPlatform[platform])) for platform in targetPlatforms]), numFiles, numBytes)
+    resource_dedupe.write_alias_table(generatedTable, targetPlatforms, aliasesByPlatform)
 
     displayLangLookup = open('%s/displayLangLookup.txt' % (resourcesDir), 'r').read()
 
@@ -1502,7 +1803,10 @@ def configWatch():
 
     print >> config, configIn % {
         'persistKey' : 0x5151 + uuId[-1],
+        'configVersionMajor' : configVersionMajor,
+        'configVersionMinor' : configVersionMinor,
         'supportRle' : int(bool(supportRle)),
+        'runtimeRotation' : int(bool(runtimeHands)),
         'apliteInvert' : int(bool(apliteInvert)),
         'numFaces' : numFaces,
         'numIndicatorFaces' : numIndicatorFaces,
@@ -1517,6 +1821,7 @@ def configWatch():
         'numStepsChronoSecond' : getNumSteps('chrono_second'),
         'numStepsChronoTenth' : numSteps['chrono_tenth'],
         'numStepsMoon' : numSteps['moon'],
+        'stepDivisors' : makeStepDivisors(),
         'secondResourceCacheSize' : getResourceCacheSize('second'),
         'chronoSecondResourceCacheSize' : getResourceCacheSize('chrono_second'),
         'secondMaskResourceCacheSize' : getMaskResourceCacheSize('second'),
@@ -1545,23 +1850,29 @@ def configWatch():
     
     # Also generate the html pages for this version, if needed.
     
-    source = open('%s/html/rosewright_configure.html.in' % (rootDir), 'r').read()
+    source = open('%s/rosewright_configure.html.in' % (htmlDir), 'r').read()
     for lang in config_langs:
         dict = {
-            'rootDir' : rootDir,
+            'htmlDir' : htmlDir,
             'lang' : lang,
             'configVersionMajor' : configVersionMajor,
             'configVersionMinor' : configVersionMinor,
             }
         
-        filename = '%(rootDir)s/html/rosewright_%(configVersionMajor)s_%(configVersionMinor)s_configure.%(lang)s.html' % dict
+        filename = '%(htmlDir)s/rosewright_%(configVersionMajor)s_%(configVersionMinor)s_configure.%(lang)s.html' % dict
         print filename
-        open(filename, 'w').write(source % dict)
+
+        # Write the page under a temporary name and rename it into
+        # place, since another config_watch.py may be writing the
+        # same page at the same time (see -o).
+        tempFilename = '%s.%s' % (filename, os.getpid())
+        open(tempFilename, 'w').write(source % dict)
+        os.rename(tempFilename, filename)
     
 
 # Main.
 try:
-    opts, args = getopt.getopt(sys.argv[1:], 's:H:F:ciwm:xp:dDh')
+    opts, args = getopt.getopt(sys.argv[1:], 's:H:F:ciwm:xR:UPr:Ap:o:B:nj:dDh')
 except getopt.error, msg:
     usage(1, msg)
 
@@ -1576,7 +1887,14 @@ compileDebugging = False
 screenshotBuild = False
 supportRle = True
 #supportRle = False
+sharePalettes = False
+runtimeHands = []
+dedupeResources = True
 targetPlatforms = [ ]
+projectDir = None
+numJobs = multiprocessing.cpu_count()
+readCache = True
+heapBudget = {}
 for opt, arg in opts:
     if opt == '-s':
         watchStyle = arg
@@ -1599,8 +1917,32 @@ for opt, arg in opts:
         supportSweep = True
     elif opt == '-x':
         supportRle = False
+    elif opt == '-R':
+        rle_encoder.speedWeight = float(arg)
+    elif opt == '-U':
+        rle_encoder.tryUnscreen = False
+    elif opt == '-P':
+        sharePalettes = True
+    elif opt == '-r':
+        runtimeHands += arg.split(',')
+    elif opt == '-A':
+        dedupeResources = False
     elif opt == '-p':
         targetPlatforms += arg.split(',')
+    elif opt == '-o':
+        projectDir = arg
+    elif opt == '-B':
+        for limit in arg.split(','):
+            if '=' in limit:
+                platform, bytes = limit.split('=')
+                heapBudget[platform] = int(bytes)
+            else:
+                for platform in [ 'aplite', 'basalt', 'chalk' ]:
+                    heapBudget[platform] = int(limit)
+    elif opt == '-n':
+        readCache = False
+    elif opt == '-j':
+        numJobs = int(arg)
     elif opt == '-d':
         compileDebugging = True
     elif opt == '-D':
@@ -1697,4 +2039,34 @@ cydRect = dict(map(lambda (hand, x, y): (hand, y), centers_rect))
 cxdRound = dict(map(lambda (hand, x, y): (hand, x), centers_round))
 cydRound = dict(map(lambda (hand, x, y): (hand, y), centers_round))
 
+# The asset cache always stays in this tree, even with -o, so that it
+# is shared by every configured watch.
+asset_cache.enable(os.path.join(sourceRootDir, 'resources', 'build', 'cache'), read = readCache)
+
+if projectDir:
+    makeProjectDir(projectDir)
+    rootDir = os.path.abspath(projectDir)
+    resourcesDir = os.path.join(rootDir, 'resources')
+    buildDir = os.path.join(resourcesDir, 'build')
+    if not os.path.isdir(buildDir):
+        os.mkdir(buildDir)
+
+    # make_rle() finds the resources relative to the current
+    # directory.
+    os.chdir(rootDir)
+
+rle_encoder.start_rle_report(os.path.join(buildDir, 'rle_report.txt'))
 configWatch()
+print rle_encoder.finish_rle_report()
+print asset_cache.report()
+
+cacheSizes = {
+    'second' : (getResourceCacheSize('second'), getMaskResourceCacheSize('second')),
+    'chrono_second' : (getResourceCacheSize('chrono_second'), getMaskResourceCacheSize('chrono_second')),
+    }
+budget = resource_budget.make_budget(targetPlatforms, cacheSizes, 'limit_cache' in defaults, 'limit_cache_aplite' in defaults, heapBudget, os.path.abspath(rootDir))
+resource_budget.write_budget(budget, os.path.join(buildDir, 'budget.json'))
+print resource_budget.summary(budget)
+if [platform for platform in targetPlatforms if budget['platforms'][platform]['heap']['over_budget']]:
+    print >> sys.stderr, "Heap budget exceeded; see %s." % (os.path.join(buildDir, 'budget.json'))
+    sys.exit(1)
@@ -0,0 +1,118 @@
+#! /usr/bin/env python
+
+import sys
+import os
+import getopt
+import subprocess
+from host.host_build import buildHostProgram, readAppinfo
+
+help = """
+fuzz_watch.py
+
+This script fuzzes the RLE bitmap decoder, rle_bwd_create(), on the
+development host.  The real code in src/ is compiled natively, with
+AddressSanitizer and UndefinedBehaviorSanitizer, against the SDK
+stand-in in host/, and then fed a series of random mutations of the
+.rle resources of the watch as currently configured by
+config_watch.py (which must not have been run with -x).  Every input
+must either decode or be rejected cleanly; any out-of-bounds access,
+crash, or leak is reported along with the options needed to
+reproduce it.
+
+The harness itself, host/fuzz_rle.c, can also be built for libFuzzer
+(with -DHOST_LIBFUZZER), or driven by AFL, by passing the input file
+to the program built here.
+
+fuzz_watch.py [opts]
+
+Options:
+
+    -p platform[,platform...]
+        Specifies the platform(s) to fuzz (aplite, basalt, and/or
+        chalk).  The default is all of the platforms targeted by the
+        current build.
+
+    -n count
+        The number of mutations to run on each platform.  The default
+        is 10000.
+
+    -s seed
+        The random seed.  The default is 1.
+
+    -i index
+        Runs only the indicated mutation, as reported by an earlier
+        failure, and writes it to fuzz_<platform>.rle for further
+        study.
+
+    -v
+        Verbose: show the compile commands.
+
+"""
+
+def usage(code, msg = ''):
+    print >> sys.stderr, help
+    print >> sys.stderr, msg
+    sys.exit(code)
+
+sanitizeFlags = [ '-fsanitize=address,undefined', '-fno-omit-frame-pointer', '-fno-sanitize-recover=undefined' ]
+
+def fuzzPlatform(platform, numMutations, seed, index, verbose):
+    """ Builds and runs the fuzz harness for the indicated platform.
+    Returns true on success, false if it found a problem. """
+
+    program, manifestFilename = buildHostProgram(platform, 'fuzz_rle.c', 'fuzz_rle', extraFlags = sanitizeFlags, verbose = verbose)
+    cmd = [ program, '-R', manifestFilename, '-n', str(numMutations), '-s', str(seed) ]
+    if index is not None:
+        cmd += [ '-i', str(index), '-w', 'fuzz_%s.rle' % (platform) ]
+    if verbose:
+        print >> sys.stderr, ' '.join(cmd)
+
+    # UBSan doesn't run the death callback that reports the failing
+    # mutation, but the harness catches the abort.
+    env = dict(os.environ)
+    env['UBSAN_OPTIONS'] = 'print_stacktrace=1:abort_on_error=1'
+
+    sys.stdout.write('%s: ' % (platform))
+    sys.stdout.flush()
+    result = subprocess.call(cmd, env = env)
+    if result != 0:
+        print "%s: failed." % (platform)
+        return False
+    return True
+
+# Main.
+try:
+    opts, args = getopt.getopt(sys.argv[1:], 'p:n:s:i:vh')
+except getopt.error, msg:
+    usage(1, msg)
+
+targetPlatforms = []
+numMutations = 10000
+seed = 1
+index = None
+verbose = False
+for opt, arg in opts:
+    if opt == '-p':
+        targetPlatforms += arg.split(',')
+    elif opt == '-n':
+        numMutations = int(arg)
+    elif opt == '-s':
+        seed = int(arg)
+    elif opt == '-i':
+        index = int(arg)
+    elif opt == '-v':
+        verbose = True
+    elif opt == '-h':
+        usage(0)
+
+appinfo = readAppinfo()
+if not targetPlatforms:
+    targetPlatforms = appinfo['targetPlatforms']
+
+failed = False
+for platform in targetPlatforms:
+    if not fuzzPlatform(platform, numMutations, seed, index, verbose):
+        failed = True
+
+if failed:
+    sys.exit(1)
@@ -0,0 +1,229 @@
+#include <pebble.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include "../src/bwd.h"
+
+// The host-side main program for bench_watch.py.  This loads each
+// bitmap resource (.png or .rle) named in the resource manifest, and
+// times the bitmap pipeline that the watch runs on it: decoding with
+// png_bwd_create() or rle_bwd_create(), flip_bitmap_x() and
+// flip_bitmap_y(), bwd_remap_colors(), and bwd_copy_bitmap().  The
+// results are written to stdout in CSV form, one row per asset.
+
+// Every operation is run once untimed, to warm up the host's caches
+// and the lazily-loaded resource data, and then timed over the same
+// fixed number of iterations, so that runs on different commits can
+// be compared directly.  Times are the mean over the iterations, in
+// microseconds.  Note that png decoding on the host goes through
+// libpng, so its time reflects the host, not the watch firmware.
+
+// These are defined in wright.c.
+int get_pixels_per_byte(GBitmap *image);
+void flip_bitmap_x(GBitmap *image, short *cx);
+void flip_bitmap_y(GBitmap *image, short *cy);
+
+#define DEFAULT_ITERATIONS 50
+
+static const char *help =
+  "bench_bwd -R manifest [opts]\n"
+  "\n"
+  "  -R manifest   The resource manifest written by bench_watch.py.\n"
+  "  -n count      The number of timed iterations of each operation.\n"
+  "  -v            Print the watch's app_log() output to stderr.\n";
+
+static double now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static const char *format_name(GBitmapFormat format) {
+  switch (format) {
+  case GBitmapFormat1Bit:
+    return "1Bit";
+  case GBitmapFormat8Bit:
+    return "8Bit";
+  case GBitmapFormat1BitPalette:
+    return "1BitPalette";
+  case GBitmapFormat2BitPalette:
+    return "2BitPalette";
+  case GBitmapFormat4BitPalette:
+    return "4BitPalette";
+  case GBitmapFormat8BitCircular:
+    return "8BitCircular";
+  }
+  return "unknown";
+}
+
+static bool ends_with(const char *str, const char *suffix) {
+  size_t str_len = strlen(str);
+  size_t suffix_len = strlen(suffix);
+  return str_len >= suffix_len && strcmp(str + str_len - suffix_len, suffix) == 0;
+}
+
+// A stand-in for the palette shared by the frames of a hand (see
+// config_watch.py -P), so that those frames can be decoded here too.
+// Its colors don't matter to the timings.
+static GColor bench_palette[16];
+
+static BitmapWithData decode_asset(uint32_t resource_id, bool is_rle) {
+  if (is_rle) {
+    return rle_bwd_create_shared(resource_id, bench_palette);
+  } else {
+    return png_bwd_create(resource_id);
+  }
+}
+
+// Benchmarks a single asset and prints its row.  Returns false if the
+// asset could not be decoded.
+static bool bench_asset(uint32_t resource_id, const char *filename, bool is_rle, int iterations) {
+  // Decode.  This also measures the heap cost of the decode: the
+  // average bytes allocated per call, the peak heap above the
+  // baseline while decoding, and the size of the decoded result.
+  BitmapWithData bwd = decode_asset(resource_id, is_rle);
+  if (bwd.bitmap == NULL) {
+    fprintf(stderr, "Could not decode %s.\n", filename);
+    return false;
+  }
+  bwd_destroy(&bwd);
+
+  host_reset_heap_stats();
+  size_t baseline = host_heap_stats.bytes_in_use;
+  size_t resident_bytes = 0;
+  double start = now_us();
+  for (int i = 0; i < iterations; ++i) {
+    bwd = decode_asset(resource_id, is_rle);
+    if (i == 0) {
+      resident_bytes = host_heap_stats.bytes_in_use - baseline;
+    }
+    bwd_destroy(&bwd);
+  }
+  double decode_us = (now_us() - start) / iterations;
+  size_t decode_alloc_bytes = host_heap_stats.total_bytes_allocated / iterations;
+  size_t decode_peak_bytes = host_heap_stats.peak_bytes_in_use - baseline;
+
+  bwd = decode_asset(resource_id, is_rle);
+  GBitmap *bitmap = bwd.bitmap;
+  GBitmapFormat format = gbitmap_get_format(bitmap);
+  GSize size = gbitmap_get_bounds(bitmap).size;
+
+  // Flip.  flip_bitmap_x() requires a whole number of bytes per row,
+  // which the hand bitmaps always have, but other assets might not.
+  char flip_x_us[32] = "";
+  if (size.w % get_pixels_per_byte(bitmap) == 0) {
+    short cx = 0;
+    flip_bitmap_x(bitmap, &cx);
+    start = now_us();
+    for (int i = 0; i < iterations; ++i) {
+      flip_bitmap_x(bitmap, &cx);
+    }
+    snprintf(flip_x_us, sizeof(flip_x_us), "%.2f", (now_us() - start) / iterations);
+  }
+
+  short cy = 0;
+  flip_bitmap_y(bitmap, &cy);
+  start = now_us();
+  for (int i = 0; i < iterations; ++i) {
+    flip_bitmap_y(bitmap, &cy);
+  }
+  double flip_y_us = (now_us() - start) / iterations;
+
+  // Remap.  This is only meaningful for palette bitmaps.
+  char remap_us[32] = "";
+  if (format == GBitmapFormat1BitPalette || format == GBitmapFormat2BitPalette ||
+      format == GBitmapFormat4BitPalette) {
+    bwd_remap_colors(&bwd, GColorWhite, GColorOxfordBlue, GColorYellow, GColorPastelYellow, false);
+    start = now_us();
+    for (int i = 0; i < iterations; ++i) {
+      bwd_remap_colors(&bwd, GColorWhite, GColorOxfordBlue, GColorYellow, GColorPastelYellow, (i & 1) != 0);
+    }
+    snprintf(remap_us, sizeof(remap_us), "%.2f", (now_us() - start) / iterations);
+  }
+
+  // Copy.
+  BitmapWithData copy = bwd_copy_bitmap(bitmap);
+  bwd_destroy(&copy);
+  start = now_us();
+  for (int i = 0; i < iterations; ++i) {
+    copy = bwd_copy_bitmap(bitmap);
+    bwd_destroy(&copy);
+  }
+  double copy_us = (now_us() - start) / iterations;
+
+  bwd_destroy(&bwd);
+
+  struct stat st;
+  long file_bytes = (stat(filename, &st) == 0) ? (long)st.st_size : -1;
+  const char *basename = strrchr(filename, '/');
+  basename = (basename != NULL) ? basename + 1 : filename;
+
+  printf("%s,%s,%s,%d,%d,%ld,%.2f,%s,%.2f,%s,%.2f,%d,%d,%d\n",
+         basename, is_rle ? "rle" : "png", format_name(format), size.w, size.h, file_bytes,
+         decode_us, flip_x_us, flip_y_us, remap_us, copy_us,
+         (int)decode_alloc_bytes, (int)decode_peak_bytes, (int)resident_bytes);
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  const char *manifest_filename = NULL;
+  int iterations = DEFAULT_ITERATIONS;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "R:n:vh")) != -1) {
+    switch (opt) {
+    case 'R':
+      manifest_filename = optarg;
+      break;
+    case 'n':
+      iterations = atoi(optarg);
+      break;
+    case 'v':
+      host_verbose = true;
+      break;
+    case 'h':
+    default:
+      fputs(help, stderr);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  if (manifest_filename == NULL || iterations <= 0) {
+    fputs(help, stderr);
+    return 1;
+  }
+  if (!host_init(manifest_filename)) {
+    return 1;
+  }
+
+  printf("asset,encoding,format,width,height,file_bytes,decode_us,flip_x_us,flip_y_us,remap_us,copy_us,decode_alloc_bytes,decode_peak_bytes,resident_bytes\n");
+
+  int result = 0;
+  uint32_t num_resources = host_num_resources();
+  for (uint32_t resource_id = 1; resource_id < num_resources; ++resource_id) {
+    const char *type = host_resource_type(resource_id);
+    const char *filename = host_resource_filename(resource_id);
+    if (type == NULL) {
+      continue;
+    }
+
+    bool is_rle = ends_with(filename, ".rle");
+    bool is_png = ends_with(filename, ".png") && (strcmp(type, "png") == 0 || strcmp(type, "pbi") == 0);
+    if (!is_rle && !is_png) {
+      continue;
+    }
+    if (bwd_resolve_alias(resource_id) != (int)resource_id) {
+      // A copy of an earlier resource (see resource_dedupe.py), which
+      // has been benchmarked already.
+      continue;
+    }
+    if (resource_size(resource_get_handle(resource_id)) == 0) {
+      // An empty placeholder, which the watch never loads.
+      continue;
+    }
+    if (!bench_asset(resource_id, filename, is_rle, iterations)) {
+      result = 1;
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,223 @@
+#include <pebble.h>
+#include <getopt.h>
+#include "../src/wright.h"
+#include "../src/wright_chrono.h"
+
+// The host-side main program for check_watch.py.  This checks that the
+// division-free hand placement in compute_hand_indexes() and
+// compute_chrono_hands() gives exactly the same hand indexes as the
+// straightforward division arithmetic, for every millisecond of the
+// day (and of the chronograph's 12-hour cycle), in each of the
+// relevant config settings.  It also checks each STEP_DIV constant
+// over its full range, including the lunar cycle constants used in
+// compute_hands().  Mismatches are reported to stdout, and the program
+// exits with a nonzero status if there were any.
+
+// These are defined in wright.c.
+void handle_init();
+void handle_deinit();
+void compute_hand_indexes(unsigned int ms, struct HandPlacement *placement);
+
+#define MAX_REPORTED 10
+
+static const char *help =
+  "check_hands -R manifest [opts]\n"
+  "\n"
+  "  -R manifest   The resource manifest written by check_watch.py.\n"
+  "  -v            Print the watch's app_log() output to stderr.\n";
+
+static int num_failures = 0;
+
+static void report_failure(const char *check, unsigned long long x, int got, int expected) {
+  if (num_failures < MAX_REPORTED) {
+    printf("%s: mismatch at %llu: got %d, expected %d\n", check, x, got, expected);
+  }
+  ++num_failures;
+}
+
+// Checks (x * m) >> s against (x * numer) / denom for every x in [0,
+// limit).
+static void check_step_div(const char *name, unsigned int numer, unsigned int denom,
+                           unsigned long long limit, uint64_t m, int s) {
+  int failures = num_failures;
+  for (unsigned long long x = 0; x < limit; ++x) {
+    unsigned int got = (unsigned int)((x * m) >> s);
+    unsigned int expected = (unsigned int)((x * numer) / denom);
+    if (got != expected) {
+      report_failure(name, x, got, expected);
+    }
+  }
+  printf("STEP_DIV %s: %llu values, %d mismatches\n", name, limit, num_failures - failures);
+}
+
+// The hand placement in compute_hand_indexes(), as it was computed
+// with divisions (in 64 bits, so large step counts don't overflow).
+static void reference_hand_indexes(unsigned int ms, struct HandPlacement *placement) {
+  {
+    unsigned int use_ms = ms % (SECONDS_PER_HOUR * 12 * 1000);
+    placement->hour_hand_index = (((uint64_t)NUM_STEPS_HOUR * use_ms) / (SECONDS_PER_HOUR * 12 * 1000)) % NUM_STEPS_HOUR;
+  }
+  {
+    unsigned int use_ms = ms % (SECONDS_PER_HOUR * 1000);
+    placement->minute_hand_index = (((uint64_t)NUM_STEPS_MINUTE * use_ms) / (SECONDS_PER_HOUR * 1000)) % NUM_STEPS_MINUTE;
+  }
+  {
+    unsigned int use_ms = ms % (60 * 1000);
+    if (!config.sweep_seconds) {
+      use_ms = (use_ms / 1000) * 1000;
+    }
+    placement->second_hand_index = (((uint64_t)NUM_STEPS_SECOND * use_ms) / (60 * 1000));
+  }
+  placement->buzzed_hour = (ms / (SECONDS_PER_HOUR * 1000)) % 24;
+}
+
+static void check_hand_indexes(bool sweep_seconds) {
+  int failures = num_failures;
+  config.sweep_seconds = sweep_seconds;
+
+  // Include the leap second at the end of the day.
+  unsigned int limit = MS_PER_DAY + 1000;
+  for (unsigned int ms = 0; ms < limit; ++ms) {
+    struct HandPlacement got, expected;
+    memset(&got, 0, sizeof(got));
+    memset(&expected, 0, sizeof(expected));
+    compute_hand_indexes(ms, &got);
+    reference_hand_indexes(ms, &expected);
+    if (got.hour_hand_index != expected.hour_hand_index) {
+      report_failure("hour_hand_index", ms, got.hour_hand_index, expected.hour_hand_index);
+    }
+    if (got.minute_hand_index != expected.minute_hand_index) {
+      report_failure("minute_hand_index", ms, got.minute_hand_index, expected.minute_hand_index);
+    }
+    if (got.second_hand_index != expected.second_hand_index) {
+      report_failure("second_hand_index", ms, got.second_hand_index, expected.second_hand_index);
+    }
+    if (got.buzzed_hour != expected.buzzed_hour) {
+      report_failure("buzzed_hour", ms, got.buzzed_hour, expected.buzzed_hour);
+    }
+  }
+  printf("compute_hand_indexes sweep=%d: %u values, %d mismatches\n", sweep_seconds, limit, num_failures - failures);
+}
+
+#ifdef MAKE_CHRONOGRAPH
+
+// The hand placement in compute_chrono_hands(), as it was computed
+// with divisions, for a stopped chronograph showing chrono_ms.
+static void reference_chrono_hands(unsigned int chrono_ms, struct HandPlacement *placement) {
+  bool shows_tenths = (config.chrono_dial == CDM_tenths) ||
+    (config.chrono_dial == CDM_dual && chrono_ms < 30 * 60 * 1000);
+
+#ifdef ENABLE_CHRONO_MINUTE_HAND
+  {
+    unsigned int use_ms = chrono_ms % (1800 * 1000);
+    placement->chrono_minute_hand_index = (((uint64_t)NUM_STEPS_CHRONO_MINUTE * use_ms) / (1800 * 1000)) % NUM_STEPS_CHRONO_MINUTE;
+  }
+#endif  // ENABLE_CHRONO_MINUTE_HAND
+
+#ifdef ENABLE_CHRONO_SECOND_HAND
+  {
+    unsigned int use_ms = chrono_ms % (60 * 1000);
+    if (!config.sweep_seconds) {
+      use_ms = (use_ms / 1000) * 1000;
+    }
+    placement->chrono_second_hand_index = (((uint64_t)NUM_STEPS_CHRONO_SECOND * use_ms) / (60 * 1000));
+  }
+#endif  // ENABLE_CHRONO_SECOND_HAND
+
+#ifdef ENABLE_CHRONO_TENTH_HAND
+  if (config.chrono_dial == CDM_off) {
+    placement->chrono_tenth_hand_index = 0;
+  } else if (shows_tenths) {
+    unsigned int use_ms = chrono_ms % 1000;
+    use_ms = 100 * (use_ms / 100);
+    placement->chrono_tenth_hand_index = (((uint64_t)NUM_STEPS_CHRONO_TENTH * use_ms) / (1000)) % NUM_STEPS_CHRONO_TENTH;
+  } else {
+    unsigned int use_ms = chrono_ms % (12 * SECONDS_PER_HOUR * 1000);
+    placement->chrono_tenth_hand_index = (((uint64_t)NUM_STEPS_CHRONO_TENTH * use_ms) / (12 * SECONDS_PER_HOUR * 1000)) % NUM_STEPS_CHRONO_TENTH;
+  }
+#endif  // ENABLE_CHRONO_TENTH_HAND
+}
+
+static void check_chrono_hands(ChronoDialMode chrono_dial, bool sweep_seconds) {
+  int failures = num_failures;
+  config.chrono_dial = chrono_dial;
+  config.sweep_seconds = sweep_seconds;
+  chrono_data.running = false;
+  chrono_data.lap_paused = false;
+
+  // Run a little past the 12-hour cycle, to check the carry into the
+  // next half-day.
+  unsigned int limit = 13 * SECONDS_PER_HOUR * 1000;
+  for (unsigned int chrono_ms = 0; chrono_ms < limit; ++chrono_ms) {
+    struct HandPlacement got, expected;
+    memset(&got, 0, sizeof(got));
+    memset(&expected, 0, sizeof(expected));
+    chrono_data.hold_ms = chrono_ms;
+    compute_chrono_hands(0, &got);
+    reference_chrono_hands(chrono_ms, &expected);
+    if (got.chrono_minute_hand_index != expected.chrono_minute_hand_index) {
+      report_failure("chrono_minute_hand_index", chrono_ms, got.chrono_minute_hand_index, expected.chrono_minute_hand_index);
+    }
+    if (got.chrono_second_hand_index != expected.chrono_second_hand_index) {
+      report_failure("chrono_second_hand_index", chrono_ms, got.chrono_second_hand_index, expected.chrono_second_hand_index);
+    }
+    if (got.chrono_tenth_hand_index != expected.chrono_tenth_hand_index) {
+      report_failure("chrono_tenth_hand_index", chrono_ms, got.chrono_tenth_hand_index, expected.chrono_tenth_hand_index);
+    }
+  }
+  printf("compute_chrono_hands dial=%d sweep=%d: %u values, %d mismatches\n", chrono_dial, sweep_seconds, limit, num_failures - failures);
+}
+
+#endif  // MAKE_CHRONOGRAPH
+
+int main(int argc, char *argv[]) {
+  const char *manifest_filename = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "R:vh")) != -1) {
+    switch (opt) {
+    case 'R':
+      manifest_filename = optarg;
+      break;
+    case 'v':
+      host_verbose = true;
+      break;
+    case 'h':
+    default:
+      fputs(help, stderr);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  if (manifest_filename == NULL) {
+    fputs(help, stderr);
+    return 1;
+  }
+  if (!host_init(manifest_filename)) {
+    return 1;
+  }
+  handle_init();
+
+#define CHECK_STEP_DIV(name, numer, denom, limit) \
+  check_step_div(#name, numer, denom, limit, STEP_DIV_##name##_M, STEP_DIV_##name##_S);
+  STEP_DIV_LIST(CHECK_STEP_DIV)
+
+  check_hand_indexes(false);
+  check_hand_indexes(true);
+
+#ifdef MAKE_CHRONOGRAPH
+  ChronoDialMode dial_modes[] = { CDM_off, CDM_tenths, CDM_hours, CDM_dual };
+  for (int i = 0; i < 4; ++i) {
+    check_chrono_hands(dial_modes[i], false);
+    check_chrono_hands(dial_modes[i], true);
+  }
+#endif  // MAKE_CHRONOGRAPH
+
+  handle_deinit();
+
+  if (num_failures != 0) {
+    printf("%d mismatches.\n", num_failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,291 @@
+#include <pebble.h>
+#include <getopt.h>
+#include <signal.h>
+#include "../src/bwd.h"
+
+#ifdef __SANITIZE_ADDRESS__
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+// A fuzz harness for the RLE decoder, rle_bwd_create(), for use by
+// fuzz_watch.py.  Each input is installed as a raw resource and
+// decoded; a corrupt input must be rejected (an empty
+// BitmapWithData) or decoded into a valid bitmap, and must never
+// read or write out of bounds or leak.  The harness is meant to be
+// built with -fsanitize=address,undefined, so that any such error is
+// caught at the point it happens.
+
+// This file serves three purposes.  Built with -DHOST_LIBFUZZER, it
+// provides only LLVMFuzzerTestOneInput(), for libFuzzer.  Otherwise it
+// has its own main(), which decodes each file named on the command
+// line (so it can be driven by AFL, or used to reproduce a crash), or
+// else runs a fixed number of random mutations of the .rle resources
+// named in the manifest.  The mutations are a deterministic function
+// of the seed and the mutation index, so any failure can be
+// reproduced exactly with -s and -i.
+
+#define FUZZ_RESOURCE_ID 1
+#define FUZZ_MAX_INPUT 65536
+
+// A stand-in for the palette shared by the frames of a hand (see
+// config_watch.py -P), so that inputs encoded with a shared palette
+// are decoded too.
+static GColor fuzz_palette[16];
+
+// Decodes a single input.  Returns true if it decoded to a bitmap,
+// false if it was rejected.
+static bool fuzz_one(const uint8_t *data, size_t size) {
+  host_set_resource_data(FUZZ_RESOURCE_ID, "raw", data, size);
+
+  size_t baseline = host_heap_stats.bytes_in_use;
+  BitmapWithData bwd = rle_bwd_create_shared(FUZZ_RESOURCE_ID, fuzz_palette);
+  bool decoded = (bwd.bitmap != NULL);
+  bwd_destroy(&bwd);
+
+  if (host_heap_stats.bytes_in_use != baseline) {
+    fprintf(stderr, "Leaked %d bytes.\n", (int)(host_heap_stats.bytes_in_use - baseline));
+    abort();
+  }
+  return decoded;
+}
+
+#ifdef HOST_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  fuzz_one(data, size);
+  return 0;
+}
+
+#else  // HOST_LIBFUZZER
+
+static const char *help =
+  "fuzz_rle [opts] [file ...]\n"
+  "\n"
+  "  -R manifest   Mutate the .rle resources named in the manifest.\n"
+  "  -n count      The number of mutations to run.\n"
+  "  -s seed       The random seed.\n"
+  "  -i index      Run only the indicated mutation.\n"
+  "  -w filename   Write the mutated input to a file, e.g. with -i.\n"
+  "  file ...      Decode each of the named files, instead.\n";
+
+static unsigned int fuzz_seed = 1;
+static int fuzz_index = -1;
+
+static void report_failure(void) {
+  if (fuzz_index >= 0) {
+    fprintf(stderr, "Failed on mutation %d; reproduce with -s %u -i %d.\n", fuzz_index, fuzz_seed, fuzz_index);
+  }
+}
+
+static void handle_signal(int sig) {
+  report_failure();
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+// A small deterministic generator (xorshift32), so that the sequence
+// of mutations doesn't depend on the host's libc.
+static uint32_t fuzz_random(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+// Reads the indicated file into a newly-allocated buffer.
+static uint8_t *read_file(const char *filename, size_t *size) {
+  FILE *file = fopen(filename, "rb");
+  if (file == NULL) {
+    perror(filename);
+    return NULL;
+  }
+  uint8_t *data = (uint8_t *)malloc(FUZZ_MAX_INPUT);
+  *size = fread(data, 1, FUZZ_MAX_INPUT, file);
+  fclose(file);
+  return data;
+}
+
+// Fills buffer with mutation index of one of the seed inputs, and
+// returns its size.  Mutations are weighted toward the 8-byte header,
+// where a single wrong byte does the most damage.
+static size_t mutate(int index, uint8_t **seeds, size_t *seed_sizes, int num_seeds, uint8_t *buffer) {
+  uint32_t state = fuzz_seed * 2654435761u + index * 40503u + 1;
+  fuzz_random(&state);
+
+  int si = fuzz_random(&state) % num_seeds;
+  size_t size = seed_sizes[si];
+  memcpy(buffer, seeds[si], size);
+
+  int num_edits = 1 + fuzz_random(&state) % 4;
+  for (int e = 0; e < num_edits && size != 0; ++e) {
+    uint32_t r = fuzz_random(&state);
+    size_t pos = (r & 1) ? fuzz_random(&state) % 8 : fuzz_random(&state) % size;
+    if (pos >= size) {
+      pos = size - 1;
+    }
+    switch ((r >> 1) % 5) {
+    case 0:
+      // Flip a bit.
+      buffer[pos] ^= 1 << (fuzz_random(&state) % 8);
+      break;
+    case 1:
+      // Replace a byte.
+      buffer[pos] = fuzz_random(&state);
+      break;
+    case 2:
+      // Replace a byte with an extreme value.
+      buffer[pos] = (fuzz_random(&state) & 1) ? 0xff : 0x00;
+      break;
+    case 3:
+      // Truncate.
+      size = pos;
+      break;
+    case 4:
+      // Append some garbage.
+      {
+        size_t extra = fuzz_random(&state) % 64;
+        for (size_t i = 0; i < extra && size < FUZZ_MAX_INPUT; ++i) {
+          buffer[size++] = fuzz_random(&state);
+        }
+      }
+      break;
+    }
+  }
+
+  return size;
+}
+
+int main(int argc, char *argv[]) {
+  const char *manifest_filename = NULL;
+  const char *write_filename = NULL;
+  int num_mutations = 10000;
+  int only_index = -1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "R:n:s:i:w:h")) != -1) {
+    switch (opt) {
+    case 'R':
+      manifest_filename = optarg;
+      break;
+    case 'n':
+      num_mutations = atoi(optarg);
+      break;
+    case 's':
+      fuzz_seed = (unsigned int)strtoul(optarg, NULL, 0);
+      break;
+    case 'i':
+      only_index = atoi(optarg);
+      break;
+    case 'w':
+      write_filename = optarg;
+      break;
+    case 'h':
+    default:
+      fputs(help, stderr);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  signal(SIGSEGV, handle_signal);
+  signal(SIGABRT, handle_signal);
+#ifdef __SANITIZE_ADDRESS__
+  __sanitizer_set_death_callback(report_failure);
+#endif
+
+  int num_decoded = 0;
+  int num_rejected = 0;
+
+  if (optind < argc) {
+    // Decode the named files.
+    for (int i = optind; i < argc; ++i) {
+      size_t size;
+      uint8_t *data = read_file(argv[i], &size);
+      if (data == NULL) {
+        return 1;
+      }
+      bool decoded = fuzz_one(data, size);
+      printf("%s: %s\n", argv[i], decoded ? "decoded" : "rejected");
+      free(data);
+    }
+    return 0;
+  }
+
+  if (manifest_filename == NULL) {
+    fputs(help, stderr);
+    return 1;
+  }
+  if (!host_init(manifest_filename)) {
+    return 1;
+  }
+
+  // Collect the seed inputs.
+  uint32_t num_resources = host_num_resources();
+  uint8_t **seeds = (uint8_t **)malloc(num_resources * sizeof(uint8_t *));
+  size_t *seed_sizes = (size_t *)malloc(num_resources * sizeof(size_t));
+  int num_seeds = 0;
+  for (uint32_t resource_id = 1; resource_id < num_resources; ++resource_id) {
+    const char *filename = host_resource_filename(resource_id);
+    size_t len = (filename != NULL) ? strlen(filename) : 0;
+    if (len < 4 || strcmp(filename + len - 4, ".rle") != 0) {
+      continue;
+    }
+    seeds[num_seeds] = read_file(filename, &seed_sizes[num_seeds]);
+    if (seeds[num_seeds] == NULL) {
+      return 1;
+    }
+    if (seed_sizes[num_seeds] == 0) {
+      // An empty placeholder, such as a resource replaced by its
+      // alias, which the watch never loads.
+      free(seeds[num_seeds]);
+      continue;
+    }
+
+    // Each seed must decode cleanly before it's mutated.
+    if (!fuzz_one(seeds[num_seeds], seed_sizes[num_seeds])) {
+      fprintf(stderr, "%s: failed to decode.\n", filename);
+      return 1;
+    }
+    ++num_seeds;
+  }
+  if (num_seeds == 0) {
+    fprintf(stderr, "No .rle resources in %s.\n", manifest_filename);
+    return 1;
+  }
+
+  uint8_t *buffer = (uint8_t *)malloc(FUZZ_MAX_INPUT);
+  int first = (only_index >= 0) ? only_index : 0;
+  int last = (only_index >= 0) ? only_index + 1 : num_mutations;
+  for (fuzz_index = first; fuzz_index < last; ++fuzz_index) {
+    size_t size = mutate(fuzz_index, seeds, seed_sizes, num_seeds, buffer);
+    if (write_filename != NULL) {
+      FILE *file = fopen(write_filename, "wb");
+      if (file == NULL) {
+        perror(write_filename);
+        return 1;
+      }
+      fwrite(buffer, 1, size, file);
+      fclose(file);
+    }
+    if (fuzz_one(buffer, size)) {
+      ++num_decoded;
+    } else {
+      ++num_rejected;
+    }
+  }
+  fuzz_index = -1;
+
+  printf("%d seeds, %d mutations: %d decoded, %d rejected.\n",
+         num_seeds, last - first, num_decoded, num_rejected);
+
+  free(buffer);
+  for (int i = 0; i < num_seeds; ++i) {
+    free(seeds[i]);
+  }
+  free(seeds);
+  free(seed_sizes);
+  return 0;
+}
+
+#endif  // HOST_LIBFUZZER
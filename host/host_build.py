@@ -0,0 +1,237 @@
+""" host_build.py
+
+Support for compiling the watch sources in src/ into a native program
+that runs on the development host, against the SDK stand-in in
+host/pebble.h.  This is used by render_watch.py and the other host
+tools; it is not needed to build the watch itself.
+
+config_watch.py must have been run first, to generate appinfo.json
+and the generated tables in resources/.
+"""
+
+import sys
+import os
+import time
+import json
+import subprocess
+
+hostDir = os.path.dirname(os.path.abspath(__file__))
+rootDir = os.path.dirname(hostDir)
+resourcesDir = os.path.join(rootDir, 'resources')
+srcDir = os.path.join(rootDir, 'src')
+
+# The resource variant tags that apply to each platform, in the same
+# sense as the SDK's own filename~tag resource selection.
+platformTags = {
+    'aplite' : set(['aplite', 'bw', 'rect']),
+    'basalt' : set(['basalt', 'color', 'rect']),
+    'chalk' : set(['chalk', 'color', 'round']),
+    }
+
+platformDefines = {
+    'aplite' : 'PBL_PLATFORM_APLITE',
+    'basalt' : 'PBL_PLATFORM_BASALT',
+    'chalk' : 'PBL_PLATFORM_CHALK',
+    }
+
+allTags = set(['aplite', 'basalt', 'chalk', 'bw', 'color', 'rect', 'round'])
+
+# The standard set of watch styles exercised by the host tools, each
+# listed with the config_watch.py options that produce it.
+watchStyles = [
+    ('a', ['-s', 'a']),
+    ('b', ['-s', 'b']),
+    ('c', ['-s', 'c']),
+    ('c2', ['-s', 'c', '-c']),
+    ('d', ['-s', 'd']),
+    ('e', ['-s', 'e']),
+    ]
+
+def configureStyle(style, verbose = False):
+    """ Reruns config_watch.py to configure the indicated style, one
+    of the names in watchStyles. """
+
+    configArgs = dict(watchStyles)[style]
+    cmd = [ sys.executable, os.path.join(rootDir, 'config_watch.py') ] + configArgs
+    if verbose:
+        print >> sys.stderr, ' '.join(cmd)
+    devnull = open(os.devnull, 'w')
+    if subprocess.call(cmd, cwd = rootDir, stdout = devnull) != 0:
+        print >> sys.stderr, "config_watch.py failed for style %s." % (style)
+        sys.exit(1)
+
+def readAppinfo(projectDir = rootDir):
+    """ Reads and returns the generated appinfo.json, from this tree
+    or from the indicated project directory (see config_watch.py
+    -o). """
+    filename = os.path.join(projectDir, 'appinfo.json')
+    if not os.path.exists(filename):
+        print >> sys.stderr, "%s not found; run config_watch.py first." % (filename)
+        sys.exit(1)
+    return json.load(open(filename, 'r'))
+
+def parseTime(timeStr):
+    """ Converts a "YYYY-MM-DD HH:MM[:SS]" string in the current
+    timezone to a Unix time. """
+    for format in ['%Y-%m-%d %H:%M:%S', '%Y-%m-%d %H:%M']:
+        try:
+            return int(time.mktime(time.strptime(timeStr, format)))
+        except ValueError:
+            pass
+    print >> sys.stderr, "Invalid time '%s'." % (timeStr)
+    sys.exit(1)
+
+def parseConfigSettings(configSettings, appinfo):
+    """ Maps name=value config settings to numeric key=value
+    settings, via the appKeys table in appinfo.json. """
+    appKeys = appinfo['appKeys']
+    result = []
+    for setting in configSettings:
+        if '=' not in setting:
+            print >> sys.stderr, "Invalid config setting '%s'." % (setting)
+            sys.exit(1)
+        name, value = setting.split('=', 1)
+        if name not in appKeys:
+            print >> sys.stderr, "Unknown config setting '%s'; choose from: %s" % (name, ' '.join(sorted(appKeys.keys())))
+            sys.exit(1)
+        result.append('%s=%s' % (appKeys[name], int(value)))
+    return result
+
+def resolveResourceFile(filename, platform, projectDir = rootDir):
+    """ Returns the full path to the variant of the indicated resource
+    file that the SDK would select for the given platform: the file
+    with the most ~tags, all of which apply to the platform. """
+
+    dirname, basename = os.path.split(os.path.join(projectDir, 'resources', filename))
+    stem, ext = os.path.splitext(basename)
+    tags = platformTags[platform]
+
+    bestFilename = None
+    bestCount = -1
+    for candidate in os.listdir(dirname or '.'):
+        cstem, cext = os.path.splitext(candidate)
+        if cext != ext:
+            continue
+        if cstem == stem:
+            candidateTags = set()
+        elif cstem.startswith(stem + '~'):
+            candidateTags = set(cstem[len(stem) + 1:].split('~'))
+            if not candidateTags.issubset(allTags):
+                continue
+        else:
+            continue
+        if candidateTags.issubset(tags) and len(candidateTags) > bestCount:
+            bestFilename = os.path.join(dirname, candidate)
+            bestCount = len(candidateTags)
+
+    return bestFilename
+
+def getPlatformMedia(appinfo, platform, projectDir = rootDir):
+    """ Returns the list of (resourceId, name, type, fullFilename)
+    for each resource in appinfo.json that applies to the given
+    platform, numbered as in the SDK's resource_ids.auto.h.  The
+    files are found in the resources of the indicated project
+    directory. """
+
+    media = []
+    resourceId = 1
+    for entry in appinfo['resources']['media']:
+        targets = entry.get('targetPlatforms')
+        if targets is not None and platform not in targets:
+            continue
+        fullFilename = resolveResourceFile(entry['file'], platform, projectDir)
+        if fullFilename is None:
+            # Fonts are never actually read on the host, so it's not
+            # an error if one hasn't been generated.
+            fullFilename = os.path.join(projectDir, 'resources', entry['file'])
+            if entry['type'] != 'font':
+                print >> sys.stderr, "Warning: resource file %s not found for %s." % (entry['file'], platform)
+        media.append((resourceId, entry['name'], entry['type'], fullFilename))
+        resourceId += 1
+    return media
+
+def writeResourceIds(media, buildDir):
+    """ Writes resource_ids.auto.h and resources.manifest for the
+    indicated media list. """
+
+    header = open(os.path.join(buildDir, 'resource_ids.auto.h'), 'w')
+    print >> header, "// Generated by host_build.py; do not edit."
+    print >> header, "#ifndef RESOURCE_IDS_AUTO_H"
+    print >> header, "#define RESOURCE_IDS_AUTO_H"
+    print >> header, "typedef enum {"
+    print >> header, "  INVALID_RESOURCE = 0,"
+    print >> header, "  DEFAULT_MENU_ICON = 0,"
+    for resourceId, name, ptype, fullFilename in media:
+        print >> header, "  RESOURCE_ID_%s = %s," % (name, resourceId)
+    print >> header, "} ResourceId;"
+    print >> header, "#endif"
+    header.close()
+
+    manifestFilename = os.path.join(buildDir, 'resources.manifest')
+    manifest = open(manifestFilename, 'w')
+    for resourceId, name, ptype, fullFilename in media:
+        print >> manifest, "%s %s %s" % (resourceId, ptype, fullFilename)
+    manifest.close()
+
+    return manifestFilename
+
+def compileProgram(platform, buildDir, mainSource, programName, extraSources = [], extraFlags = [], verbose = False):
+    """ Compiles the watch sources together with the host stand-in
+    and the indicated main program.  extraFlags are passed to the
+    compiler and the linker both, e.g. for -fsanitize.  Returns the
+    path to the resulting executable. """
+
+    cflags = [ '-std=gnu99', '-O2', '-g', '-fno-strict-aliasing', '-Wno-address-of-packed-member',
+               '-D%s' % (platformDefines[platform]),
+               '-I%s' % (buildDir), '-I%s' % (hostDir) ] + extraFlags
+
+    objects = []
+    sources = []
+    for filename in sorted(os.listdir(srcDir)):
+        if filename.endswith('.c'):
+            # The watch's own main() is renamed out of the way.
+            sources.append((os.path.join(srcDir, filename), ['-Dmain=watch_main']))
+    sources.append((os.path.join(hostDir, 'pebble_host.c'), []))
+    for filename in [mainSource] + extraSources:
+        sources.append((os.path.join(hostDir, filename), []))
+
+    for source, sourceFlags in sources:
+        obj = os.path.join(buildDir, os.path.splitext(os.path.basename(source))[0] + '.o')
+        cmd = [ 'gcc', '-c', source, '-o', obj ] + cflags + sourceFlags
+        if verbose:
+            print >> sys.stderr, ' '.join(cmd)
+        if subprocess.call(cmd) != 0:
+            print >> sys.stderr, "Failed to compile %s." % (source)
+            sys.exit(1)
+        objects.append(obj)
+
+    program = os.path.join(buildDir, programName)
+    cmd = [ 'gcc', '-o', program ] + objects + extraFlags + [ '-lpng', '-lm' ]
+    if verbose:
+        print >> sys.stderr, ' '.join(cmd)
+    if subprocess.call(cmd) != 0:
+        print >> sys.stderr, "Failed to link %s." % (program)
+        sys.exit(1)
+
+    return program
+
+def buildHostProgram(platform, mainSource, programName, extraSources = [], extraFlags = [], verbose = False):
+    """ Generates the resource tables for the indicated platform and
+    compiles a host program with the indicated main.  Returns (program,
+    manifestFilename). """
+
+    appinfo = readAppinfo()
+    if platform not in appinfo.get('targetPlatforms', platformTags.keys()):
+        print >> sys.stderr, "Platform %s is not a target of this build." % (platform)
+        sys.exit(1)
+
+    buildDir = os.path.join(hostDir, 'build', platform)
+    if not os.path.isdir(buildDir):
+        os.makedirs(buildDir)
+
+    media = getPlatformMedia(appinfo, platform)
+    manifestFilename = writeResourceIds(media, buildDir)
+    program = compileProgram(platform, buildDir, mainSource, programName,
+                             extraSources = extraSources, extraFlags = extraFlags,
+                             verbose = verbose)
+    return program, manifestFilename
@@ -0,0 +1,536 @@
+#ifndef HOST_PEBBLE_H
+#define HOST_PEBBLE_H
+
+// A stand-in for the Pebble SDK's pebble.h, so that the watch sources
+// in src/ can be compiled and run on the development host.  Only the
+// subset of the SDK actually used by Rosewright is declared here; see
+// pebble_host.c for the implementation.  The platform is selected by
+// defining one of PBL_PLATFORM_APLITE, PBL_PLATFORM_BASALT, or
+// PBL_PLATFORM_CHALK on the compiler command line, just as the real
+// SDK does.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "resource_ids.auto.h"
+
+#define PBL_SDK_3 1
+
+#if defined(PBL_PLATFORM_APLITE)
+  #define PBL_BW 1
+  #define PBL_RECT 1
+#elif defined(PBL_PLATFORM_BASALT)
+  #define PBL_COLOR 1
+  #define PBL_RECT 1
+#elif defined(PBL_PLATFORM_CHALK)
+  #define PBL_COLOR 1
+  #define PBL_ROUND 1
+#else
+  #error "Define one of PBL_PLATFORM_APLITE, PBL_PLATFORM_BASALT, or PBL_PLATFORM_CHALK."
+#endif
+
+// The watch sources read the clock via time() and time_ms(); on the
+// host, both of these are routed through a settable clock so that
+// any moment can be rendered on demand.
+time_t host_time(time_t *tloc);
+#define time(tloc) host_time(tloc)
+
+// Likewise, the watch sources allocate memory with malloc() and
+// friends, which on the host are routed through a tracking allocator
+// that models the app heap; see host_heap_stats in pebble_host.h.
+// The stand-in itself (pebble_host.c) defines HOST_NATIVE_MALLOC, and
+// calls host_malloc() explicitly for the objects that would live on
+// the app heap on the watch.
+void *host_malloc(size_t size);
+void *host_calloc(size_t count, size_t size);
+void *host_realloc(void *ptr, size_t size);
+void host_free(void *ptr);
+#ifndef HOST_NATIVE_MALLOC
+#define malloc(size) host_malloc(size)
+#define calloc(count, size) host_calloc(count, size)
+#define realloc(ptr, size) host_realloc(ptr, size)
+#define free(ptr) host_free(ptr)
+#endif  // HOST_NATIVE_MALLOC
+
+// Geometry.
+
+typedef struct GPoint {
+  int16_t x;
+  int16_t y;
+} GPoint;
+#define GPoint(x, y) ((GPoint){(x), (y)})
+#define GPointZero GPoint(0, 0)
+
+typedef struct GSize {
+  int16_t w;
+  int16_t h;
+} GSize;
+#define GSize(w, h) ((GSize){(w), (h)})
+
+typedef struct GRect {
+  GPoint origin;
+  GSize size;
+} GRect;
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+#define GRectZero GRect(0, 0, 0, 0)
+
+typedef enum {
+  GCornerNone = 0,
+  GCornersAll = 0xf,
+} GCornerMask;
+
+// Colors.
+
+typedef union GColor8 {
+  uint8_t argb;
+  struct {
+    uint8_t b:2;
+    uint8_t g:2;
+    uint8_t r:2;
+    uint8_t a:2;
+  };
+} GColor8;
+typedef GColor8 GColor;
+
+#define GColorClearARGB8 ((uint8_t)0x00)
+#define GColorBlackARGB8 ((uint8_t)0xC0)
+#define GColorOxfordBlueARGB8 ((uint8_t)0xC1)
+#define GColorDukeBlueARGB8 ((uint8_t)0xC2)
+#define GColorBlueARGB8 ((uint8_t)0xC3)
+#define GColorDarkGreenARGB8 ((uint8_t)0xC4)
+#define GColorMidnightGreenARGB8 ((uint8_t)0xC5)
+#define GColorCobaltBlueARGB8 ((uint8_t)0xC6)
+#define GColorBlueMoonARGB8 ((uint8_t)0xC7)
+#define GColorIslamicGreenARGB8 ((uint8_t)0xC8)
+#define GColorJaegerGreenARGB8 ((uint8_t)0xC9)
+#define GColorTiffanyBlueARGB8 ((uint8_t)0xCA)
+#define GColorVividCeruleanARGB8 ((uint8_t)0xCB)
+#define GColorGreenARGB8 ((uint8_t)0xCC)
+#define GColorMalachiteARGB8 ((uint8_t)0xCD)
+#define GColorMediumSpringGreenARGB8 ((uint8_t)0xCE)
+#define GColorCyanARGB8 ((uint8_t)0xCF)
+#define GColorBulgarianRoseARGB8 ((uint8_t)0xD0)
+#define GColorImperialPurpleARGB8 ((uint8_t)0xD1)
+#define GColorIndigoARGB8 ((uint8_t)0xD2)
+#define GColorElectricUltramarineARGB8 ((uint8_t)0xD3)
+#define GColorArmyGreenARGB8 ((uint8_t)0xD4)
+#define GColorDarkGrayARGB8 ((uint8_t)0xD5)
+#define GColorLibertyARGB8 ((uint8_t)0xD6)
+#define GColorVeryLightBlueARGB8 ((uint8_t)0xD7)
+#define GColorKellyGreenARGB8 ((uint8_t)0xD8)
+#define GColorMayGreenARGB8 ((uint8_t)0xD9)
+#define GColorCadetBlueARGB8 ((uint8_t)0xDA)
+#define GColorPictonBlueARGB8 ((uint8_t)0xDB)
+#define GColorBrightGreenARGB8 ((uint8_t)0xDC)
+#define GColorScreaminGreenARGB8 ((uint8_t)0xDD)
+#define GColorMediumAquamarineARGB8 ((uint8_t)0xDE)
+#define GColorElectricBlueARGB8 ((uint8_t)0xDF)
+#define GColorDarkCandyAppleRedARGB8 ((uint8_t)0xE0)
+#define GColorJazzberryJamARGB8 ((uint8_t)0xE1)
+#define GColorPurpleARGB8 ((uint8_t)0xE2)
+#define GColorVividVioletARGB8 ((uint8_t)0xE3)
+#define GColorWindsorTanARGB8 ((uint8_t)0xE4)
+#define GColorRoseValeARGB8 ((uint8_t)0xE5)
+#define GColorPurpureusARGB8 ((uint8_t)0xE6)
+#define GColorLavenderIndigoARGB8 ((uint8_t)0xE7)
+#define GColorLimerickARGB8 ((uint8_t)0xE8)
+#define GColorBrassARGB8 ((uint8_t)0xE9)
+#define GColorLightGrayARGB8 ((uint8_t)0xEA)
+#define GColorBabyBlueEyesARGB8 ((uint8_t)0xEB)
+#define GColorSpringBudARGB8 ((uint8_t)0xEC)
+#define GColorInchwormARGB8 ((uint8_t)0xED)
+#define GColorMintGreenARGB8 ((uint8_t)0xEE)
+#define GColorCelesteARGB8 ((uint8_t)0xEF)
+#define GColorRedARGB8 ((uint8_t)0xF0)
+#define GColorFollyARGB8 ((uint8_t)0xF1)
+#define GColorFashionMagentaARGB8 ((uint8_t)0xF2)
+#define GColorMagentaARGB8 ((uint8_t)0xF3)
+#define GColorOrangeARGB8 ((uint8_t)0xF4)
+#define GColorSunsetOrangeARGB8 ((uint8_t)0xF5)
+#define GColorBrilliantRoseARGB8 ((uint8_t)0xF6)
+#define GColorShockingPinkARGB8 ((uint8_t)0xF7)
+#define GColorChromeYellowARGB8 ((uint8_t)0xF8)
+#define GColorRajahARGB8 ((uint8_t)0xF9)
+#define GColorMelonARGB8 ((uint8_t)0xFA)
+#define GColorRichBrilliantLavenderARGB8 ((uint8_t)0xFB)
+#define GColorYellowARGB8 ((uint8_t)0xFC)
+#define GColorIcterineARGB8 ((uint8_t)0xFD)
+#define GColorPastelYellowARGB8 ((uint8_t)0xFE)
+#define GColorWhiteARGB8 ((uint8_t)0xFF)
+
+#define GColorClear ((GColor8){.argb = GColorClearARGB8})
+#define GColorBlack ((GColor8){.argb = GColorBlackARGB8})
+#define GColorWhite ((GColor8){.argb = GColorWhiteARGB8})
+#define GColorOxfordBlue ((GColor8){.argb = GColorOxfordBlueARGB8})
+#define GColorYellow ((GColor8){.argb = GColorYellowARGB8})
+#define GColorPastelYellow ((GColor8){.argb = GColorPastelYellowARGB8})
+
+// Bitmaps.
+
+typedef enum {
+  GBitmapFormat1Bit = 0,
+  GBitmapFormat8Bit,
+  GBitmapFormat1BitPalette,
+  GBitmapFormat2BitPalette,
+  GBitmapFormat4BitPalette,
+  GBitmapFormat8BitCircular,
+} GBitmapFormat;
+
+typedef struct GBitmap GBitmap;
+
+typedef struct GBitmapDataRowInfo {
+  uint8_t *data;
+  int16_t min_x;
+  int16_t max_x;
+} GBitmapDataRowInfo;
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette, bool free_on_destroy);
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect);
+GBitmap *__gbitmap_create_blank(GSize size);
+void gbitmap_destroy(GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+GColor *gbitmap_get_palette(const GBitmap *bitmap);
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y);
+
+// Graphics.
+
+typedef enum {
+  GCompOpAssign,
+  GCompOpAssignInverted,
+  GCompOpOr,
+  GCompOpAnd,
+  GCompOpClear,
+  GCompOpSet,
+} GCompOp;
+
+typedef struct GContext GContext;
+
+typedef enum {
+  GTextAlignmentLeft,
+  GTextAlignmentCenter,
+  GTextAlignmentRight,
+} GTextAlignment;
+
+typedef enum {
+  GTextOverflowModeWordWrap,
+  GTextOverflowModeTrailingEllipsis,
+  GTextOverflowModeFill,
+} GTextOverflowMode;
+
+typedef struct GTextAttributes GTextAttributes;
+
+typedef struct HostFont *GFont;
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_context_set_antialiased(GContext *ctx, bool enable);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_draw_pixel(GContext *ctx, GPoint point);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect);
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes);
+GSize graphics_text_layout_get_content_size(const char *text, GFont const font, const GRect box,
+                                            const GTextOverflowMode overflow_mode, const GTextAlignment alignment);
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+// Paths.
+
+typedef struct GPathInfo {
+  uint32_t num_points;
+  GPoint *points;
+} GPathInfo;
+
+typedef struct GPath {
+  uint32_t num_points;
+  GPoint *points;
+  int32_t rotation;
+  GPoint offset;
+} GPath;
+
+GPath *gpath_create(const GPathInfo *init);
+void gpath_destroy(GPath *path);
+void gpath_rotate_to(GPath *path, int32_t angle);
+void gpath_move_to(GPath *path, GPoint point);
+void gpath_draw_outline(GContext *ctx, GPath *path);
+void gpath_draw_outline_open(GContext *ctx, GPath *path);
+void gpath_draw_filled(GContext *ctx, GPath *path);
+
+// Trigonometry.
+
+#define TRIG_MAX_RATIO 0xffff
+#define TRIG_MAX_ANGLE 0x10000
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+
+// Resources.
+
+typedef struct ResHandle *ResHandle;
+
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle h);
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length);
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t *buffer, size_t num_bytes);
+
+// Fonts.
+
+#define FONT_KEY_FONT_FALLBACK "RESOURCE_ID_FONT_FALLBACK"
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+#define FONT_KEY_GOTHIC_28_BOLD "RESOURCE_ID_GOTHIC_28_BOLD"
+
+GFont fonts_get_system_font(const char *font_key);
+GFont fonts_load_custom_font(ResHandle handle);
+void fonts_unload_custom_font(GFont font);
+
+// Layers and windows.
+
+typedef struct Layer Layer;
+typedef void (*LayerUpdateProc)(struct Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void *layer_get_data(const Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *child);
+GRect layer_get_bounds(const Layer *layer);
+GRect layer_get_frame(const Layer *layer);
+void layer_set_frame(Layer *layer, GRect frame);
+void layer_set_hidden(Layer *layer, bool hidden);
+
+typedef struct TextLayer TextLayer;
+
+TextLayer *text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer *text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment);
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode);
+
+typedef struct StatusBarLayer StatusBarLayer;
+#define STATUS_BAR_LAYER_HEIGHT 16
+
+StatusBarLayer *status_bar_layer_create(void);
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer);
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer);
+
+typedef struct Window Window;
+typedef void (*WindowHandler)(struct Window *window);
+
+typedef struct WindowHandlers {
+  WindowHandler load;
+  WindowHandler appear;
+  WindowHandler disappear;
+  WindowHandler unload;
+} WindowHandlers;
+
+typedef enum {
+  BUTTON_ID_BACK = 0,
+  BUTTON_ID_UP,
+  BUTTON_ID_SELECT,
+  BUTTON_ID_DOWN,
+  NUM_BUTTONS,
+} ButtonId;
+
+typedef void *ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+
+Window *window_create(void);
+void window_destroy(Window *window);
+Layer *window_get_root_layer(const Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_background_color(Window *window, GColor background_color);
+void window_set_fullscreen(Window *window, bool enabled);
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider);
+void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider, void *context);
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms, ClickHandler handler);
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler, ClickHandler up_handler);
+void window_stack_push(Window *window, bool animated);
+Window *window_stack_pop(bool animated);
+void window_stack_pop_all(const bool animated);
+bool window_stack_contains_window(Window *window);
+Window *window_stack_get_top_window(void);
+
+// Services.
+
+typedef enum {
+  SECOND_UNIT = 1 << 0,
+  MINUTE_UNIT = 1 << 1,
+  HOUR_UNIT = 1 << 2,
+  DAY_UNIT = 1 << 3,
+  MONTH_UNIT = 1 << 4,
+  YEAR_UNIT = 1 << 5,
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+
+typedef struct {
+  uint8_t charge_percent;
+  bool is_charging;
+  bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+BatteryChargeState battery_state_service_peek(void);
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+
+typedef void (*BluetoothConnectionHandler)(bool connected);
+bool bluetooth_connection_service_peek(void);
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler);
+void bluetooth_connection_service_unsubscribe(void);
+
+typedef struct {
+  const uint32_t *durations;
+  uint32_t num_segments;
+} VibePattern;
+
+void vibes_short_pulse(void);
+void vibes_long_pulse(void);
+void vibes_double_pulse(void);
+void vibes_enqueue_custom_pattern(VibePattern pattern);
+void vibes_cancel(void);
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+size_t heap_bytes_free(void);
+void app_event_loop(void);
+
+// Persistent storage.
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+int32_t persist_read_int(const uint32_t key);
+int persist_write_int(const uint32_t key, const int32_t value);
+int persist_delete(const uint32_t key);
+
+// Dictionaries and AppMessage.
+
+typedef enum {
+  TUPLE_BYTE_ARRAY = 0,
+  TUPLE_CSTRING = 1,
+  TUPLE_UINT = 2,
+  TUPLE_INT = 3,
+} TupleType;
+
+typedef struct __attribute__((__packed__)) {
+  uint32_t key;
+  TupleType type:8;
+  uint16_t length;
+  union {
+    uint8_t data[0];
+    char cstring[0];
+    uint8_t uint8;
+    uint16_t uint16;
+    uint32_t uint32;
+    int8_t int8;
+    int16_t int16;
+    int32_t int32;
+  } value[];
+} Tuple;
+
+typedef struct {
+  const uint8_t *begin;
+  const uint8_t *end;
+  const uint8_t *cursor;
+} DictionaryIterator;
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key);
+Tuple *dict_read_first(DictionaryIterator *iter);
+Tuple *dict_read_next(DictionaryIterator *iter);
+
+typedef enum {
+  DICT_OK = 0,
+  DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+  DICT_INVALID_ARGS = 1 << 2,
+  DICT_INTERNAL_INCONSISTENCY = 1 << 3,
+  DICT_MALLOC_FAILED = 1 << 4,
+} DictionaryResult;
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value);
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value);
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value);
+
+typedef enum {
+  APP_MSG_OK = 0,
+  APP_MSG_SEND_TIMEOUT = 1 << 1,
+  APP_MSG_SEND_REJECTED = 1 << 2,
+  APP_MSG_NOT_CONNECTED = 1 << 3,
+  APP_MSG_APP_NOT_RUNNING = 1 << 4,
+  APP_MSG_INVALID_ARGS = 1 << 5,
+  APP_MSG_BUSY = 1 << 6,
+  APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+  APP_MSG_ALREADY_RELEASED = 1 << 9,
+  APP_MSG_CALLBACK_ALREADY_REGISTERED = 1 << 10,
+  APP_MSG_CALLBACK_NOT_REGISTERED = 1 << 11,
+  APP_MSG_OUT_OF_MEMORY = 1 << 12,
+  APP_MSG_CLOSED = 1 << 13,
+  APP_MSG_INTERNAL_ERROR = 1 << 14,
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void *context);
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback);
+uint32_t app_message_inbox_size_maximum(void);
+uint32_t app_message_outbox_size_maximum(void);
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+// Logging.
+
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+  APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...)
+  __attribute__((format(printf, 4, 5)));
+
+#define APP_LOG(level, fmt, args...) app_log(level, __FILE__, __LINE__, fmt, ## args)
+
+#include "pebble_host.h"
+
+#endif  // HOST_PEBBLE_H
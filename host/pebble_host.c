@@ -0,0 +1,1769 @@
+#define HOST_NATIVE_MALLOC
+#include <pebble.h>
+#include <stdarg.h>
+#include <math.h>
+#include <png.h>
+
+// This file implements, in portable C, the subset of the Pebble SDK
+// declared in host/pebble.h.  The goal is fidelity where it affects
+// the rendered pixels--bitmap formats, compositing modes, the
+// framebuffer, and the order in which ticks, timers, and layer
+// update procs are delivered--and the simplest possible stand-in
+// everywhere else.  Text rendering is not implemented; text is
+// measured but never drawn.
+
+bool host_verbose = false;
+bool host_auto_render = false;
+int host_redraw_count = 0;
+int host_frame_count = 0;
+
+// Set when any layer is marked dirty, and cleared by host_render().
+static bool host_dirty = false;
+
+#if defined(PBL_PLATFORM_APLITE)
+#define HOST_SCREEN_WIDTH 144
+#define HOST_SCREEN_HEIGHT 168
+#define HOST_FRAMEBUFFER_FORMAT GBitmapFormat1Bit
+#define HOST_HEAP_SIZE (24 * 1024)
+#elif defined(PBL_PLATFORM_BASALT)
+#define HOST_SCREEN_WIDTH 144
+#define HOST_SCREEN_HEIGHT 168
+#define HOST_FRAMEBUFFER_FORMAT GBitmapFormat8Bit
+#define HOST_HEAP_SIZE (64 * 1024)
+#else  // PBL_PLATFORM_CHALK
+#define HOST_SCREEN_WIDTH 180
+#define HOST_SCREEN_HEIGHT 180
+#define HOST_FRAMEBUFFER_FORMAT GBitmapFormat8BitCircular
+#define HOST_HEAP_SIZE (64 * 1024)
+#endif
+
+//
+// Clock.
+//
+
+static int64_t host_clock_ms = 0;
+
+time_t host_time(time_t *tloc) {
+  time_t t = (time_t)(host_clock_ms / 1000);
+  if (tloc != NULL) {
+    *tloc = t;
+  }
+  return t;
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+  uint16_t t_ms = (uint16_t)(host_clock_ms % 1000);
+  host_time(tloc);
+  if (out_ms != NULL) {
+    *out_ms = t_ms;
+  }
+  return t_ms;
+}
+
+void host_set_time(time_t t, uint16_t t_ms) {
+  host_clock_ms = (int64_t)t * 1000 + t_ms;
+}
+
+//
+// Logging and miscellany.
+//
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  if (!host_verbose) {
+    return;
+  }
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "%s:%d: ", src_filename, src_line_number);
+  vfprintf(stderr, fmt, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+}
+
+//
+// The app heap.
+//
+
+HostHeapStats host_heap_stats;
+
+// Each block is preceded by a header recording its size, padded to
+// keep the block itself suitably aligned.
+typedef union {
+  size_t size;
+  long double align;
+} HostHeapHeader;
+
+void *host_malloc(size_t size) {
+  HostHeapHeader *header = (HostHeapHeader *)malloc(sizeof(HostHeapHeader) + size);
+  if (header == NULL) {
+    return NULL;
+  }
+  header->size = size;
+  host_heap_stats.bytes_in_use += size;
+  host_heap_stats.total_bytes_allocated += size;
+  ++host_heap_stats.num_allocations;
+  if (host_heap_stats.bytes_in_use > host_heap_stats.peak_bytes_in_use) {
+    host_heap_stats.peak_bytes_in_use = host_heap_stats.bytes_in_use;
+  }
+  return header + 1;
+}
+
+void *host_calloc(size_t count, size_t size) {
+  void *ptr = host_malloc(count * size);
+  if (ptr != NULL) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+void *host_realloc(void *ptr, size_t size) {
+  void *new_ptr = host_malloc(size);
+  if (new_ptr != NULL && ptr != NULL) {
+    size_t old_size = ((HostHeapHeader *)ptr - 1)->size;
+    memcpy(new_ptr, ptr, (old_size < size) ? old_size : size);
+    host_free(ptr);
+  }
+  return new_ptr;
+}
+
+void host_free(void *ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+  HostHeapHeader *header = (HostHeapHeader *)ptr - 1;
+  host_heap_stats.bytes_in_use -= header->size;
+  free(header);
+}
+
+void host_reset_heap_stats(void) {
+  host_heap_stats.peak_bytes_in_use = host_heap_stats.bytes_in_use;
+  host_heap_stats.total_bytes_allocated = 0;
+  host_heap_stats.num_allocations = 0;
+}
+
+size_t heap_bytes_free(void) {
+  if (host_heap_stats.bytes_in_use >= HOST_HEAP_SIZE) {
+    return 0;
+  }
+  return HOST_HEAP_SIZE - host_heap_stats.bytes_in_use;
+}
+
+void app_event_loop(void) {
+}
+
+void vibes_short_pulse(void) {
+}
+
+void vibes_long_pulse(void) {
+}
+
+void vibes_double_pulse(void) {
+}
+
+void vibes_enqueue_custom_pattern(VibePattern pattern) {
+}
+
+void vibes_cancel(void) {
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+  BatteryChargeState state = { 100, false, false };
+  return state;
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+}
+
+void battery_state_service_unsubscribe(void) {
+}
+
+bool bluetooth_connection_service_peek(void) {
+  return true;
+}
+
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler) {
+}
+
+void bluetooth_connection_service_unsubscribe(void) {
+}
+
+int32_t sin_lookup(int32_t angle) {
+  return (int32_t)lround(sin(2.0 * M_PI * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+  return (int32_t)lround(cos(2.0 * M_PI * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+//
+// Resources.
+//
+
+#define HOST_MAX_RESOURCES 1024
+
+struct ResHandle {
+  uint32_t resource_id;
+  char type[16];
+  char filename[512];
+  uint8_t *data;    // Loaded lazily.
+  size_t size;
+};
+
+static struct ResHandle *host_resources[HOST_MAX_RESOURCES];
+
+bool host_init(const char *manifest_filename) {
+  FILE *manifest = fopen(manifest_filename, "r");
+  if (manifest == NULL) {
+    perror(manifest_filename);
+    return false;
+  }
+
+  char line[1024];
+  while (fgets(line, sizeof(line), manifest) != NULL) {
+    struct ResHandle rh;
+    memset(&rh, 0, sizeof(rh));
+    if (sscanf(line, "%u %15s %511[^\n]", &rh.resource_id, rh.type, rh.filename) != 3) {
+      continue;
+    }
+    if (rh.resource_id == 0 || rh.resource_id >= HOST_MAX_RESOURCES) {
+      fprintf(stderr, "%s: resource id %u out of range\n", manifest_filename, rh.resource_id);
+      fclose(manifest);
+      return false;
+    }
+    host_resources[rh.resource_id] = (struct ResHandle *)malloc(sizeof(rh));
+    *host_resources[rh.resource_id] = rh;
+  }
+
+  fclose(manifest);
+  return true;
+}
+
+static bool host_load_resource_data(ResHandle h) {
+  if (h->data != NULL) {
+    return true;
+  }
+  FILE *file = fopen(h->filename, "rb");
+  if (file == NULL) {
+    perror(h->filename);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  h->size = (size_t)ftell(file);
+  fseek(file, 0, SEEK_SET);
+  h->data = (uint8_t *)malloc(h->size + 1);
+  if (fread(h->data, 1, h->size, file) != h->size) {
+    perror(h->filename);
+    fclose(file);
+    free(h->data);
+    h->data = NULL;
+    return false;
+  }
+  fclose(file);
+  return true;
+}
+
+uint32_t host_num_resources(void) {
+  uint32_t num_resources = 0;
+  for (uint32_t i = 0; i < HOST_MAX_RESOURCES; ++i) {
+    if (host_resources[i] != NULL) {
+      num_resources = i + 1;
+    }
+  }
+  return num_resources;
+}
+
+const char *host_resource_type(uint32_t resource_id) {
+  if (resource_id >= HOST_MAX_RESOURCES || host_resources[resource_id] == NULL) {
+    return NULL;
+  }
+  return host_resources[resource_id]->type;
+}
+
+const char *host_resource_filename(uint32_t resource_id) {
+  if (resource_id >= HOST_MAX_RESOURCES || host_resources[resource_id] == NULL) {
+    return NULL;
+  }
+  return host_resources[resource_id]->filename;
+}
+
+void host_set_resource_data(uint32_t resource_id, const char *type, const uint8_t *data, size_t size) {
+  if (resource_id == 0 || resource_id >= HOST_MAX_RESOURCES) {
+    return;
+  }
+  ResHandle h = host_resources[resource_id];
+  if (h == NULL) {
+    h = (struct ResHandle *)calloc(1, sizeof(struct ResHandle));
+    h->resource_id = resource_id;
+    host_resources[resource_id] = h;
+  }
+  snprintf(h->type, sizeof(h->type), "%s", type);
+  snprintf(h->filename, sizeof(h->filename), "<memory %u>", resource_id);
+  free(h->data);
+  h->data = (uint8_t *)malloc(size + 1);
+  memcpy(h->data, data, size);
+  h->size = size;
+}
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+  if (resource_id >= HOST_MAX_RESOURCES || host_resources[resource_id] == NULL) {
+    fprintf(stderr, "resource_get_handle(%u): no such resource\n", resource_id);
+    return NULL;
+  }
+  return host_resources[resource_id];
+}
+
+size_t resource_size(ResHandle h) {
+  if (h == NULL || !host_load_resource_data(h)) {
+    return 0;
+  }
+  return h->size;
+}
+
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t *buffer, size_t num_bytes) {
+  if (h == NULL || !host_load_resource_data(h) || start_offset >= h->size) {
+    return 0;
+  }
+  if (num_bytes > h->size - start_offset) {
+    num_bytes = h->size - start_offset;
+  }
+  memcpy(buffer, h->data + start_offset, num_bytes);
+  return num_bytes;
+}
+
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length) {
+  return resource_load_byte_range(h, 0, buffer, max_length);
+}
+
+//
+// Fonts.  These are opaque handles only; nothing is ever drawn with
+// them.
+//
+
+struct HostFont {
+  const char *name;
+  int height;
+};
+
+static struct HostFont host_system_font = { "system", 18 };
+
+GFont fonts_get_system_font(const char *font_key) {
+  return &host_system_font;
+}
+
+GFont fonts_load_custom_font(ResHandle handle) {
+  if (handle == NULL) {
+    return NULL;
+  }
+  struct HostFont *font = (struct HostFont *)host_malloc(sizeof(struct HostFont));
+  font->name = handle->filename;
+  font->height = 16;
+  return font;
+}
+
+void fonts_unload_custom_font(GFont font) {
+  if (font != &host_system_font) {
+    host_free(font);
+  }
+}
+
+//
+// Bitmaps.
+//
+
+struct GBitmap {
+  uint8_t *addr;
+  uint16_t row_size_bytes;
+  GBitmapFormat format;
+  GRect bounds;
+  GColor *palette;
+  bool free_palette;
+  bool free_data;
+};
+
+static int host_palette_count(GBitmapFormat format) {
+  switch (format) {
+  case GBitmapFormat1BitPalette:
+    return 2;
+  case GBitmapFormat2BitPalette:
+    return 4;
+  case GBitmapFormat4BitPalette:
+    return 16;
+  default:
+    return 0;
+  }
+}
+
+static int host_row_size_bytes(GBitmapFormat format, int width) {
+  switch (format) {
+  case GBitmapFormat1Bit:
+    // The native 1-bit format is padded to a word boundary.
+    return ((width + 31) / 32) * 4;
+  case GBitmapFormat1BitPalette:
+    return (width + 7) / 8;
+  case GBitmapFormat2BitPalette:
+    return (width + 3) / 4;
+  case GBitmapFormat4BitPalette:
+    return (width + 1) / 2;
+  case GBitmapFormat8Bit:
+  case GBitmapFormat8BitCircular:
+  default:
+    return width;
+  }
+}
+
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette, bool free_on_destroy) {
+  GBitmap *bitmap = (GBitmap *)host_calloc(1, sizeof(GBitmap));
+  if (bitmap == NULL) {
+    return NULL;
+  }
+  bitmap->format = format;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->row_size_bytes = host_row_size_bytes(format, size.w);
+  bitmap->addr = (uint8_t *)host_calloc(1, bitmap->row_size_bytes * size.h + 1);
+  bitmap->free_data = true;
+  bitmap->palette = palette;
+  bitmap->free_palette = free_on_destroy;
+  if (bitmap->addr == NULL) {
+    host_free(bitmap);
+    return NULL;
+  }
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  int palette_count = host_palette_count(format);
+  GColor *palette = NULL;
+  if (palette_count != 0) {
+    palette = (GColor *)host_calloc(palette_count, sizeof(GColor));
+  }
+  return gbitmap_create_blank_with_palette(size, format, palette, true);
+}
+
+GBitmap *__gbitmap_create_blank(GSize size) {
+  return gbitmap_create_blank(size, GBitmapFormat1Bit);
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect) {
+  GBitmap *bitmap = (GBitmap *)host_calloc(1, sizeof(GBitmap));
+  if (bitmap == NULL) {
+    return NULL;
+  }
+  *bitmap = *base_bitmap;
+  bitmap->bounds.origin.x = base_bitmap->bounds.origin.x + sub_rect.origin.x;
+  bitmap->bounds.origin.y = base_bitmap->bounds.origin.y + sub_rect.origin.y;
+  bitmap->bounds.size = sub_rect.size;
+  bitmap->free_data = false;
+  bitmap->free_palette = false;
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  if (bitmap == NULL) {
+    return;
+  }
+  if (bitmap->free_data) {
+    host_free(bitmap->addr);
+  }
+  if (bitmap->free_palette) {
+    host_free(bitmap->palette);
+  }
+  host_free(bitmap);
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+  return bitmap->bounds;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+  return bitmap->format;
+}
+
+GColor *gbitmap_get_palette(const GBitmap *bitmap) {
+  return bitmap->palette;
+}
+
+void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy) {
+  if (bitmap->free_palette && bitmap->palette != palette) {
+    host_free(bitmap->palette);
+  }
+  bitmap->palette = palette;
+  bitmap->free_palette = free_on_destroy;
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+  return bitmap->addr;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+  return bitmap->row_size_bytes;
+}
+
+// Returns the visible span of row y of a circular (round-screen)
+// bitmap.
+static void host_circular_span(const GBitmap *bitmap, int y, int16_t *min_x, int16_t *max_x) {
+  double r = bitmap->bounds.size.w / 2.0;
+  double dy = (y + 0.5) - bitmap->bounds.size.h / 2.0;
+  double dx = (dy * dy < r * r) ? sqrt(r * r - dy * dy) : 0.0;
+  int x0 = (int)floor(r - dx + 0.5);
+  int x1 = (int)floor(r + dx - 0.5);
+  if (x1 < x0) {
+    x1 = x0;
+  }
+  *min_x = x0;
+  *max_x = x1;
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y) {
+  GBitmapDataRowInfo info;
+  info.data = bitmap->addr + (bitmap->bounds.origin.y + y) * bitmap->row_size_bytes;
+  info.min_x = 0;
+  info.max_x = bitmap->bounds.size.w - 1;
+  if (bitmap->format == GBitmapFormat8BitCircular) {
+    host_circular_span(bitmap, y, &info.min_x, &info.max_x);
+  }
+  return info;
+}
+
+// Returns the raw bit of a 1-bit bitmap at (x, y), relative to the
+// bitmap's bounds.
+static int host_get_bit(const GBitmap *bitmap, int x, int y) {
+  const uint8_t *row = bitmap->addr + (bitmap->bounds.origin.y + y) * bitmap->row_size_bytes;
+  int px = bitmap->bounds.origin.x + x;
+  return (row[px >> 3] >> (px & 7)) & 1;
+}
+
+static void host_set_bit(GBitmap *bitmap, int x, int y, int bit) {
+  uint8_t *row = bitmap->addr + (bitmap->bounds.origin.y + y) * bitmap->row_size_bytes;
+  int px = bitmap->bounds.origin.x + x;
+  if (bit) {
+    row[px >> 3] |= (1 << (px & 7));
+  } else {
+    row[px >> 3] &= ~(1 << (px & 7));
+  }
+}
+
+// Returns the color of any bitmap at (x, y), relative to the bitmap's
+// bounds.
+static GColor8 host_get_pixel(const GBitmap *bitmap, int x, int y) {
+  const uint8_t *row = bitmap->addr + (bitmap->bounds.origin.y + y) * bitmap->row_size_bytes;
+  int px = bitmap->bounds.origin.x + x;
+  int index = 0;
+  switch (bitmap->format) {
+  case GBitmapFormat1Bit:
+    return host_get_bit(bitmap, x, y) ? GColorWhite : GColorBlack;
+  case GBitmapFormat8Bit:
+  case GBitmapFormat8BitCircular:
+    return (GColor8){ .argb = row[px] };
+  case GBitmapFormat1BitPalette:
+    index = (row[px >> 3] >> (7 - (px & 7))) & 0x1;
+    break;
+  case GBitmapFormat2BitPalette:
+    index = (row[px >> 2] >> (2 * (3 - (px & 3)))) & 0x3;
+    break;
+  case GBitmapFormat4BitPalette:
+    index = (row[px >> 1] >> (4 * (1 - (px & 1)))) & 0xf;
+    break;
+  }
+  if (bitmap->palette == NULL) {
+    return GColorBlack;
+  }
+  return bitmap->palette[index];
+}
+
+// Converts a color to a single bit, for compositing onto 1-bit
+// surfaces: opaque light colors are 1, everything else is 0.
+static int host_color_to_bit(GColor8 color) {
+  if (color.a < 2) {
+    return 0;
+  }
+  return (color.r + color.g + color.b) >= 5;
+}
+
+// Loads a png resource, converting it to the native format of the
+// platform: 1-bit on Aplite, and 8-bit ARGB elsewhere.
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+  ResHandle h = resource_get_handle(resource_id);
+  if (h == NULL) {
+    return NULL;
+  }
+
+  png_image image;
+  memset(&image, 0, sizeof(image));
+  image.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_file(&image, h->filename)) {
+    fprintf(stderr, "%s: %s\n", h->filename, image.message);
+    return NULL;
+  }
+  image.format = PNG_FORMAT_RGBA;
+  uint8_t *rgba = (uint8_t *)malloc(PNG_IMAGE_SIZE(image));
+  if (!png_image_finish_read(&image, NULL, rgba, 0, NULL)) {
+    fprintf(stderr, "%s: %s\n", h->filename, image.message);
+    free(rgba);
+    return NULL;
+  }
+
+  GSize size = GSize(image.width, image.height);
+#ifdef PBL_PLATFORM_APLITE
+  GBitmap *bitmap = gbitmap_create_blank(size, GBitmapFormat1Bit);
+#else
+  GBitmap *bitmap = gbitmap_create_blank(size, GBitmapFormat8Bit);
+#endif
+  for (int y = 0; y < size.h; ++y) {
+    for (int x = 0; x < size.w; ++x) {
+      const uint8_t *p = rgba + (y * size.w + x) * 4;
+      GColor8 color;
+      color.r = (p[0] + 42) / 85;
+      color.g = (p[1] + 42) / 85;
+      color.b = (p[2] + 42) / 85;
+      color.a = (p[3] + 42) / 85;
+#ifdef PBL_PLATFORM_APLITE
+      host_set_bit(bitmap, x, y, host_color_to_bit(color));
+#else
+      bitmap->addr[y * bitmap->row_size_bytes + x] = color.argb;
+#endif
+    }
+  }
+
+  free(rgba);
+  return bitmap;
+}
+
+//
+// Graphics.
+//
+
+struct GContext {
+  GBitmap *framebuffer;
+  GPoint offset;   // Origin of the current layer, in screen coordinates.
+  GRect clip;      // Clipping rectangle, in screen coordinates.
+  GCompOp compositing_mode;
+  GColor fill_color;
+  GColor stroke_color;
+  GColor text_color;
+};
+
+static GBitmap *host_framebuffer = NULL;
+static GContext host_context;
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+  ctx->compositing_mode = mode;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  ctx->stroke_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+  ctx->text_color = color;
+}
+
+void graphics_context_set_antialiased(GContext *ctx, bool enable) {
+}
+
+static bool host_in_clip(GContext *ctx, int sx, int sy) {
+  return (sx >= ctx->clip.origin.x && sx < ctx->clip.origin.x + ctx->clip.size.w &&
+          sy >= ctx->clip.origin.y && sy < ctx->clip.origin.y + ctx->clip.size.h &&
+          sx >= 0 && sx < HOST_SCREEN_WIDTH && sy >= 0 && sy < HOST_SCREEN_HEIGHT);
+}
+
+// Paints a single color into the framebuffer at screen coordinates
+// (sx, sy), honoring the color's alpha channel.
+static void host_paint_color(GContext *ctx, int sx, int sy, GColor8 color) {
+  if (!host_in_clip(ctx, sx, sy) || color.a == 0) {
+    return;
+  }
+  GBitmap *fb = ctx->framebuffer;
+  if (fb->format == GBitmapFormat1Bit) {
+    host_set_bit(fb, sx, sy, host_color_to_bit(color));
+    return;
+  }
+
+  uint8_t *p = &fb->addr[sy * fb->row_size_bytes + sx];
+  if (color.a == 3) {
+    *p = color.argb;
+    return;
+  }
+  GColor8 dest = { .argb = *p };
+  dest.r = (color.r * color.a + dest.r * (3 - color.a)) / 3;
+  dest.g = (color.g * color.a + dest.g * (3 - color.a)) / 3;
+  dest.b = (color.b * color.a + dest.b * (3 - color.a)) / 3;
+  dest.a = 3;
+  *p = dest.argb;
+}
+
+// Composites pixel (x, y) of the source bitmap onto the framebuffer
+// at screen coordinates (sx, sy), according to the current
+// compositing mode.
+static void host_composite(GContext *ctx, const GBitmap *source, int x, int y, int sx, int sy) {
+  if (!host_in_clip(ctx, sx, sy)) {
+    return;
+  }
+  GBitmap *fb = ctx->framebuffer;
+
+  if (source->format == GBitmapFormat1Bit || fb->format == GBitmapFormat1Bit) {
+    // 1-bit sources (and all drawing on a 1-bit display) follow the
+    // classic boolean compositing rules.
+    int s = (source->format == GBitmapFormat1Bit) ? host_get_bit(source, x, y) : host_color_to_bit(host_get_pixel(source, x, y));
+    int d = (fb->format == GBitmapFormat1Bit) ? host_get_bit(fb, sx, sy) : host_color_to_bit((GColor8){ .argb = fb->addr[sy * fb->row_size_bytes + sx] });
+    switch (ctx->compositing_mode) {
+    case GCompOpAssign:
+      d = s;
+      break;
+    case GCompOpAssignInverted:
+      d = !s;
+      break;
+    case GCompOpOr:
+      d = d | s;
+      break;
+    case GCompOpAnd:
+      d = d & s;
+      break;
+    case GCompOpClear:
+      d = d & !s;
+      break;
+    case GCompOpSet:
+      d = d | !s;
+      break;
+    }
+    if (fb->format == GBitmapFormat1Bit) {
+      host_set_bit(fb, sx, sy, d);
+    } else {
+      fb->addr[sy * fb->row_size_bytes + sx] = d ? GColorWhiteARGB8 : GColorBlackARGB8;
+    }
+    return;
+  }
+
+  // Color sources on a color display: assign copies the color
+  // outright, everything else blends through the alpha channel.
+  GColor8 color = host_get_pixel(source, x, y);
+  switch (ctx->compositing_mode) {
+  case GCompOpAssign:
+    fb->addr[sy * fb->row_size_bytes + sx] = color.argb | 0xc0;
+    break;
+  case GCompOpAssignInverted:
+    fb->addr[sy * fb->row_size_bytes + sx] = (~color.argb & 0x3f) | 0xc0;
+    break;
+  default:
+    host_paint_color(ctx, sx, sy, color);
+    break;
+  }
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+  if (bitmap == NULL) {
+    return;
+  }
+  int bw = bitmap->bounds.size.w;
+  int bh = bitmap->bounds.size.h;
+  if (bw <= 0 || bh <= 0) {
+    return;
+  }
+  // As on the watch, a bitmap smaller than the rect is tiled to fill
+  // it.
+  for (int y = 0; y < rect.size.h; ++y) {
+    for (int x = 0; x < rect.size.w; ++x) {
+      host_composite(ctx, bitmap, x % bw, y % bh,
+                     ctx->offset.x + rect.origin.x + x,
+                     ctx->offset.y + rect.origin.y + y);
+    }
+  }
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  for (int y = 0; y < rect.size.h; ++y) {
+    for (int x = 0; x < rect.size.w; ++x) {
+      host_paint_color(ctx, ctx->offset.x + rect.origin.x + x, ctx->offset.y + rect.origin.y + y, ctx->fill_color);
+    }
+  }
+}
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+  host_paint_color(ctx, ctx->offset.x + point.x, ctx->offset.y + point.y, ctx->stroke_color);
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  int x0 = p0.x, y0 = p0.y, x1 = p1.x, y1 = p1.y;
+  int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int err = dx + dy;
+  while (true) {
+    graphics_draw_pixel(ctx, GPoint(x0, y0));
+    if (x0 == x1 && y0 == y1) {
+      break;
+    }
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes) {
+  // Text rendering is not implemented on the host.
+}
+
+GSize graphics_text_layout_get_content_size(const char *text, GFont const font, const GRect box,
+                                            const GTextOverflowMode overflow_mode, const GTextAlignment alignment) {
+  // A rough estimate, good enough for layout purposes.
+  int height = (font != NULL) ? font->height : 18;
+  int width = (int)strlen(text) * height / 2;
+  if (width > box.size.w) {
+    width = box.size.w;
+  }
+  return GSize(width, height);
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  return ctx->framebuffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  return true;
+}
+
+//
+// Paths.
+//
+
+GPath *gpath_create(const GPathInfo *init) {
+  GPath *path = (GPath *)host_calloc(1, sizeof(GPath));
+  if (path == NULL) {
+    return NULL;
+  }
+  path->num_points = init->num_points;
+  path->points = (GPoint *)host_malloc(init->num_points * sizeof(GPoint));
+  memcpy(path->points, init->points, init->num_points * sizeof(GPoint));
+  return path;
+}
+
+void gpath_destroy(GPath *path) {
+  if (path != NULL) {
+    host_free(path->points);
+    host_free(path);
+  }
+}
+
+void gpath_rotate_to(GPath *path, int32_t angle) {
+  path->rotation = angle;
+}
+
+void gpath_move_to(GPath *path, GPoint point) {
+  path->offset = point;
+}
+
+static GPoint host_gpath_point(GPath *path, uint32_t i) {
+  int32_t s = sin_lookup(path->rotation);
+  int32_t c = cos_lookup(path->rotation);
+  GPoint p = path->points[i];
+  return GPoint((p.x * c - p.y * s) / TRIG_MAX_RATIO + path->offset.x,
+                (p.x * s + p.y * c) / TRIG_MAX_RATIO + path->offset.y);
+}
+
+void gpath_draw_outline_open(GContext *ctx, GPath *path) {
+  for (uint32_t i = 1; i < path->num_points; ++i) {
+    graphics_draw_line(ctx, host_gpath_point(path, i - 1), host_gpath_point(path, i));
+  }
+}
+
+void gpath_draw_outline(GContext *ctx, GPath *path) {
+  gpath_draw_outline_open(ctx, path);
+  if (path->num_points > 2) {
+    graphics_draw_line(ctx, host_gpath_point(path, path->num_points - 1), host_gpath_point(path, 0));
+  }
+}
+
+void gpath_draw_filled(GContext *ctx, GPath *path) {
+  // Only the outline is drawn; the watch faces don't use filled
+  // paths.
+  GColor stroke_color = ctx->stroke_color;
+  ctx->stroke_color = ctx->fill_color;
+  gpath_draw_outline(ctx, path);
+  ctx->stroke_color = stroke_color;
+}
+
+//
+// Layers and windows.
+//
+
+#define HOST_MAX_CHILDREN 16
+
+struct Layer {
+  GRect frame;
+  bool hidden;
+  LayerUpdateProc update_proc;
+  struct Layer *parent;
+  struct Layer *children[HOST_MAX_CHILDREN];
+  int num_children;
+  void *data;
+};
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+  Layer *layer = (Layer *)host_calloc(1, sizeof(Layer));
+  if (layer == NULL) {
+    return NULL;
+  }
+  layer->frame = frame;
+  if (data_size != 0) {
+    layer->data = host_calloc(1, data_size);
+  }
+  return layer;
+}
+
+Layer *layer_create(GRect frame) {
+  return layer_create_with_data(frame, 0);
+}
+
+void layer_remove_from_parent(Layer *child) {
+  Layer *parent = child->parent;
+  if (parent == NULL) {
+    return;
+  }
+  for (int i = 0; i < parent->num_children; ++i) {
+    if (parent->children[i] == child) {
+      memmove(&parent->children[i], &parent->children[i + 1], (parent->num_children - i - 1) * sizeof(Layer *));
+      --parent->num_children;
+      break;
+    }
+  }
+  child->parent = NULL;
+}
+
+void layer_destroy(Layer *layer) {
+  if (layer == NULL) {
+    return;
+  }
+  layer_remove_from_parent(layer);
+  while (layer->num_children > 0) {
+    layer_remove_from_parent(layer->children[0]);
+  }
+  host_free(layer->data);
+  host_free(layer);
+}
+
+void *layer_get_data(const Layer *layer) {
+  return layer->data;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer *layer) {
+  // The host redraws everything on each call to host_render(), so we
+  // need only note that a redraw is pending.
+  host_dirty = true;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  layer_remove_from_parent(child);
+  if (parent->num_children >= HOST_MAX_CHILDREN) {
+    fprintf(stderr, "layer_add_child: too many children\n");
+    return;
+  }
+  parent->children[parent->num_children++] = child;
+  child->parent = parent;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  return layer->frame;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+  layer->frame = frame;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+  layer->hidden = hidden;
+}
+
+struct TextLayer {
+  Layer layer;  // Must be first.
+  const char *text;
+  GFont font;
+  GColor text_color;
+  GColor background_color;
+  GTextAlignment alignment;
+  GTextOverflowMode overflow_mode;
+};
+
+static void text_layer_update_proc(Layer *layer, GContext *ctx) {
+  TextLayer *text_layer = (TextLayer *)layer;
+  graphics_context_set_fill_color(ctx, text_layer->background_color);
+  graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+  if (text_layer->text != NULL) {
+    graphics_context_set_text_color(ctx, text_layer->text_color);
+    graphics_draw_text(ctx, text_layer->text, text_layer->font, layer_get_bounds(layer),
+                       text_layer->overflow_mode, text_layer->alignment, NULL);
+  }
+}
+
+TextLayer *text_layer_create(GRect frame) {
+  TextLayer *text_layer = (TextLayer *)host_calloc(1, sizeof(TextLayer));
+  if (text_layer == NULL) {
+    return NULL;
+  }
+  text_layer->layer.frame = frame;
+  text_layer->layer.update_proc = text_layer_update_proc;
+  text_layer->font = &host_system_font;
+  text_layer->text_color = GColorBlack;
+  text_layer->background_color = GColorWhite;
+  return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+  if (text_layer == NULL) {
+    return;
+  }
+  layer_remove_from_parent(&text_layer->layer);
+  host_free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+  return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+  text_layer->text = text;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+  text_layer->font = font;
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+  text_layer->text_color = color;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+  text_layer->background_color = color;
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+  text_layer->alignment = text_alignment;
+}
+
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode) {
+  text_layer->overflow_mode = line_mode;
+}
+
+struct StatusBarLayer {
+  Layer layer;  // Must be first.
+};
+
+static void status_bar_layer_update_proc(Layer *layer, GContext *ctx) {
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+}
+
+StatusBarLayer *status_bar_layer_create(void) {
+  StatusBarLayer *status_bar_layer = (StatusBarLayer *)host_calloc(1, sizeof(StatusBarLayer));
+  if (status_bar_layer == NULL) {
+    return NULL;
+  }
+  status_bar_layer->layer.frame = GRect(0, 0, HOST_SCREEN_WIDTH, STATUS_BAR_LAYER_HEIGHT);
+  status_bar_layer->layer.update_proc = status_bar_layer_update_proc;
+  return status_bar_layer;
+}
+
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer) {
+  if (status_bar_layer == NULL) {
+    return;
+  }
+  layer_remove_from_parent(&status_bar_layer->layer);
+  host_free(status_bar_layer);
+}
+
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer) {
+  return &status_bar_layer->layer;
+}
+
+struct Window {
+  Layer *root_layer;
+  WindowHandlers handlers;
+  GColor background_color;
+  bool loaded;
+};
+
+#define HOST_MAX_WINDOWS 8
+static Window *host_window_stack[HOST_MAX_WINDOWS];
+static int host_num_windows = 0;
+
+Window *window_create(void) {
+  Window *window = (Window *)host_calloc(1, sizeof(Window));
+  if (window == NULL) {
+    return NULL;
+  }
+  window->root_layer = layer_create(GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT));
+  window->background_color = GColorWhite;
+  return window;
+}
+
+void window_destroy(Window *window) {
+  if (window == NULL) {
+    return;
+  }
+  if (window->loaded && window->handlers.unload != NULL) {
+    window->handlers.unload(window);
+  }
+  layer_destroy(window->root_layer);
+  host_free(window);
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return window->root_layer;
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  window->background_color = background_color;
+}
+
+void window_set_fullscreen(Window *window, bool enabled) {
+}
+
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider) {
+}
+
+void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider, void *context) {
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+}
+
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms, ClickHandler handler) {
+}
+
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler, ClickHandler up_handler) {
+}
+
+void window_stack_push(Window *window, bool animated) {
+  if (host_num_windows >= HOST_MAX_WINDOWS) {
+    fprintf(stderr, "window_stack_push: too many windows\n");
+    return;
+  }
+  host_window_stack[host_num_windows++] = window;
+  if (!window->loaded) {
+    window->loaded = true;
+    if (window->handlers.load != NULL) {
+      window->handlers.load(window);
+    }
+  }
+  if (window->handlers.appear != NULL) {
+    window->handlers.appear(window);
+  }
+}
+
+Window *window_stack_pop(bool animated) {
+  if (host_num_windows == 0) {
+    return NULL;
+  }
+  Window *window = host_window_stack[--host_num_windows];
+  if (window->handlers.disappear != NULL) {
+    window->handlers.disappear(window);
+  }
+  if (window->loaded) {
+    window->loaded = false;
+    if (window->handlers.unload != NULL) {
+      window->handlers.unload(window);
+    }
+  }
+  return window;
+}
+
+void window_stack_pop_all(const bool animated) {
+  while (host_num_windows > 0) {
+    window_stack_pop(animated);
+  }
+}
+
+bool window_stack_contains_window(Window *window) {
+  for (int i = 0; i < host_num_windows; ++i) {
+    if (host_window_stack[i] == window) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Window *window_stack_get_top_window(void) {
+  if (host_num_windows == 0) {
+    return NULL;
+  }
+  return host_window_stack[host_num_windows - 1];
+}
+
+//
+// Rendering.
+//
+
+static GRect host_intersect(GRect a, GRect b) {
+  int x0 = a.origin.x > b.origin.x ? a.origin.x : b.origin.x;
+  int y0 = a.origin.y > b.origin.y ? a.origin.y : b.origin.y;
+  int x1 = (a.origin.x + a.size.w) < (b.origin.x + b.size.w) ? (a.origin.x + a.size.w) : (b.origin.x + b.size.w);
+  int y1 = (a.origin.y + a.size.h) < (b.origin.y + b.size.h) ? (a.origin.y + a.size.h) : (b.origin.y + b.size.h);
+  if (x1 < x0) {
+    x1 = x0;
+  }
+  if (y1 < y0) {
+    y1 = y0;
+  }
+  return GRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+static void host_render_layer(Layer *layer, GContext *ctx, GPoint parent_origin, GRect parent_clip) {
+  if (layer->hidden) {
+    return;
+  }
+  GPoint origin = GPoint(parent_origin.x + layer->frame.origin.x, parent_origin.y + layer->frame.origin.y);
+  GRect clip = host_intersect(parent_clip, GRect(origin.x, origin.y, layer->frame.size.w, layer->frame.size.h));
+
+  if (layer->update_proc != NULL) {
+    ctx->offset = origin;
+    ctx->clip = clip;
+    ctx->compositing_mode = GCompOpAssign;
+    ctx->fill_color = GColorBlack;
+    ctx->stroke_color = GColorBlack;
+    ctx->text_color = GColorBlack;
+    ++host_redraw_count;
+    layer->update_proc(layer, ctx);
+  }
+
+  for (int i = 0; i < layer->num_children; ++i) {
+    host_render_layer(layer->children[i], ctx, origin, clip);
+  }
+}
+
+GBitmap *host_render(void) {
+  if (host_framebuffer == NULL) {
+    // The framebuffer is not part of the app heap.
+    static struct GBitmap framebuffer_bitmap;
+    static uint8_t framebuffer_data[HOST_SCREEN_WIDTH * HOST_SCREEN_HEIGHT];
+    framebuffer_bitmap.addr = framebuffer_data;
+    framebuffer_bitmap.format = HOST_FRAMEBUFFER_FORMAT;
+    framebuffer_bitmap.bounds = GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+    framebuffer_bitmap.row_size_bytes = host_row_size_bytes(HOST_FRAMEBUFFER_FORMAT, HOST_SCREEN_WIDTH);
+    host_framebuffer = &framebuffer_bitmap;
+    host_context.framebuffer = host_framebuffer;
+  }
+
+  Window *window = window_stack_get_top_window();
+  if (window == NULL) {
+    return host_framebuffer;
+  }
+
+  host_dirty = false;
+  ++host_frame_count;
+
+  GContext *ctx = &host_context;
+  ctx->offset = GPointZero;
+  ctx->clip = GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+  ctx->fill_color = window->background_color;
+  graphics_fill_rect(ctx, ctx->clip, 0, GCornerNone);
+
+  host_render_layer(window->root_layer, ctx, GPointZero, ctx->clip);
+  return host_framebuffer;
+}
+
+// Converts the indicated bitmap to a newly-allocated 24-bit RGB
+// buffer, as it would appear on the display.
+static uint8_t *host_bitmap_to_rgb(const GBitmap *bitmap) {
+  int width = bitmap->bounds.size.w;
+  int height = bitmap->bounds.size.h;
+  uint8_t *rgb = (uint8_t *)malloc(width * height * 3);
+
+  for (int y = 0; y < height; ++y) {
+    GBitmapDataRowInfo info = gbitmap_get_data_row_info(bitmap, y);
+    for (int x = 0; x < width; ++x) {
+      uint8_t *p = rgb + (y * width + x) * 3;
+      if (x < info.min_x || x > info.max_x) {
+        // Outside the visible area of a round screen.
+        p[0] = p[1] = p[2] = 0;
+        continue;
+      }
+      GColor8 color = host_get_pixel(bitmap, x, y);
+      p[0] = color.r * 85;
+      p[1] = color.g * 85;
+      p[2] = color.b * 85;
+    }
+  }
+
+  return rgb;
+}
+
+bool host_write_png(const GBitmap *bitmap, const char *filename) {
+  uint8_t *rgb = host_bitmap_to_rgb(bitmap);
+
+  png_image image;
+  memset(&image, 0, sizeof(image));
+  image.version = PNG_IMAGE_VERSION;
+  image.width = bitmap->bounds.size.w;
+  image.height = bitmap->bounds.size.h;
+  image.format = PNG_FORMAT_RGB;
+  bool result = png_image_write_to_file(&image, filename, 0, rgb, 0, NULL);
+  if (!result) {
+    fprintf(stderr, "%s: %s\n", filename, image.message);
+  }
+  free(rgb);
+  return result;
+}
+
+int host_compare_png(const GBitmap *bitmap, const char *filename) {
+  png_image image;
+  memset(&image, 0, sizeof(image));
+  image.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_file(&image, filename)) {
+    return -1;
+  }
+  image.format = PNG_FORMAT_RGB;
+  uint8_t *golden = (uint8_t *)malloc(PNG_IMAGE_SIZE(image));
+  if (!png_image_finish_read(&image, NULL, golden, 0, NULL)) {
+    free(golden);
+    return -1;
+  }
+
+  int width = bitmap->bounds.size.w;
+  int height = bitmap->bounds.size.h;
+  if ((int)image.width != width || (int)image.height != height) {
+    free(golden);
+    return width * height;
+  }
+
+  uint8_t *rgb = host_bitmap_to_rgb(bitmap);
+  int num_differ = 0;
+  for (int i = 0; i < width * height; ++i) {
+    if (memcmp(rgb + i * 3, golden + i * 3, 3) != 0) {
+      ++num_differ;
+    }
+  }
+
+  free(rgb);
+  free(golden);
+  return num_differ;
+}
+
+//
+// Ticks and timers.
+//
+
+static TickHandler host_tick_handler = NULL;
+static TimeUnits host_tick_units = 0;
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+  host_tick_units = tick_units;
+  host_tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void) {
+  host_tick_units = 0;
+  host_tick_handler = NULL;
+}
+
+struct AppTimer {
+  int64_t due_ms;
+  AppTimerCallback callback;
+  void *callback_data;
+  struct AppTimer *next;
+};
+
+static AppTimer *host_timers = NULL;
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  AppTimer *timer = (AppTimer *)host_malloc(sizeof(AppTimer));
+  if (timer == NULL) {
+    return NULL;
+  }
+  timer->due_ms = host_clock_ms + timeout_ms;
+  timer->callback = callback;
+  timer->callback_data = callback_data;
+  timer->next = host_timers;
+  host_timers = timer;
+  return timer;
+}
+
+static bool host_unlink_timer(AppTimer *timer) {
+  for (AppTimer **tp = &host_timers; *tp != NULL; tp = &(*tp)->next) {
+    if (*tp == timer) {
+      *tp = timer->next;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+  for (AppTimer *timer = host_timers; timer != NULL; timer = timer->next) {
+    if (timer == timer_handle) {
+      timer->due_ms = host_clock_ms + new_timeout_ms;
+      return true;
+    }
+  }
+  return false;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+  if (host_unlink_timer(timer_handle)) {
+    host_free(timer_handle);
+  }
+}
+
+// Returns the set of units that differ between the two times.
+static TimeUnits host_units_changed(time_t before, time_t after) {
+  struct tm b = *localtime(&before);
+  struct tm a = *localtime(&after);
+  TimeUnits units = 0;
+  if (a.tm_sec != b.tm_sec) units |= SECOND_UNIT;
+  if (a.tm_min != b.tm_min) units |= MINUTE_UNIT;
+  if (a.tm_hour != b.tm_hour) units |= HOUR_UNIT;
+  if (a.tm_mday != b.tm_mday) units |= DAY_UNIT;
+  if (a.tm_mon != b.tm_mon) units |= MONTH_UNIT;
+  if (a.tm_year != b.tm_year) units |= YEAR_UNIT;
+  return units;
+}
+
+// Called after each event delivered by host_advance_to().  If
+// host_auto_render is set, this redraws the window whenever the event
+// marked a layer dirty, as the firmware does.
+static void host_after_event(void) {
+  if (host_auto_render && host_dirty) {
+    host_render();
+  }
+}
+
+void host_advance_to(time_t t, uint16_t t_ms) {
+  int64_t target_ms = (int64_t)t * 1000 + t_ms;
+
+  while (true) {
+    // Find the next event: either the earliest timer, or the next
+    // tick boundary.
+    AppTimer *next_timer = NULL;
+    for (AppTimer *timer = host_timers; timer != NULL; timer = timer->next) {
+      if (next_timer == NULL || timer->due_ms < next_timer->due_ms) {
+        next_timer = timer;
+      }
+    }
+
+    int64_t next_tick_ms = INT64_MAX;
+    if (host_tick_handler != NULL) {
+      int64_t period_ms = (host_tick_units & SECOND_UNIT) ? 1000 : 60000;
+      next_tick_ms = (host_clock_ms / period_ms + 1) * period_ms;
+    }
+
+    if (next_timer != NULL && next_timer->due_ms <= next_tick_ms && next_timer->due_ms <= target_ms) {
+      if (next_timer->due_ms > host_clock_ms) {
+        host_clock_ms = next_timer->due_ms;
+      }
+      host_unlink_timer(next_timer);
+      AppTimerCallback callback = next_timer->callback;
+      void *callback_data = next_timer->callback_data;
+      host_free(next_timer);
+      callback(callback_data);
+      host_after_event();
+
+    } else if (next_tick_ms <= target_ms) {
+      time_t before = (time_t)(host_clock_ms / 1000);
+      host_clock_ms = next_tick_ms;
+      time_t now = (time_t)(host_clock_ms / 1000);
+      struct tm tick_time = *localtime(&now);
+      host_tick_handler(&tick_time, host_units_changed(before, now));
+      host_after_event();
+
+    } else {
+      break;
+    }
+  }
+
+  host_clock_ms = target_ms;
+}
+
+//
+// Persistent storage.  This is kept in memory only, for the lifetime
+// of the process.
+//
+
+#define HOST_MAX_PERSIST 64
+
+struct HostPersist {
+  bool used;
+  uint32_t key;
+  int size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+};
+
+static struct HostPersist host_persist[HOST_MAX_PERSIST];
+
+static struct HostPersist *host_find_persist(uint32_t key, bool create) {
+  struct HostPersist *empty = NULL;
+  for (int i = 0; i < HOST_MAX_PERSIST; ++i) {
+    if (host_persist[i].used && host_persist[i].key == key) {
+      return &host_persist[i];
+    }
+    if (!host_persist[i].used && empty == NULL) {
+      empty = &host_persist[i];
+    }
+  }
+  if (create && empty != NULL) {
+    empty->used = true;
+    empty->key = key;
+    empty->size = 0;
+  }
+  return create ? empty : NULL;
+}
+
+bool persist_exists(const uint32_t key) {
+  return host_find_persist(key, false) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+  struct HostPersist *p = host_find_persist(key, false);
+  return (p != NULL) ? p->size : -1;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  struct HostPersist *p = host_find_persist(key, false);
+  if (p == NULL) {
+    return -1;
+  }
+  int size = p->size < (int)buffer_size ? p->size : (int)buffer_size;
+  memcpy(buffer, p->data, size);
+  return size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  int write_size = size < PERSIST_DATA_MAX_LENGTH ? (int)size : PERSIST_DATA_MAX_LENGTH;
+  struct HostPersist *p = host_find_persist(key, true);
+  if (p == NULL) {
+    return -1;
+  }
+  memcpy(p->data, data, write_size);
+  p->size = write_size;
+  return write_size;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  int32_t value = 0;
+  persist_read_data(key, &value, sizeof(value));
+  return value;
+}
+
+int persist_write_int(const uint32_t key, const int32_t value) {
+  return persist_write_data(key, &value, sizeof(value));
+}
+
+int persist_delete(const uint32_t key) {
+  struct HostPersist *p = host_find_persist(key, false);
+  if (p != NULL) {
+    p->used = false;
+  }
+  return 0;
+}
+
+//
+// Dictionaries and AppMessage.
+//
+
+static Tuple *host_tuple_at(const DictionaryIterator *iter, const uint8_t *p) {
+  if (p + sizeof(Tuple) > iter->end) {
+    return NULL;
+  }
+  return (Tuple *)p;
+}
+
+Tuple *dict_read_first(DictionaryIterator *iter) {
+  iter->cursor = iter->begin;
+  return dict_read_next(iter);
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter) {
+  Tuple *tuple = host_tuple_at(iter, iter->cursor);
+  if (tuple != NULL) {
+    iter->cursor += sizeof(Tuple) + tuple->length;
+  }
+  return tuple;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+  const uint8_t *p = iter->begin;
+  Tuple *tuple;
+  while ((tuple = host_tuple_at(iter, p)) != NULL) {
+    if (tuple->key == key) {
+      return tuple;
+    }
+    p += sizeof(Tuple) + tuple->length;
+  }
+  return NULL;
+}
+
+static DictionaryResult host_dict_write(DictionaryIterator *iter, const uint32_t key, TupleType type,
+                                        const void *value, uint16_t length) {
+  if (iter->cursor + sizeof(Tuple) + length > iter->end) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  Tuple *tuple = (Tuple *)iter->cursor;
+  tuple->key = key;
+  tuple->type = type;
+  tuple->length = length;
+  memcpy(tuple->value, value, length);
+  iter->cursor += sizeof(Tuple) + length;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+  return host_dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value) {
+  return host_dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+  return host_dict_write(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+static AppMessageInboxReceived host_inbox_received = NULL;
+static AppMessageInboxDropped host_inbox_dropped = NULL;
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+  AppMessageInboxReceived previous = host_inbox_received;
+  host_inbox_received = received_callback;
+  return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+  AppMessageInboxDropped previous = host_inbox_dropped;
+  host_inbox_dropped = dropped_callback;
+  return previous;
+}
+
+uint32_t app_message_inbox_size_maximum(void) {
+  return 2026;
+}
+
+uint32_t app_message_outbox_size_maximum(void) {
+  return 656;
+}
+
+static uint32_t host_inbox_size = 0;
+
+// The outbox holds one message at a time, as on the watch; it is busy
+// from app_message_outbox_begin() until the message is collected by
+// host_receive_message().
+static uint32_t host_outbox_size = 0;
+static uint8_t *host_outbox = NULL;
+static DictionaryIterator host_outbox_iter;
+static bool host_outbox_writing = false;
+static bool host_outbox_sent = false;
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  host_inbox_size = size_inbound;
+  free(host_outbox);
+  host_outbox_size = size_outbound;
+  host_outbox = (uint8_t *)malloc(size_outbound);
+  host_outbox_writing = false;
+  host_outbox_sent = false;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if (host_outbox == NULL) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  if (host_outbox_writing || host_outbox_sent) {
+    return APP_MSG_BUSY;
+  }
+  host_outbox_iter.begin = host_outbox;
+  host_outbox_iter.end = host_outbox + host_outbox_size;
+  host_outbox_iter.cursor = host_outbox;
+  host_outbox_writing = true;
+  *iterator = &host_outbox_iter;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  if (!host_outbox_writing) {
+    return APP_MSG_INVALID_ARGS;
+  }
+  host_outbox_writing = false;
+  host_outbox_sent = true;
+  return APP_MSG_OK;
+}
+
+int host_receive_message(uint32_t *keys, int32_t *values, int max_pairs) {
+  if (!host_outbox_sent) {
+    return -1;
+  }
+  host_outbox_sent = false;
+
+  DictionaryIterator iter;
+  iter.begin = host_outbox;
+  iter.end = host_outbox_iter.cursor;
+  int num_pairs = 0;
+  for (Tuple *tuple = dict_read_first(&iter); tuple != NULL && num_pairs < max_pairs; tuple = dict_read_next(&iter)) {
+    int32_t value = 0;
+    switch (tuple->length) {
+    case 1:
+      value = (tuple->type == TUPLE_INT) ? tuple->value->int8 : tuple->value->uint8;
+      break;
+    case 2:
+      value = (tuple->type == TUPLE_INT) ? tuple->value->int16 : tuple->value->uint16;
+      break;
+    case 4:
+      value = tuple->value->int32;
+      break;
+    }
+    keys[num_pairs] = tuple->key;
+    values[num_pairs] = value;
+    ++num_pairs;
+  }
+  return num_pairs;
+}
+
+bool host_send_config(const uint32_t *keys, const int32_t *values, int num_pairs) {
+  if (host_inbox_received == NULL) {
+    return false;
+  }
+
+  // The message is a one-byte count followed by the tuples, and it
+  // must fit in the inbox the watch opened.
+  size_t tuple_size = sizeof(Tuple) + sizeof(int32_t);
+  if (host_inbox_size != 0 && 1 + tuple_size * num_pairs > host_inbox_size) {
+    if (host_inbox_dropped != NULL) {
+      host_inbox_dropped(APP_MSG_BUFFER_OVERFLOW, NULL);
+    }
+    return false;
+  }
+
+  uint8_t *buffer = (uint8_t *)malloc(tuple_size * num_pairs + 1);
+  for (int i = 0; i < num_pairs; ++i) {
+    Tuple *tuple = (Tuple *)(buffer + i * tuple_size);
+    tuple->key = keys[i];
+    tuple->type = TUPLE_INT;
+    tuple->length = sizeof(int32_t);
+    memcpy(tuple->value, &values[i], sizeof(int32_t));
+  }
+
+  DictionaryIterator iter;
+  iter.begin = buffer;
+  iter.end = buffer + tuple_size * num_pairs;
+  iter.cursor = buffer;
+  host_inbox_received(&iter, NULL);
+  free(buffer);
+  return true;
+}
@@ -0,0 +1,102 @@
+#ifndef PEBBLE_HOST_H
+#define PEBBLE_HOST_H
+
+// Host-only entry points into the SDK stand-in, used by the host
+// tools to drive the watch sources from the outside: setting the
+// clock, delivering config messages, and rendering the window stack
+// into a framebuffer that can be written out as a png file.  None of
+// this is visible to, or needed by, the code in src/.
+
+// Loads the resource manifest written by render_watch.py.  Each line
+// of the manifest is "id type filename", where id is the numeric
+// resource id as assigned in resource_ids.auto.h.  Returns false on
+// failure.
+bool host_init(const char *manifest_filename);
+
+// Sets the current time, as seen by time(), time_ms(), and
+// localtime().  This does not fire any tick or timer events; see
+// host_advance_to() for that.
+void host_set_time(time_t t, uint16_t t_ms);
+
+// Advances the clock to the indicated time, firing (in order) every
+// tick handler and app_timer callback that would have been triggered
+// on the real watch in the meantime.
+void host_advance_to(time_t t, uint16_t t_ms);
+
+// Delivers a config message to the registered inbox handler, as if
+// it had arrived from the phone.  The keys and values are parallel
+// arrays of length num_pairs; each value is sent as an int32 tuple.
+// If the message is too large for the inbox size the watch passed to
+// app_message_open(), it goes to the dropped handler instead, and
+// this returns false.
+bool host_send_config(const uint32_t *keys, const int32_t *values, int num_pairs);
+
+// Collects the message most recently sent by the watch with
+// app_message_outbox_send(), as if the phone had received it, into
+// the parallel arrays keys and values, of length max_pairs; each
+// integer tuple is read as an int32.  Returns the number of pairs, or
+// -1 if the watch hasn't sent anything since the last call.  The
+// outbox is free again afterwards.
+int host_receive_message(uint32_t *keys, int32_t *values, int max_pairs);
+
+// Renders the topmost window on the window stack into the
+// framebuffer, by calling each layer's update proc in turn, exactly
+// as the real firmware does, and returns the framebuffer.  The
+// returned bitmap remains owned by the host.
+GBitmap *host_render(void);
+
+// Writes the indicated bitmap (normally the framebuffer) to a png
+// file.  Returns false on failure.
+bool host_write_png(const GBitmap *bitmap, const char *filename);
+
+// Compares the indicated bitmap, pixel for pixel, against a png file
+// previously written by host_write_png().  Returns the number of
+// pixels that differ, or -1 if the png file can't be read.
+int host_compare_png(const GBitmap *bitmap, const char *filename);
+
+// Returns the number of resource ids in the manifest (one more than
+// the highest id), and the type and filename recorded for each id,
+// or NULL if the id is unused.
+uint32_t host_num_resources(void);
+const char *host_resource_type(uint32_t resource_id);
+const char *host_resource_filename(uint32_t resource_id);
+
+// Replaces the contents of the indicated resource (creating it if
+// necessary) with a copy of the given bytes, in place of the file
+// named in the manifest.
+void host_set_resource_data(uint32_t resource_id, const char *type, const uint8_t *data, size_t size);
+
+// Statistics on the app heap, i.e. everything allocated by the watch
+// sources with malloc() and friends, plus the bitmaps, layers,
+// windows, and other objects the SDK allocates on their behalf.
+// heap_bytes_free() reports HOST_HEAP_SIZE less bytes_in_use.
+typedef struct {
+  size_t bytes_in_use;
+  size_t peak_bytes_in_use;
+  size_t total_bytes_allocated;
+  int num_allocations;
+} HostHeapStats;
+
+extern HostHeapStats host_heap_stats;
+
+// Resets the peak to the current usage, and the totals to zero, so
+// that the cost of a particular operation can be measured.
+void host_reset_heap_stats(void);
+
+// Set this true to send app_log() output to stderr.
+extern bool host_verbose;
+
+// Set this true to have host_advance_to() redraw the window after
+// each tick or timer event that marks a layer dirty, just as the
+// firmware would, so that redraws can be counted.
+extern bool host_auto_render;
+
+// Counts the number of times any layer's update proc has been
+// called, i.e. the number of layer redraws.
+extern int host_redraw_count;
+
+// Counts the number of calls to host_render(), i.e. the number of
+// frames drawn.
+extern int host_frame_count;
+
+#endif  // PEBBLE_HOST_H
@@ -0,0 +1,285 @@
+// pebble_js_host.js
+//
+// A stand-in for the PebbleKit JS runtime, for sync_watch.py.  This
+// loads the generated src/js/pebble-js-app.js into a sandbox with
+// just enough of the Pebble, localStorage, and navigator objects to
+// run it, and connects its Pebble.sendAppMessage() to the real watch
+// code, running natively in sync_watch.c, so that the config sync
+// protocol can be exercised from both ends on the development host.
+//
+// Usage: node pebble_js_host.js [-v] appinfo.json pebble-js-app.js
+//            program manifest step [step ...]
+//
+// Each step is one of:
+//
+//   ready             The phone reconnects to the watch.
+//   set:name=value,...
+//                     The user opens the config page, changes the
+//                     indicated settings, and closes it.
+//   restart           The watch app is restarted.
+//   reinstall         The watch app is reinstalled, losing its saved
+//                     config, but the phone keeps its own.
+//   drop:N            The next N messages sent to the watch are lost,
+//                     and the JS app is told they were not delivered.
+//
+// Time is simulated: setTimeout() callbacks run in order of their due
+// time, without actually waiting.  For each step, this reports the
+// messages sent to the watch, the number lost, the simulated time
+// taken, and whether the watch's config changed.  At the end, it checks that the
+// watch's config hash matches the phone's configuration, and exits
+// with a nonzero status if not.
+
+var fs = require('fs');
+var vm = require('vm');
+var childProcess = require('child_process');
+var readline = require('readline');
+
+var args = process.argv.slice(2);
+var verbose = false;
+if (args[0] == '-v') {
+    verbose = true;
+    args.shift();
+}
+if (args.length < 5) {
+    console.error("usage: node pebble_js_host.js [-v] appinfo.json pebble-js-app.js program manifest step [step ...]");
+    process.exit(1);
+}
+
+var appinfo = JSON.parse(fs.readFileSync(args[0], 'utf8'));
+var jsSource = fs.readFileSync(args[1], 'utf8');
+var program = args[2];
+var manifest = args[3];
+var steps = args.slice(4);
+
+var appKeys = appinfo['appKeys'];
+var appKeyNames = {};
+for (var name in appKeys) {
+    appKeyNames[appKeys[name]] = name;
+}
+
+// The watch program answers each command with exactly one line.
+var watchArgs = [ '-R', manifest ];
+if (verbose) {
+    watchArgs.push('-v');
+}
+var watch = childProcess.spawn(program, watchArgs, { stdio: [ 'pipe', 'pipe', 'inherit' ] });
+var watchLines = readline.createInterface({ input: watch.stdout });
+var lineWaiters = [];
+watchLines.on('line', function(line) {
+    lineWaiters.shift()(line);
+});
+
+function watchCommand(command) {
+    return new Promise(function(resolve) {
+        lineWaiters.push(resolve);
+        watch.stdin.write(command + '\n');
+    });
+}
+
+// The phone's storage, which survives restarts of the JS app.
+var storage = {};
+var localStorage = {
+    getItem: function(key) { return (key in storage) ? storage[key] : null; },
+    setItem: function(key, value) { storage[key] = String(value); },
+    removeItem: function(key) { delete storage[key]; },
+};
+
+// Work queued by the JS app: timers and outgoing messages, each run
+// at its due time on the simulated clock.
+var timers = [];
+var nextTimerId = 1;
+var now = 0;
+
+function schedule(delay, fn) {
+    var id = nextTimerId++;
+    timers.push({ id: id, due: now + (delay || 0), fn: fn });
+    return id;
+}
+
+function cancel(id) {
+    timers = timers.filter(function(timer) { return timer.id != id; });
+}
+
+// The number of messages still to be lost.
+var dropCount = 0;
+
+// Counts for the current step.
+var stepMessages = 0;
+var stepTuples = 0;
+var stepBytes = 0;
+var stepChanged = false;
+var stepReads = 0;
+var stepDropped = 0;
+
+var context = null;
+var listeners = null;
+var openedUrl = null;
+
+function fireEvent(type, e) {
+    (listeners[type] || []).forEach(function(listener) {
+        listener(e);
+    });
+}
+
+// Delivers a message from the JS app to the watch, then delivers the
+// watch's reply, if any, back to the JS app.
+function deliverMessage(message, ack, nack) {
+    var pairs = [];
+    for (var name in message) {
+        if (!(name in appKeys)) {
+            console.error("unknown appKey " + name);
+            continue;
+        }
+        pairs.push(appKeys[name] + '=' + (message[name] | 0));
+    }
+    stepMessages += 1;
+    stepTuples += pairs.length;
+    // A dictionary has a one-byte count, then a 7-byte header and a
+    // 4-byte value for each integer tuple.
+    stepBytes += 1 + pairs.length * 11;
+
+    if (dropCount > 0) {
+        --dropCount;
+        ++stepDropped;
+        if (nack) {
+            nack({ data: message, error: { message: "APP_MSG_SEND_TIMEOUT" } });
+        }
+        return Promise.resolve();
+    }
+
+    return watchCommand('send ' + pairs.join(' ')).then(function(line) {
+        if (line == 'dropped') {
+            console.log("message of " + pairs.length + " tuples dropped by the watch");
+            if (nack) {
+                nack({ data: message, error: { message: "APP_MSG_BUFFER_OVERFLOW" } });
+            }
+            return;
+        }
+        var payload = {};
+        var replied = false;
+        line.split(' ').slice(1).forEach(function(token) {
+            var kv = token.split('=');
+            if (kv[0] == 'changed') {
+                stepChanged = stepChanged || (kv[1] != '0');
+            } else if (kv[0] == 'reads') {
+                stepReads += parseInt(kv[1]);
+            } else {
+                payload[appKeyNames[kv[0]] || kv[0]] = parseInt(kv[1]);
+                replied = true;
+            }
+        });
+        if (ack) {
+            ack({ data: message });
+        }
+        if (replied) {
+            fireEvent('appmessage', { payload: payload });
+        }
+    });
+}
+
+// Starts (or restarts) the JS app, with a fresh sandbox but the same
+// localStorage.
+function startApp() {
+    listeners = {};
+    var Pebble = {
+        addEventListener: function(type, listener) {
+            (listeners[type] = listeners[type] || []).push(listener);
+        },
+        sendAppMessage: function(message, ack, nack) {
+            schedule(0, function() { return deliverMessage(message, ack, nack); });
+        },
+        openURL: function(url) {
+            openedUrl = url;
+        },
+    };
+    context = vm.createContext({
+        Pebble: Pebble,
+        localStorage: localStorage,
+        navigator: { language: 'en-US' },
+        console: { log: function(msg) { if (verbose) { console.error('js: ' + msg); } } },
+        setTimeout: function(fn, ms) { return schedule(ms, fn); },
+        clearTimeout: function(id) { cancel(id); },
+    });
+    vm.runInContext(jsSource, context, { filename: args[1] });
+}
+
+// Plays the config page: opens it, and returns the settings it was
+// opened with, from its URL, with the indicated changes.
+function configPageResponse(changes) {
+    openedUrl = null;
+    fireEvent('showConfiguration', {});
+    var query = openedUrl.split('?')[1];
+    // The real page returns show_debug even when it's not in the URL.
+    var response = { show_debug: 0 };
+    query.split('&').forEach(function(param) {
+        var kv = param.split('=');
+        var value = decodeURIComponent(kv[1]);
+        response[kv[0]] = isNaN(parseInt(value)) ? value : parseInt(value);
+    });
+    changes.split(',').forEach(function(change) {
+        var kv = change.split('=');
+        response[kv[0]] = parseInt(kv[1]);
+    });
+    return encodeURIComponent(JSON.stringify(response));
+}
+
+async function runTasks() {
+    while (timers.length != 0) {
+        var first = 0;
+        for (var i = 1; i < timers.length; ++i) {
+            if (timers[i].due < timers[first].due) {
+                first = i;
+            }
+        }
+        var timer = timers.splice(first, 1)[0];
+        now = timer.due;
+        await timer.fn();
+    }
+}
+
+async function runStep(step) {
+    stepMessages = stepTuples = stepBytes = stepReads = stepDropped = 0;
+    stepChanged = false;
+    var stepStart = now;
+
+    if (step == 'ready') {
+        fireEvent('ready', {});
+    } else if (step.startsWith('set:')) {
+        var response = configPageResponse(step.substring(4));
+        fireEvent('webviewclosed', { type: 'webviewclosed', response: response });
+    } else if (step.startsWith('drop:')) {
+        dropCount = parseInt(step.substring(5));
+        return;
+    } else if (step == 'restart' || step == 'reinstall') {
+        await watchCommand(step);
+        startApp();
+        fireEvent('ready', {});
+    } else {
+        console.error("unknown step " + step);
+        process.exit(1);
+    }
+    await runTasks();
+
+    console.log(step + ": " + stepMessages + " messages (" + stepDropped + " lost), " +
+                stepTuples + " tuples, " + stepBytes + " bytes, " + (now - stepStart) + " ms; watch config " +
+                (stepChanged ? "changed" : "unchanged") + ", " + stepReads + " resource reads");
+}
+
+async function main() {
+    startApp();
+    for (var i = 0; i < steps.length; ++i) {
+        await runStep(steps[i]);
+    }
+
+    var line = await watchCommand('hash');
+    var watchHash = parseInt(line.split(' ')[1]);
+    var phoneHash = vm.runInContext('hashConfiguration(currentConfiguration())', context);
+    watch.stdin.end();
+    if (watchHash != phoneHash) {
+        console.log("Out of sync: watch has config " + watchHash + ", phone has " + phoneHash);
+        process.exit(1);
+    }
+    console.log("In sync: config " + watchHash);
+}
+
+main();
@@ -0,0 +1,144 @@
+#include <pebble.h>
+#include <getopt.h>
+#include <sys/time.h>
+
+// The host-side main program for render_watch.py.  This starts up
+// the real watch code (handle_init() and friends, from wright.c),
+// sets the clock to each requested moment, lets the tick and timer
+// handlers run exactly as they would on the watch, and then renders
+// the window stack to a png file.
+
+// These are defined in wright.c.
+void handle_init();
+void handle_deinit();
+
+#define MAX_CONFIG_PAIRS 32
+
+static const char *help =
+  "render_watch -R manifest [opts]\n"
+  "\n"
+  "  -R manifest   The resource manifest written by render_watch.py.\n"
+  "  -t time       The Unix time (seconds) of the first frame.\n"
+  "  -n count      The number of frames to render.\n"
+  "  -s seconds    The interval between successive frames.\n"
+  "  -k key=value  Send the indicated config setting (by numeric key)\n"
+  "                before rendering.  May be repeated.\n"
+  "  -o filename   The output filename.  This is passed through\n"
+  "                strftime() with the local time of each frame, so\n"
+  "                that e.g. %H%M%S can be used to name the frames.\n"
+  "  -g filename   Compare each frame bit-exactly against a golden png\n"
+  "                file, named by strftime() as with -o, and report the\n"
+  "                result on stdout.\n"
+  "  -v            Print the watch's app_log() output to stderr.\n";
+
+int main(int argc, char *argv[]) {
+  const char *manifest_filename = NULL;
+  const char *output_pattern = "render_%Y%m%d_%H%M%S.png";
+  const char *golden_pattern = NULL;
+  time_t start_time = 0;
+  int num_frames = 1;
+  int step_seconds = 60;
+  uint32_t config_keys[MAX_CONFIG_PAIRS];
+  int32_t config_values[MAX_CONFIG_PAIRS];
+  int num_config_pairs = 0;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "R:t:n:s:k:o:g:vh")) != -1) {
+    switch (opt) {
+    case 'R':
+      manifest_filename = optarg;
+      break;
+    case 't':
+      start_time = (time_t)atoll(optarg);
+      break;
+    case 'n':
+      num_frames = atoi(optarg);
+      break;
+    case 's':
+      step_seconds = atoi(optarg);
+      break;
+    case 'k':
+      if (num_config_pairs >= MAX_CONFIG_PAIRS ||
+          sscanf(optarg, "%u=%d", &config_keys[num_config_pairs], &config_values[num_config_pairs]) != 2) {
+        fprintf(stderr, "Invalid config setting: %s\n", optarg);
+        return 1;
+      }
+      ++num_config_pairs;
+      break;
+    case 'o':
+      output_pattern = optarg;
+      break;
+    case 'g':
+      golden_pattern = optarg;
+      break;
+    case 'v':
+      host_verbose = true;
+      break;
+    case 'h':
+    default:
+      fputs(help, stderr);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  if (manifest_filename == NULL) {
+    fputs(help, stderr);
+    return 1;
+  }
+  if (!host_init(manifest_filename)) {
+    return 1;
+  }
+
+  host_set_time(start_time, 0);
+  handle_init();
+  if (num_config_pairs != 0) {
+    host_send_config(config_keys, config_values, num_config_pairs);
+  }
+
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+
+  int result = 0;
+  int num_mismatches = 0;
+  for (int i = 0; i < num_frames; ++i) {
+    time_t frame_time = start_time + (time_t)i * step_seconds;
+    host_advance_to(frame_time, 0);
+    GBitmap *fb = host_render();
+
+    char filename[1024];
+    struct tm *frame_tm = localtime(&frame_time);
+    if (strftime(filename, sizeof(filename), output_pattern, frame_tm) == 0 ||
+        !host_write_png(fb, filename)) {
+      result = 1;
+      break;
+    }
+
+    if (golden_pattern == NULL) {
+      printf("%s\n", filename);
+    } else {
+      char golden_filename[1024];
+      strftime(golden_filename, sizeof(golden_filename), golden_pattern, frame_tm);
+      int num_differ = host_compare_png(fb, golden_filename);
+      if (num_differ == 0) {
+        printf("%s ok\n", filename);
+      } else if (num_differ < 0) {
+        printf("%s missing %s\n", filename, golden_filename);
+        ++num_mismatches;
+      } else {
+        printf("%s differs %d\n", filename, num_differ);
+        ++num_mismatches;
+      }
+    }
+  }
+
+  gettimeofday(&end, NULL);
+  double elapsed_ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_usec - start.tv_usec) / 1000.0;
+  fprintf(stderr, "Rendered %d frames in %.1f ms, %d layer redraws, peak heap %d bytes.\n",
+          num_frames, elapsed_ms, host_redraw_count, (int)host_heap_stats.peak_bytes_in_use);
+
+  handle_deinit();
+  if (num_mismatches != 0) {
+    result = 2;
+  }
+  return result;
+}
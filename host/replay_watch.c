@@ -0,0 +1,165 @@
+#include <pebble.h>
+#include <getopt.h>
+#include "../src/bwd.h"
+#include "../src/clock_source.h"
+
+// The host-side main program for replay_watch.py.  This starts up the
+// real watch code, selects a clock source, and then runs the watch's
+// event loop over a long stretch of simulated time--a full day, say,
+// or a full lunar cycle--redrawing the window whenever the watch
+// marks it dirty, exactly as the firmware would.  For each simulated
+// hour it reports, in CSV form, the number of frames drawn, layer
+// redraws, bitmap decodes, cache hits, and allocations.  Since the
+// host clock is simulated too, this runs as fast as the host can draw,
+// and the results are fully repeatable.
+
+// These are defined in wright.c.
+void handle_init();
+void handle_deinit();
+
+#define MAX_CONFIG_PAIRS 32
+#define MAX_SCRIPT_STEPS 1024
+
+static const char *help =
+  "replay_watch -R manifest [opts]\n"
+  "\n"
+  "  -R manifest   The resource manifest written by replay_watch.py.\n"
+  "  -t time       The Unix time (seconds) at which to start.\n"
+  "  -H hours      The number of simulated hours to replay.\n"
+  "  -a factor     Use an accelerated clock, factor times real time.\n"
+  "  -f            Use a fixed clock, held at the start time.\n"
+  "  -T filename   Use a scripted clock, read from the indicated file:\n"
+  "                one step per line, \"at_ms time\", where at_ms is\n"
+  "                the real time into the replay, in milliseconds, and\n"
+  "                time is the Unix time the clock jumps to.\n"
+  "  -k key=value  Send the indicated config setting (by numeric key)\n"
+  "                before starting.  May be repeated.\n"
+  "  -v            Print the watch's app_log() output to stderr.\n";
+
+static ClockScriptStep script[MAX_SCRIPT_STEPS];
+
+// Reads a scripted clock trace.  Returns the number of steps, or -1 on
+// failure.
+static int read_script(const char *filename) {
+  FILE *file = fopen(filename, "r");
+  if (file == NULL) {
+    perror(filename);
+    return -1;
+  }
+  int num_steps = 0;
+  unsigned int at_ms;
+  long long t;
+  while (num_steps < MAX_SCRIPT_STEPS && fscanf(file, "%u %lld", &at_ms, &t) == 2) {
+    script[num_steps].at_ms = at_ms;
+    script[num_steps].t = (time_t)t;
+    ++num_steps;
+  }
+  fclose(file);
+  return num_steps;
+}
+
+int main(int argc, char *argv[]) {
+  const char *manifest_filename = NULL;
+  const char *script_filename = NULL;
+  time_t start_time = 0;
+  int num_hours = 24;
+  int factor = 1;
+  bool fixed = false;
+  uint32_t config_keys[MAX_CONFIG_PAIRS];
+  int32_t config_values[MAX_CONFIG_PAIRS];
+  int num_config_pairs = 0;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "R:t:H:a:fT:k:vh")) != -1) {
+    switch (opt) {
+    case 'R':
+      manifest_filename = optarg;
+      break;
+    case 't':
+      start_time = (time_t)atoll(optarg);
+      break;
+    case 'H':
+      num_hours = atoi(optarg);
+      break;
+    case 'a':
+      factor = atoi(optarg);
+      break;
+    case 'f':
+      fixed = true;
+      break;
+    case 'T':
+      script_filename = optarg;
+      break;
+    case 'k':
+      if (num_config_pairs >= MAX_CONFIG_PAIRS ||
+          sscanf(optarg, "%u=%d", &config_keys[num_config_pairs], &config_values[num_config_pairs]) != 2) {
+        fprintf(stderr, "Invalid config setting: %s\n", optarg);
+        return 1;
+      }
+      ++num_config_pairs;
+      break;
+    case 'v':
+      host_verbose = true;
+      break;
+    case 'h':
+    default:
+      fputs(help, stderr);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  if (manifest_filename == NULL || factor < 1) {
+    fputs(help, stderr);
+    return 1;
+  }
+  if (!host_init(manifest_filename)) {
+    return 1;
+  }
+
+  host_set_time(start_time, 0);
+  if (fixed) {
+    clock_source_fixed(start_time, 0);
+  } else if (factor != 1) {
+    clock_source_accelerated(factor);
+  } else if (script_filename != NULL) {
+    int num_steps = read_script(script_filename);
+    if (num_steps < 0) {
+      return 1;
+    }
+    clock_source_scripted(script, num_steps);
+  }
+
+  handle_init();
+  if (num_config_pairs != 0) {
+    host_send_config(config_keys, config_values, num_config_pairs);
+  }
+  host_render();
+  host_auto_render = true;
+
+  // With an accelerated clock, a simulated hour passes in less real
+  // (host) time.  A scripted clock is reported by real hours.
+  int64_t start_ms = (int64_t)start_time * 1000;
+  int64_t hour_ms = (int64_t)3600 * 1000 / factor;
+
+  printf("hour,frames,layer_redraws,decodes,cache_hits,allocations,bytes_allocated,peak_heap\n");
+  for (int hour = 0; hour < num_hours; ++hour) {
+    int frames = host_frame_count;
+    int redraws = host_redraw_count;
+    int decodes = bwd_resource_reads;
+    int cache_hits = bwd_cache_hits;
+    host_reset_heap_stats();
+
+    int64_t end_ms = start_ms + (hour + 1) * hour_ms;
+    host_advance_to((time_t)(end_ms / 1000), (uint16_t)(end_ms % 1000));
+
+    printf("%d,%d,%d,%d,%d,%d,%d,%d\n", hour,
+           host_frame_count - frames, host_redraw_count - redraws,
+           bwd_resource_reads - decodes, bwd_cache_hits - cache_hits,
+           host_heap_stats.num_allocations, (int)host_heap_stats.total_bytes_allocated,
+           (int)host_heap_stats.peak_bytes_in_use);
+    fflush(stdout);
+  }
+
+  handle_deinit();
+  return 0;
+}
@@ -0,0 +1,120 @@
+#include <pebble.h>
+#include <getopt.h>
+#include "../src/wright.h"
+#include "../src/bwd.h"
+
+// The host-side main program for sync_watch.py.  This runs the real
+// watch code as the far end of the config sync protocol, for the
+// stand-in PebbleKit JS runtime in pebble_js_host.js, which starts
+// this program and talks to it over stdin and stdout, one line per
+// command:
+//
+//   send key=value ...  Delivers a message from the phone, and answers
+//                       "reply key=value ... changed=N reads=N", with
+//                       the message the watch sent back (if any),
+//                       whether the config changed, and the number of
+//                       resources the watch reloaded; or "dropped" if
+//                       the message didn't fit in the watch's inbox.
+//   restart             Restarts the watch app; answers "ok".
+//   reinstall           Restarts the watch app with its saved config
+//                       deleted, as if it had been reinstalled;
+//                       answers "ok".
+//   hash                Answers "hash N", with config_hash().
+
+// These are defined in wright.c.
+void handle_init();
+void handle_deinit();
+
+#define MAX_PAIRS 32
+#define MAX_LINE 1024
+
+static const char *help =
+  "sync_watch -R manifest [opts]\n"
+  "\n"
+  "  -R manifest   The resource manifest written by sync_watch.py.\n"
+  "  -v            Print the watch's app_log() output to stderr.\n";
+
+static void handle_send(char *args) {
+  uint32_t keys[MAX_PAIRS];
+  int32_t values[MAX_PAIRS];
+  int num_pairs = 0;
+  for (char *token = strtok(args, " \n"); token != NULL; token = strtok(NULL, " \n")) {
+    if (num_pairs < MAX_PAIRS && sscanf(token, "%u=%d", &keys[num_pairs], &values[num_pairs]) == 2) {
+      ++num_pairs;
+    }
+  }
+
+  ConfigOptions orig_config = config;
+  int reads = bwd_resource_reads;
+  if (!host_send_config(keys, values, num_pairs)) {
+    printf("dropped\n");
+    return;
+  }
+  host_render();
+
+  printf("reply");
+  num_pairs = host_receive_message(keys, values, MAX_PAIRS);
+  for (int i = 0; i < num_pairs; ++i) {
+    printf(" %u=%d", (unsigned int)keys[i], (int)values[i]);
+  }
+  printf(" changed=%d reads=%d\n", memcmp(&orig_config, &config, sizeof(config)) != 0,
+         bwd_resource_reads - reads);
+}
+
+int main(int argc, char *argv[]) {
+  const char *manifest_filename = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "R:vh")) != -1) {
+    switch (opt) {
+    case 'R':
+      manifest_filename = optarg;
+      break;
+    case 'v':
+      host_verbose = true;
+      break;
+    case 'h':
+    default:
+      fputs(help, stderr);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  if (manifest_filename == NULL) {
+    fputs(help, stderr);
+    return 1;
+  }
+  if (!host_init(manifest_filename)) {
+    return 1;
+  }
+
+  host_set_time(1404900576, 0);
+  handle_init();
+  host_render();
+
+  char line[MAX_LINE];
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    if (strncmp(line, "send", 4) == 0) {
+      handle_send(line + 4);
+    } else if (strncmp(line, "restart", 7) == 0) {
+      handle_deinit();
+      handle_init();
+      host_render();
+      printf("ok\n");
+    } else if (strncmp(line, "reinstall", 9) == 0) {
+      handle_deinit();
+      persist_delete(PERSIST_KEY);
+      handle_init();
+      host_render();
+      printf("ok\n");
+    } else if (strncmp(line, "hash", 4) == 0) {
+      printf("hash %u\n", (unsigned int)config_hash());
+    } else {
+      printf("error\n");
+    }
+    fflush(stdout);
+  }
+
+  handle_deinit();
+  return 0;
+}
@@ -0,0 +1,234 @@
+#! /usr/bin/env python
+
+import sys
+import os
+import time
+import getopt
+import subprocess
+from host.host_build import buildHostProgram, readAppinfo, watchStyles, configureStyle, parseTime, parseConfigSettings
+
+help = """
+render_watch.py
+
+This script renders the watch face, as currently configured by
+config_watch.py, to png files on the development host, without an
+emulator or a watch.  The real drawing code in src/ is compiled
+natively against a stand-in for the Pebble SDK (see host/), so the
+output matches the watch pixel for pixel, except that text (for
+instance, in the date windows) is not drawn.
+
+render_watch.py [opts]
+
+Options:
+
+    -p platform[,platform...]
+        Specifies the platform(s) to render (aplite, basalt, and/or
+        chalk).  The default is all of the platforms targeted by the
+        current build.
+
+    -t "YYYY-MM-DD HH:MM:SS"
+        Specifies the local time of the first frame.  The default is
+        2014-07-09 10:09:36, the time used for screenshots.
+
+    -z timezone
+        Specifies the timezone, as in the TZ environment variable.
+        The default is UTC.
+
+    -n count
+        Render the indicated number of frames.  The default is 1.
+
+    -i seconds
+        The interval between successive frames.  The default is 60.
+
+    -d
+        Render a full day, one frame per minute.  This is the same as
+        -n 1440 -i 60.
+
+    -k name=value
+        Sends the indicated config setting to the watch before
+        rendering, as if it had arrived from the phone.  The name is
+        one of the appKeys in appinfo.json, for instance draw_mode=1
+        or face_index=2.  May be repeated.
+
+    -o directory
+        Specifies the output directory.  The default is "render".
+
+    -m
+        Render the full regression matrix: each watch style, on each
+        platform, with several combinations of draw_mode and
+        color_mode, at several fixed times.  This reruns
+        config_watch.py for each style in turn, so it leaves the last
+        style configured.  Options -p, -t, -n, -i, -d, and -k are
+        ignored.
+
+    -c directory
+        Compare each rendered frame, bit for bit, against the
+        same-named png in the indicated directory, as written by a
+        previous run with -o.  Any differences are reported, and the
+        script exits with status 1.  The usual workflow is to run
+        "render_watch.py -m -o golden" on a known-good revision, and
+        then "render_watch.py -m -c golden" after making changes.
+
+    -v
+        Verbose: show the compile commands and the watch's log output.
+
+"""
+
+def usage(code, msg = ''):
+    print >> sys.stderr, help
+    print >> sys.stderr, msg
+    sys.exit(code)
+
+# The regression matrix rendered by -m.  Each of the watchStyles is
+# rendered on each platform, which exercises a different resource
+# mode (~bw, ~color~rect, and ~color~round), and each (draw_mode,
+# color_mode) pair is rendered at each of matrixNumFrames times,
+# starting from matrixTime.
+matrixPlatforms = [ 'aplite', 'basalt', 'chalk' ]
+matrixConfigs = [ (0, 0), (1, 0), (0, 1), (1, 1), (0, 2) ]
+matrixTime = '2014-07-09 10:09:36'
+matrixNumFrames = 3
+matrixInterval = 20000
+
+def renderWatch(program, manifestFilename, startTime, numFrames, interval, configSettings, outputDir, prefix, goldenDir, verbose):
+    """ Runs the host renderer already built for a platform.  Returns
+    the list of (filename, status) for each frame written, where
+    status is 'ok', 'differs n', or 'missing filename' if goldenDir
+    is given, or None otherwise. """
+
+    pattern = '%s_%%Y%%m%%d_%%H%%M%%S.png' % (prefix)
+    cmd = [ program, '-R', manifestFilename, '-t', str(startTime),
+            '-n', str(numFrames), '-s', str(interval),
+            '-o', os.path.join(outputDir, pattern) ]
+    if goldenDir:
+        cmd += [ '-g', os.path.join(goldenDir, pattern) ]
+    for setting in configSettings:
+        cmd += [ '-k', setting ]
+    if verbose:
+        cmd.append('-v')
+        print >> sys.stderr, ' '.join(cmd)
+
+    process = subprocess.Popen(cmd, stdout = subprocess.PIPE)
+    output = process.communicate()[0]
+    if process.returncode not in [0, 2]:
+        print >> sys.stderr, "Rendering failed for %s." % (prefix)
+        sys.exit(1)
+
+    results = []
+    for line in output.splitlines():
+        words = line.split()
+        if len(words) == 1:
+            results.append((words[0], None))
+        elif words:
+            results.append((words[0], ' '.join(words[1:])))
+    return results
+
+def reportResults(results):
+    """ Prints any golden mismatches from the list of (filename,
+    status) results, and returns the number of mismatches. """
+    mismatches = 0
+    for filename, status in results:
+        if status is not None and status != 'ok':
+            print "%s: %s" % (filename, status)
+            mismatches += 1
+    return mismatches
+
+def renderMatrix(outputDir, goldenDir, verbose):
+    """ Renders the full regression matrix.  Returns the list of
+    (filename, status) results. """
+
+    startTime = parseTime(matrixTime)
+    results = []
+    for style, configArgs in watchStyles:
+        configureStyle(style, verbose = verbose)
+
+        appinfo = readAppinfo()
+        for platform in matrixPlatforms:
+            if platform not in appinfo['targetPlatforms']:
+                continue
+            program, manifestFilename = buildHostProgram(platform, 'render_watch.c', 'render_watch', verbose = verbose)
+            for drawMode, colorMode in matrixConfigs:
+                configSettings = parseConfigSettings(['draw_mode=%s' % (drawMode), 'color_mode=%s' % (colorMode)], appinfo)
+                prefix = '%s_%s_d%s_c%s' % (style, platform, drawMode, colorMode)
+                results += renderWatch(program, manifestFilename, startTime, matrixNumFrames, matrixInterval,
+                                       configSettings, outputDir, prefix, goldenDir, verbose)
+            print "%s %s: done" % (style, platform)
+
+    return results
+
+
+# Main.
+try:
+    opts, args = getopt.getopt(sys.argv[1:], 'p:t:z:n:i:dk:o:mc:vh')
+except getopt.error, msg:
+    usage(1, msg)
+
+targetPlatforms = []
+timeStr = '2014-07-09 10:09:36'
+timezone = 'UTC'
+numFrames = 1
+interval = 60
+configSettings = []
+outputDir = 'render'
+goldenDir = None
+matrix = False
+verbose = False
+for opt, arg in opts:
+    if opt == '-p':
+        targetPlatforms += arg.split(',')
+    elif opt == '-t':
+        timeStr = arg
+    elif opt == '-z':
+        timezone = arg
+    elif opt == '-n':
+        numFrames = int(arg)
+    elif opt == '-i':
+        interval = int(arg)
+    elif opt == '-d':
+        numFrames = 24 * 60
+        interval = 60
+    elif opt == '-k':
+        configSettings.append(arg)
+    elif opt == '-o':
+        outputDir = arg
+    elif opt == '-m':
+        matrix = True
+    elif opt == '-c':
+        goldenDir = arg
+    elif opt == '-v':
+        verbose = True
+    elif opt == '-h':
+        usage(0)
+
+# The timezone applies both to parsing the -t option here, and to
+# localtime() within the rendered watch.
+os.environ['TZ'] = timezone
+time.tzset()
+
+if not os.path.isdir(outputDir):
+    os.makedirs(outputDir)
+
+if matrix:
+    results = renderMatrix(outputDir, goldenDir, verbose)
+
+else:
+    appinfo = readAppinfo()
+    if not targetPlatforms:
+        targetPlatforms = appinfo['targetPlatforms']
+
+    startTime = parseTime(timeStr)
+    configSettings = parseConfigSettings(configSettings, appinfo)
+
+    results = []
+    for platform in targetPlatforms:
+        program, manifestFilename = buildHostProgram(platform, 'render_watch.c', 'render_watch', verbose = verbose)
+        platformResults = renderWatch(program, manifestFilename, startTime, numFrames, interval,
+                                      configSettings, outputDir, platform, goldenDir, verbose)
+        print "%s: %s frames written to %s" % (platform, len(platformResults), outputDir)
+        results += platformResults
+
+if goldenDir:
+    mismatches = reportResults(results)
+    print "%s of %s frames match %s." % (len(results) - mismatches, len(results), goldenDir)
+    if mismatches:
+        sys.exit(1)
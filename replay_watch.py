@@ -0,0 +1,202 @@
+#! /usr/bin/env python
+
+import sys
+import os
+import time
+import getopt
+import subprocess
+from host.host_build import buildHostProgram, readAppinfo, parseTime, parseConfigSettings
+
+help = """
+replay_watch.py
+
+This script replays the watch, as currently configured by
+config_watch.py, over a long stretch of simulated time on the
+development host--a full day, or a full lunar cycle--and reports the
+work done in each simulated hour: the number of frames drawn, layer
+redraws, bitmap decodes, resource cache hits, and heap allocations.
+The real code in src/ is compiled natively against the SDK stand-in
+in host/, and driven by its own timers and tick events, exactly as on
+the watch; but since the host clock is simulated, this runs as fast
+as the host can draw, and the results are fully repeatable.
+
+The results are written as CSV, one row per simulated hour.
+
+replay_watch.py [opts]
+
+Options:
+
+    -p platform[,platform...]
+        Specifies the platform(s) to replay (aplite, basalt, and/or
+        chalk).  The default is all of the platforms targeted by the
+        current build.
+
+    -t "YYYY-MM-DD HH:MM:SS"
+        Specifies the local time at which to start.  The default is
+        2014-07-09 10:09:36, the time used for screenshots.
+
+    -z timezone
+        Specifies the timezone, as in the TZ environment variable.
+        The default is UTC.
+
+    -H hours
+        The number of hours to replay.  The default is 24.
+
+    -l
+        Replay a full lunar cycle, 709 hours.  This is the same as
+        -H 709.
+
+    -a factor
+        Drive the watch from an accelerated clock, running factor
+        times faster than real time, as in a FAST_TIME build.  Each
+        row still covers one simulated hour.
+
+    -f
+        Drive the watch from a fixed clock, held at the start time.
+
+    -T filename
+        Drive the watch from a scripted clock, read from the
+        indicated file.  Each line is of the form "seconds YYYY-MM-DD
+        HH:MM:SS": at the indicated number of seconds into the
+        replay, the clock jumps to the indicated local time, and runs
+        forward from there.  Use this to exercise time changes, such
+        as daylight-saving transitions or a clock set by the phone.
+
+    -k name=value
+        Sends the indicated config setting to the watch before
+        starting, as if it had arrived from the phone.  The name is
+        one of the appKeys in appinfo.json.  May be repeated.
+
+    -o filename
+        Writes the CSV to the indicated file, instead of to stdout.
+
+    -v
+        Verbose: show the compile commands and the watch's log output.
+
+"""
+
+def usage(code, msg = ''):
+    print >> sys.stderr, help
+    print >> sys.stderr, msg
+    sys.exit(code)
+
+# The length of a lunar cycle, rounded up to the hour.
+lunarCycleHours = 709
+
+def writeScript(scriptFilename, outputFilename):
+    """ Converts a human-readable clock script to the form read by
+    replay_watch.c: one "at_ms unix_time" pair per line. """
+
+    output = open(outputFilename, 'w')
+    for line in open(scriptFilename, 'r'):
+        line = line.strip()
+        if not line or line.startswith('#'):
+            continue
+        if ' ' not in line:
+            print >> sys.stderr, "Invalid script line '%s'." % (line)
+            sys.exit(1)
+        offset, timeStr = line.split(' ', 1)
+        print >> output, '%d %d' % (int(float(offset) * 1000), parseTime(timeStr.strip()))
+    output.close()
+
+def replayPlatform(platform, startTime, numHours, factor, fixed, scriptFilename, configSettings, output, writeHeader, verbose):
+    """ Builds and runs the replay for the indicated platform, and
+    writes its rows to output. """
+
+    program, manifestFilename = buildHostProgram(platform, 'replay_watch.c', 'replay_watch', verbose = verbose)
+    cmd = [ program, '-R', manifestFilename, '-t', str(startTime), '-H', str(numHours) ]
+    if factor != 1:
+        cmd += [ '-a', str(factor) ]
+    if fixed:
+        cmd.append('-f')
+    if scriptFilename:
+        hostScript = os.path.join(os.path.dirname(program), 'clock_script.txt')
+        writeScript(scriptFilename, hostScript)
+        cmd += [ '-T', hostScript ]
+    for setting in configSettings:
+        cmd += [ '-k', setting ]
+    if verbose:
+        cmd.append('-v')
+        print >> sys.stderr, ' '.join(cmd)
+
+    process = subprocess.Popen(cmd, stdout = subprocess.PIPE)
+    lines = process.communicate()[0].splitlines()
+    if process.returncode != 0 or not lines:
+        print >> sys.stderr, "Replay failed for %s." % (platform)
+        sys.exit(1)
+
+    if writeHeader:
+        print >> output, 'platform,' + lines[0]
+    for line in lines[1:]:
+        print >> output, '%s,%s' % (platform, line)
+    output.flush()
+
+    print >> sys.stderr, "%s: %s hours" % (platform, len(lines) - 1)
+
+# Main.
+try:
+    opts, args = getopt.getopt(sys.argv[1:], 'p:t:z:H:la:fT:k:o:vh')
+except getopt.error, msg:
+    usage(1, msg)
+
+targetPlatforms = []
+timeStr = '2014-07-09 10:09:36'
+timezone = 'UTC'
+numHours = 24
+factor = 1
+fixed = False
+scriptFilename = None
+configSettings = []
+outputFilename = None
+verbose = False
+for opt, arg in opts:
+    if opt == '-p':
+        targetPlatforms += arg.split(',')
+    elif opt == '-t':
+        timeStr = arg
+    elif opt == '-z':
+        timezone = arg
+    elif opt == '-H':
+        numHours = int(arg)
+    elif opt == '-l':
+        numHours = lunarCycleHours
+    elif opt == '-a':
+        factor = int(arg)
+    elif opt == '-f':
+        fixed = True
+    elif opt == '-T':
+        scriptFilename = arg
+    elif opt == '-k':
+        configSettings.append(arg)
+    elif opt == '-o':
+        outputFilename = arg
+    elif opt == '-v':
+        verbose = True
+    elif opt == '-h':
+        usage(0)
+
+if factor < 1:
+    usage(1, "Invalid factor %s." % (factor))
+if (factor != 1) + fixed + (scriptFilename is not None) > 1:
+    usage(1, "Choose only one of -a, -f, and -T.")
+
+# The timezone applies both to parsing times here, and to localtime()
+# within the replayed watch.
+os.environ['TZ'] = timezone
+time.tzset()
+
+appinfo = readAppinfo()
+if not targetPlatforms:
+    targetPlatforms = appinfo['targetPlatforms']
+
+startTime = parseTime(timeStr)
+configSettings = parseConfigSettings(configSettings, appinfo)
+
+output = sys.stdout
+if outputFilename:
+    output = open(outputFilename, 'w')
+
+writeHeader = True
+for platform in targetPlatforms:
+    replayPlatform(platform, startTime, numHours, factor, fixed, scriptFilename, configSettings, output, writeHeader, verbose)
+    writeHeader = False
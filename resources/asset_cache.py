@@ -0,0 +1,122 @@
+""" asset_cache.py
+
+A content-addressed cache for the generated image resources in
+resources/build.  Each cached asset is keyed on a digest of everything
+that went into making it (the source image pixels, and whatever
+parameters were applied to them), so config_watch.py can restore an
+asset from the cache instead of regenerating it whenever those inputs
+are unchanged, no matter which watch style was configured in between.
+
+The cache is disabled (and every lookup misses) until enable() is
+called.  It is safe to use from the worker processes forked by
+config_watch.py; the hit and miss counts are kept in shared memory.
+"""
+
+import os
+import shutil
+import tempfile
+import hashlib
+import pickle
+import multiprocessing
+
+# Bump this when changing the way any cached asset is generated, to
+# invalidate the existing cache entries.  The RLE encoder is covered
+# separately: any change to make_rle.py invalidates the cache anyway.
+PIPELINE_VERSION = 1
+
+# The kinds of asset in the cache, for the hit and miss counts.
+cacheKinds = [ 'hand', 'moon', 'rle' ]
+
+# The hits and misses for each kind, in pairs.
+cacheStats = multiprocessing.Array('i', 2 * len(cacheKinds))
+
+cacheDir = None
+readCache = True
+
+def _file_digest(pathname):
+    return hashlib.sha1(open(pathname, 'rb').read()).hexdigest()
+
+pipelineDigest = '%s:%s' % (PIPELINE_VERSION, _file_digest(os.path.join(os.path.dirname(os.path.abspath(__file__)), 'make_rle.py')))
+
+def enable(dir, read = True):
+    """ Enables the cache, in the indicated directory.  If read is
+    false, every lookup misses, but newly generated assets are still
+    stored, refreshing the cache. """
+
+    global cacheDir, readCache
+    if not os.path.isdir(dir):
+        os.makedirs(dir)
+    cacheDir = dir
+    readCache = read
+
+def image_digest(image):
+    """ Returns a digest of the pixels of the indicated PIL image,
+    suitable for use as a cache input. """
+
+    h = hashlib.sha1()
+    h.update(repr((image.mode, image.size, image.getpalette(), image.info.get('transparency'))).encode('utf-8'))
+    h.update(image.tobytes())
+    return h.hexdigest()
+
+def cache_key(kind, inputs, filenames):
+    return hashlib.sha1(repr((pipelineDigest, kind, inputs, len(filenames))).encode('utf-8')).hexdigest()
+
+def _count(kind, hit):
+    index = 2 * cacheKinds.index(kind) + (0 if hit else 1)
+    with cacheStats.get_lock():
+        cacheStats[index] += 1
+
+def fetch(kind, inputs, filenames):
+    """ Looks for the asset of the indicated kind made from the
+    indicated inputs.  If it is in the cache, copies its files into
+    place at filenames, and returns the result that was stored with
+    it.  Otherwise, returns None. """
+
+    if not cacheDir:
+        return None
+
+    entryDir = os.path.join(cacheDir, cache_key(kind, inputs, filenames))
+    resultPathname = os.path.join(entryDir, 'result')
+    if not readCache or not os.path.exists(resultPathname):
+        _count(kind, False)
+        return None
+
+    for i in range(len(filenames)):
+        if os.path.islink(filenames[i]):
+            # Replace a link into the source tree (see config_watch.py
+            # -o) rather than writing through it.
+            os.remove(filenames[i])
+        shutil.copyfile(os.path.join(entryDir, str(i)), filenames[i])
+    _count(kind, True)
+    return pickle.load(open(resultPathname, 'rb'))
+
+def store(kind, inputs, filenames, result = True):
+    """ Stores the just-generated files of the asset of the indicated
+    kind made from the indicated inputs, along with the result to
+    return from a future fetch(), which must not be None. """
+
+    if not cacheDir:
+        return
+
+    # Build the entry in a temporary directory, and rename it into
+    # place, so a concurrent fetch() never sees a partial entry.
+    entryDir = os.path.join(cacheDir, cache_key(kind, inputs, filenames))
+    tempDir = tempfile.mkdtemp(dir = cacheDir)
+    for i in range(len(filenames)):
+        shutil.copyfile(filenames[i], os.path.join(tempDir, str(i)))
+    pickle.dump(result, open(os.path.join(tempDir, 'result'), 'wb'))
+    try:
+        os.rename(tempDir, entryDir)
+    except OSError:
+        # Another process stored the same asset first.
+        shutil.rmtree(tempDir)
+
+def report():
+    """ Returns a one-line summary of the cache hits and misses. """
+
+    counts = []
+    for i in range(len(cacheKinds)):
+        hits, misses = cacheStats[2 * i], cacheStats[2 * i + 1]
+        if hits or misses:
+            counts.append('%s %s hits, %s misses' % (cacheKinds[i], hits, misses))
+    return 'asset cache: %s' % ('; '.join(counts) or 'not used')
@@ -1,9 +1,11 @@
 #! /usr/bin/env python
 
 import PIL.Image, PIL.ImageOps
+import numpy
 import sys
 import os
 import shutil
+import asset_cache
 
 help = """
 make_rle.py
@@ -21,6 +23,15 @@ Options:
    -p [aplite|basalt|auto]
       Specify the explicit platform type to generate.  The default is
       "auto", which guesses based on the filename.
+
+   -R weight
+      Trade size against decode speed when choosing the encoding
+      parameters: each unit of estimated decode cost counts as this
+      many bytes.  The default is 0, for the smallest encoding.
+
+   -U
+      Don't try the unscreened (checkerboard-xored) encoding of 1-bit
+      images.
         
 """
 
@@ -28,12 +39,17 @@ Options:
 #         (uint8_t)  width
 #         (uint8_t)  height
 #         (uint8_t)  n (number of chunks of pixels to take at a time; unscreen if 0x80 set)
-#         (uint8_t)  format (see below)
+#         (uint8_t)  format (see below; shared palette if 0x80 set)
 #         (uint16_t) offset to end of rle data (and start of values data if present)
 #         (uint16_t) offset to end of values data (and start of palette data if present)
 
 RLEHeaderSize = 8
 
+# Set in the format byte if the palette isn't stored in the file, but
+# shared with other images and supplied by the decoder; see
+# shared_palette().
+RLESharedPalette = 0x80
+
 # Format codes (almost matches pebble.h):
 GBitmapFormat1Bit        = 0
 GBitmapFormat8Bit        = 1
@@ -45,39 +61,46 @@ GBitmapFormat4BitPalette = 4
 thresholdMask = [0] + [255] * 255
 threshold2Bit = [0] * 64 + [85] * 64 + [170] * 64 + [255] * 64
 
+# The encoder settings; see -R and -U, above.
+speedWeight = 0
+tryUnscreen = True
+
+# If this is set, a line describing each RLE file is appended to this
+# file as it is written; see start_rle_report().
+rleReportPathname = None
+
+
+def unlink_output(pathname):
+    """ Removes the indicated output file before it is written, if it
+    is a symbolic link into the source tree (see config_watch.py -o),
+    so that the new file replaces the link instead of overwriting the
+    source tree's copy. """
+
+    if os.path.islink(pathname):
+        os.remove(pathname)
 
 def usage(code, msg = ''):
     print >> sys.stderr, help
     print >> sys.stderr, msg
     sys.exit(code)
 
-def unscreen(image):
-    """ Returns a new copy of the indicated image xored with a 1x1
-    checkerboard pattern.  The idea is to eliminate this kind of noise
-    from the source image if it happens to be present. """
+def unscreen(pixels, width):
+    """ Returns a new copy of the indicated array of 0/1 pixels xored
+    with a 1x1 checkerboard pattern.  The idea is to eliminate this
+    kind of noise from the source image if it happens to be present.
+    Like unscreen_bitmap() in bwd.c, this only touches the whole bytes
+    within the first width pixels of each row. """
 
-    image = image.copy()
-    w, h = image.size
-    for y in range(h):
-        for x in range(w):
-            if ((x ^ y) & 1):
-                image.putpixel((x, y), 255 - image.getpixel((x, y)))
-    return image
+    h, w = pixels.shape
+    checkerboard = (numpy.arange(h)[:, None] ^ numpy.arange(w)[None, :]) & 1
+    checkerboard[:, (width // 8) * 8:] = 0
+    return pixels ^ checkerboard.astype(numpy.uint8)
 
-def generate_pixels_1bit(image, stride):
-    """ This generator yields a sequence of 0/255 values for the 1-bit
-    pixels of the image.  We extend the row to stride * 8 pixels. """
-
-    w, h = image.size
-    for y in range(h):
-        for x in range(w):
-            value = image.getpixel((x, y))
-            yield value
-        for x in range(w, stride * 8):
-            # Pad out the row with zeroes.
-            yield 0
+def get_pixels_1bit(image):
+    """ Returns a 2-d array of the 0/1 values for the pixels of the
+    1-bit image. """
 
-    raise StopIteration
+    return (numpy.asarray(image.convert('L')) != 0).astype(numpy.uint8)
 
 def pack_argb8(pixel):
     """ Given an (r, g, b, a) tuple returned by PIL, return the Basalt
@@ -99,130 +122,182 @@ def unpack_argb8(value):
     b = ((value) & 0x03) * 0x55
     return (r, g, b, a)
     
-def generate_pixels_8bit(image):
-    """ This generator yields a sequence of 0..255 values for the
-    8-bit pixels of the image. """
+def get_pixels_8bit(image):
+    """ Returns a flat array of the Basalt packed ARGB8 values for the
+    pixels of the RGBA image, as pack_argb8() would compute them. """
+
+    pixels = numpy.asarray(image, dtype = numpy.uint8).reshape(-1, 4)
+    r, g, b, a = pixels[:, 0], pixels[:, 1], pixels[:, 2], pixels[:, 3]
+    values = (a & 0xc0) | ((r & 0xc0) >> 2) | ((g & 0xc0) >> 4) | ((b & 0xc0) >> 6)
+    values[a == 0] = 0
+    return values
+
+def get_pixels_palette(image, palette):
+    """ Returns a flat array of the 0..n indexes into the palette of
+    the pixels of the RGBA image. """
+
+    def pack_rgba(pixels):
+        pixels = pixels.astype(numpy.uint32)
+        return (pixels[:, 0] << 24) | (pixels[:, 1] << 16) | (pixels[:, 2] << 8) | pixels[:, 3]
+
+    keys = pack_rgba(numpy.asarray(image, dtype = numpy.uint8).reshape(-1, 4))
+    paletteKeys = pack_rgba(numpy.array(palette, dtype = numpy.uint8).reshape(-1, 4))
+
+    order = numpy.argsort(paletteKeys, kind = 'mergesort')
+    positions = numpy.searchsorted(paletteKeys[order], keys)
+    indexes = order[numpy.minimum(positions, len(order) - 1)]
+    assert (paletteKeys[indexes] == keys).all()
+    return indexes
+
+def run_lengths(values):
+    """ Returns (starts, lengths), the start index and length of each
+    run of equal values in the 1-d array. """
+
+    if len(values) == 0:
+        return numpy.zeros(0, dtype = numpy.int64), numpy.zeros(0, dtype = numpy.int64)
+
+    boundaries = numpy.flatnonzero(values[1:] != values[:-1]) + 1
+    starts = numpy.concatenate(([0], boundaries))
+    lengths = numpy.diff(numpy.concatenate((starts, [len(values)])))
+    return starts, lengths
+
+def rle_1bit(pixels):
+    """ Returns the run lengths of a binary (B&W) input--the input is
+    either 0 or nonzero, so the rle is a simple sequence of positive
+    numbers representing alternate values, and explicit values are not
+    necessary. """
 
-    w, h = image.size
-    for y in range(h):
-        for x in range(w):
-            value = pack_argb8(image.getpixel((x, y)))
-            yield value
-
-    raise StopIteration
-
-def generate_pixels_palette(image, palette):
-    """ This generator yields a sequence of 0..n values for the pixels
-    of the image, indexing into the palette. """
-
-    w, h = image.size
-    for y in range(h):
-        for x in range(w):
-            pixel = image.getpixel((x, y))
-            value = palette.index(pixel)
-            assert value != -1
-            yield value
-
-    raise StopIteration
-
-def generate_rle_1bit(source):
-    """ This generator yields a sequence of run lengths of a binary
-    (B&W) input--the input is either 0 or nonzero, so the rle is a
-    simple sequence of positive numbers representing alternate values,
-    and explicit values are not necessary. """
-
-    current = 0
-    count = 0
     # We start with an implicit black pixel, which isn't actually part
     # of the image.  The decoder must discard this pixel.  This
     # implicit black pixel ensures that there are no 0 counts anywhere
     # in the resulting data.
-    next = 0
-    while True:
-        while current == next:
-            count += 1
-            try:
-                next = source.next()
-            except StopIteration:
-                yield count
-                raise StopIteration
-        yield count
-        current = next
-        count = 0
-
-def generate_rle_pairs(source):
-    """ This generator yields a sequence of run lengths of a color
-    input--the input is a sequence of numeric values, so the rle is a
-    sequence of (value, count) pairs. """
-
-    current = source.next()
-    count = 0
-    next = current
-    while True:
-        while current == next:
-            count += 1
-            try:
-                next = source.next()
-            except StopIteration:
-                yield (current, count)
-                raise StopIteration
-        yield (current, count)
-        current = next
-        count = 0
-
-def count_bits(num):
-    count = 0
-    while num >= (1 << count):
-        count += 1
-    return count
-
-def chop_rle(source, n):
-    """ Separates the rle lengths sequence into a sequence of n-bit
+    values = numpy.concatenate(([False], pixels.ravel() != 0))
+    starts, lengths = run_lengths(values)
+    return lengths
+
+def rle_pairs(pixels):
+    """ Returns the run lengths of a color input--the input is a
+    sequence of numeric values, so the rle is a pair of sequences,
+    (values, counts). """
+
+    starts, lengths = run_lengths(pixels)
+    return pixels[starts], lengths
+
+def chop_rle(rle, n):
+    """ Separates the rle lengths sequence into an array of n-bit
     chunks.  If a value is too large to fit into a single chunk, a
     series of 0-valued chunks will introduce it. """
 
-    result = ''
-    for v in source:
-        # Count the minimum number of chunks we need to represent v.
-        numChunks = (count_bits(v) + n - 1) / n
+    rle = numpy.asarray(rle, dtype = numpy.int64)
+    assert (rle > 0).all()
+
+    # Count the minimum number of chunks we need to represent each v.
+    bits = numpy.zeros(len(rle), dtype = numpy.int64)
+    for b in range(32):
+        bits += ((rle >> b) != 0)
+    numChunks = (bits + n - 1) // n
+
+    # We write out numChunks - 1 zeroes to introduce each v, then its
+    # chunks, most significant first.
+    ends = numpy.cumsum(2 * numChunks - 1)
+    firstChunks = ends - numChunks
+    result = numpy.zeros(ends[-1] if len(rle) else 0, dtype = numpy.uint8)
+    mask = (1 << n) - 1
+    for x in range(numChunks.max() if len(rle) else 0):
+        sel = (numChunks > x)
+        result[firstChunks[sel] + x] = (rle[sel] >> ((numChunks[sel] - x - 1) * n)) & mask
 
-        # We write out a number of zeroes to indicate this.
-        zeroCount = numChunks - 1
-        for z in range(zeroCount):
-            yield 0
-            
-        mask = (1 << n) - 1
-        for x in range(numChunks):
-            b = (v >> ((numChunks - x - 1) * n)) & mask
-            assert b != 0 or x != 0
-            yield b
+    return result
 
-def pack_rle(source, n):
+def pack_rle(chunks, n):
     """ Packs a sequence of n-bit chunks into a byte string. """
-    seq = list(source)
-    result = ''
-    if n == 1:
-        seq += [0, 0, 0, 0, 0, 0, 0]
-        for i in range(0, len(seq) - 7, 8):
-            v = (seq[i + 0] << 7) | (seq[i + 1] << 6) | (seq[i + 2] << 5) | (seq[i +3] << 4) | (seq[i + 4] << 3) | (seq[i + 5] << 2) | (seq[i + 6] << 1) | (seq[i + 7])
-            result += (chr(v))
-    elif n == 2:
-        seq += [0, 0, 0]
-        for i in range(0, len(seq) - 3, 4):
-            v = (seq[i + 0] << 6) | (seq[i + 1] << 4) | (seq[i + 2] << 2) | (seq[i + 3])
-            result += (chr(v))
-    elif n == 4:
-        seq += [0]
-        for i in range(0, len(seq) - 1, 2):
-            v = (seq[i + 0] << 4) | (seq[i + 1])
-            result += (chr(v))
-    elif n == 8:
-        for v in seq:
-            result += chr(v)
-    else:
+
+    if n not in [1, 2, 4, 8]:
         raise ValueError
 
-    return result
+    chunksPerByte = 8 // n
+    chunks = numpy.asarray(chunks, dtype = numpy.uint8)
+    padding = numpy.zeros((-len(chunks)) % chunksPerByte, dtype = numpy.uint8)
+    chunks = numpy.concatenate((chunks, padding)).reshape(-1, chunksPerByte)
+
+    result = numpy.zeros(len(chunks), dtype = numpy.uint8)
+    for i in range(chunksPerByte):
+        result |= chunks[:, i] << (8 - n * (i + 1))
+
+    return result.tobytes()
+
+def decode_cost(numChunks, numRuns, numBytes, unscreenBytes):
+    """ Estimates the work rle_bwd_create() in bwd.c does to decode an
+    rle stream, in rough units of one loop iteration: one for each
+    chunk and each byte it reads, two for each run it packs (the
+    per-pixel work is the same for any encoding, so it's left out),
+    and one for each byte of the unscreen pass, if any. """
+
+    return numChunks + numBytes + 2 * numRuns + unscreenBytes
+
+def choose_rle_encoding(rle_normal, rle_unscreened, unscreenBytes):
+    """ Tries each legal chunk size n for the run lengths rle_normal,
+    and for rle_unscreened as well unless it is None, and returns (n,
+    result, cost) for the encoding with the smallest size plus
+    speedWeight times its decode cost, preferring the cheaper decode
+    on a tie.  The returned n has 0x80 set if it's the unscreened
+    encoding. """
+
+    best = None
+    for n in [1, 2, 4, 8]:
+        for flag, rle, extraCost in [(0, rle_normal, 0), (0x80, rle_unscreened, unscreenBytes)]:
+            if rle is None:
+                continue
+            chunks = chop_rle(rle, n)
+            result = pack_rle(chunks, n)
+            cost = decode_cost(len(chunks), len(rle), len(result), extraCost)
+            score = (len(result) + speedWeight * cost, cost)
+            if best is None or score < best[0]:
+                best = (score, n | flag, result, cost)
+
+    score, n, result, cost = best
+    return n, result, cost
+
+def report_rle(entry):
+    """ Appends the indicated (rleFilename, format, n, size, fullSize,
+    cost) entry to the RLE report, if there is one.  Each entry is a
+    single short write, so concurrent processes can share the file. """
+
+    if rleReportPathname:
+        rleFilename, format, n, size, fullSize, cost = entry
+        line = '%s %s %s %s %s %s %s\n' % (rleFilename, format, n & 0x7f, int(bool(n & 0x80)), size, fullSize, cost)
+        report = open(rleReportPathname, 'a')
+        report.write(line)
+        report.close()
+
+def start_rle_report(pathname):
+    """ Starts a new RLE report in the indicated file. """
+
+    global rleReportPathname
+    rleReportPathname = pathname
+    open(pathname, 'w').close()
+
+def finish_rle_report():
+    """ Sorts the entries in the RLE report, and adds a header and the
+    totals.  Returns the totals line. """
+
+    lines = sorted(set(open(rleReportPathname, 'r').readlines()))
+    totalSize = totalFullSize = totalCost = 0
+    for line in lines:
+        fields = line.split()
+        totalSize += int(fields[4])
+        totalFullSize += int(fields[5])
+        totalCost += int(fields[6])
+
+    totals = '%s rle files: %s bytes (vs. %s unpacked), decode cost %s' % (len(lines), totalSize, totalFullSize, totalCost)
+    report = open(rleReportPathname, 'w')
+    report.write('# Written by make_rle.py.  Each line is: filename format n unscreen\n')
+    report.write('# bytes unpacked_bytes decode_cost (see decode_cost()).\n')
+    report.write('# speedWeight = %s, tryUnscreen = %s\n' % (speedWeight, tryUnscreen))
+    report.write('# %s\n' % (totals))
+    report.writelines(lines)
+    report.close()
+    return totals
 
 class Rl2Unpacker:
     """ This class reverses chop_rle() and pack_rle()--it reads a
@@ -329,28 +404,21 @@ def make_rle_image_1bit(rleFilename, image):
         image = im2
 
     assert w <= 0xff and h <= 0xff
-    unscreened = unscreen(image)
+    pixels = get_pixels_1bit(image)
 
     # The number of bytes in a row.  Must be a multiple of 4, per
     # Pebble conventions.
     stride = ((w + 31) / 32) * 4
     assert stride <= 0xff
+    assert pixels.shape == (h, stride * 8)
 
-    rle_normal = list(generate_rle_1bit(generate_pixels_1bit(image, stride)))
-    rle_unscreened = list(generate_rle_1bit(generate_pixels_1bit(unscreened, stride)))
+    rle_normal = rle_1bit(pixels)
+    rle_unscreened = None
+    if tryUnscreen and w_orig >= 8:
+        rle_unscreened = rle_1bit(unscreen(pixels, w_orig))
 
     # Find the best n for this image.
-    result = None
-    n = None
-    for n0 in [1, 0x81, 2, 4, 8]:
-        rle = rle_normal
-        if n0 & 0x80:
-            rle = rle_unscreened
-        result0 = pack_rle(chop_rle(rle, n0 & 0x7f), n0 & 0x7f)
-        #print n0, len(result0)
-        if result is None or len(result0) < len(result):
-            result = result0
-            n = n0
+    n, result, cost = choose_rle_encoding(rle_normal, rle_unscreened, h * (w_orig / 8))
 
     vo = RLEHeaderSize + len(result)
     assert(vo < 0x10000)
@@ -361,27 +429,28 @@ def make_rle_image_1bit(rleFilename, image):
     unpacker = Rl2Unpacker(result, n & 0x7f, zero_expands = True)
     verify = unpacker.getList()
     if n & 0x80:
-        assert verify == rle_unscreened
-        pixels = list(generate_pixels_1bit(unscreened, stride))
+        assert verify == rle_unscreened.tolist()
     else:
-        assert verify == rle_normal
-        pixels = list(generate_pixels_1bit(image, stride))
+        assert verify == rle_normal.tolist()
 
     format = GBitmapFormat1Bit
 
     #print "n = %s, format = %s, vo = %s, po = %s" % (n, format, vo, vo)
 
+    unlink_output(rleFilename)
     rle = open(rleFilename, 'wb')
     rle.write('%c%c%c%c%c%c%c%c' % (w_orig, h, n, format, vo_lo, vo_hi, vo_lo, vo_hi))
     rle.write(result)
     rle.close()
     
     print '%s: %s, %s vs. %s' % (rleFilename, format, 8 + len(result), fullSize)
+    return (rleFilename, format, n, 8 + len(result), fullSize, cost)
 
-def make_rle_image_basalt(rleFilename, image):
-    image = image.convert('RGBA')
-    w, h = image.size
+def reduce_colors(image):
+    """ Returns the RGBA image reduced to Basalt's 64 colors (and 4
+    alpha levels), and black wherever it is transparent. """
 
+    image = image.convert('RGBA')
     r, g, b, a = image.split()
 
     # Ensure that the RGB image is black anywhere the alpha
@@ -398,35 +467,80 @@ def make_rle_image_basalt(rleFilename, image):
     b = b.point(threshold2Bit)
     a = a.point(threshold2Bit)
 
-    image = PIL.Image.merge('RGBA', [r, g, b, a])
-    
-    # Check the number of unique colors in the image to determine the
-    # precise image type.
-    colors = image.getcolors(16)
-
-    if colors is None:
-        # We have a full-color image.
-        palette = None
-        format = GBitmapFormat8Bit
-        vn = 8
+    return PIL.Image.merge('RGBA', [r, g, b, a])
+
+def palette_format(numColors):
+    """ Returns (format, vn), the format code and bits per pixel for a
+    palettized image of the indicated number of colors. """
+
+    if numColors <= 2:
+        return GBitmapFormat1BitPalette, 1
+    elif numColors <= 4:
+        return GBitmapFormat2BitPalette, 2
+    else:
+        return GBitmapFormat4BitPalette, 4
+
+def shared_palette(images):
+    """ Returns a palette, as a sorted list of packed ARGB8 values,
+    that can be shared by all of the indicated images (for instance,
+    the rotations of one hand), or None if they shouldn't share one:
+    if the images aren't all palettized, if there are too many colors
+    among them, or if sharing would cost any image a deeper format
+    than it would use with its own palette. """
+
+    maxFormat = GBitmapFormat1Bit
+    union = set()
+    for image in images:
+        colors = reduce_colors(image).getcolors(16)
+        if colors is None:
+            return None
+        format, vn = palette_format(len(colors))
+        maxFormat = max(maxFormat, format)
+        union |= set([pack_argb8(pixel) for count, pixel in colors])
+
+    if not union or len(union) > 16:
+        return None
+    if union <= set([0xc0, 0xff]):
+        # These are all B&W images, which need no palette at all.
+        return None
+    format, vn = palette_format(len(union))
+    if format > maxFormat:
+        return None
+    return sorted(union)
+
+def make_rle_image_basalt(rleFilename, image, palette = None):
+    """ Encodes the image for Basalt or Chalk.  If palette is not
+    None, it is a shared palette from shared_palette() that includes
+    all of the image's colors; the image is encoded with indexes into
+    it, and the palette itself is left out of the file. """
+
+    image = reduce_colors(image)
+    w, h = image.size
+
+    sharedPalette = palette
+    if sharedPalette is not None:
+        # We have an image that uses a shared palette.
+        format, vn = palette_format(len(sharedPalette))
     else:
-        # We have a palettized image.
-        palette = zip(*colors)[1]
-        if len(palette) <= 2:
-            pixel0 = pack_argb8(palette[0])
-            pixel1 = pack_argb8(palette[-1])
-            if pixel0 in [0xc0, 0xff] and pixel1 in [0xc0, 0xff]:
-                # This is a special case: it's really a 1-bit B&W image.
-                return make_rle_image_1bit(rleFilename, image)
-            # It's a 1-bit image with two specific colors.
-            format = GBitmapFormat1BitPalette
-            vn = 1
-        elif len(palette) <= 4:
-            format = GBitmapFormat2BitPalette
-            vn = 2
+        # Check the number of unique colors in the image to determine
+        # the precise image type.
+        colors = image.getcolors(16)
+
+        if colors is None:
+            # We have a full-color image.
+            palette = None
+            format = GBitmapFormat8Bit
+            vn = 8
         else:
-            format = GBitmapFormat4BitPalette
-            vn = 4
+            # We have a palettized image.
+            palette = zip(*colors)[1]
+            if len(palette) <= 2:
+                pixel0 = pack_argb8(palette[0])
+                pixel1 = pack_argb8(palette[-1])
+                if pixel0 in [0xc0, 0xff] and pixel1 in [0xc0, 0xff]:
+                    # This is a special case: it's really a 1-bit B&W image.
+                    return make_rle_image_1bit(rleFilename, image)
+            format, vn = palette_format(len(palette))
 
     pixels_per_byte = 8 / vn
     stride = (w + pixels_per_byte - 1) / pixels_per_byte
@@ -444,40 +558,35 @@ def make_rle_image_basalt(rleFilename, image):
         im2.paste(image, (0, 0))
         image = im2
 
-    if palette is None:
+    if sharedPalette is not None:
+        # Index into the shared palette, by packed ARGB8 value.
+        values8 = get_pixels_8bit(image)
+        pixels = numpy.searchsorted(sharedPalette, values8)
+        assert (numpy.array(sharedPalette)[numpy.minimum(pixels, len(sharedPalette) - 1)] == values8).all()
+    elif palette is None:
         # Full-color image, no palette.
-        pixels = generate_pixels_8bit(image)
+        pixels = get_pixels_8bit(image)
     else:
         # Index into a palette.
-        pixels = generate_pixels_palette(image, palette)
+        pixels = get_pixels_palette(image, palette)
 
     if vn == 1:
         # With a 1-bit image, no need to record a values list.
         values = []
-        rle = generate_rle_1bit(pixels)
+        rle = rle_1bit(pixels)
     else:
         # With an n-bit image, the values list can't be inferred and
         # must be explicitly stored.
-        values_rle = generate_rle_pairs(pixels)
-        values, rle = zip(*list(values_rle))
-
-    rle = list(rle)
+        values, rle = rle_pairs(pixels)
 
-    # Find the best n for this image.
-    result = None
-    n = None
-    for n0 in [1, 2, 4, 8]:
-        im = image
-        result0 = pack_rle(chop_rle(rle, n0 & 0x7f), n0 & 0x7f)
-        #print n0, len(result0)
-        if result is None or len(result0) < len(result):
-            result = result0
-            n = n0
+    # Find the best n for this image.  (The values are always packed
+    # vn bits at a time; the decoder infers vn from the format.)
+    n, result, cost = choose_rle_encoding(rle, None, 0)
 
     # Verify the result matches.
     unpacker = Rl2Unpacker(result, n & 0x7f, zero_expands = True)
     verify = unpacker.getList()
-    assert verify == rle
+    assert verify == rle.tolist()
 
     # Get the offset into the file at which the values start.
     vo = RLEHeaderSize + len(result)
@@ -486,6 +595,7 @@ def make_rle_image_basalt(rleFilename, image):
     vo_hi = (vo >> 8) & 0xff
 
     values_result = pack_rle(values, vn)
+    cost += len(values) + len(values_result)
 
     # Also get the offset into the file at which the palette starts.
     po = vo + len(values_result)
@@ -495,30 +605,46 @@ def make_rle_image_basalt(rleFilename, image):
 
     #print "n = %s, format = %s, vo = %s, po = %s" % (n, format, vo, po)
 
+    formatByte = format
+    if sharedPalette is not None:
+        formatByte |= RLESharedPalette
+
+    unlink_output(rleFilename)
     rle = open(rleFilename, 'wb')
-    rle.write('%c%c%c%c%c%c%c%c' % (w_orig, h, n, format, vo_lo, vo_hi, po_lo, po_hi))
+    rle.write('%c%c%c%c%c%c%c%c' % (w_orig, h, n, formatByte, vo_lo, vo_hi, po_lo, po_hi))
     rle.write(result)
     assert rle.tell() == vo
     rle.write(values_result)
-    if palette is not None:
+    if sharedPalette is None and palette is not None:
         assert rle.tell() == po
         for pixel in palette:
             rle.write(chr(pack_argb8(pixel)))
-            
+    size = rle.tell()
     rle.close()
     
     print '%s: %s, %s vs. %s' % (rleFilename, format, 8 + len(result) + len(values), fullSize)
+    return (rleFilename, format, n, size, fullSize, cost)
             
-def make_rle_image(rleFilename, image, platformType = 'auto'):
+def make_rle_image(rleFilename, image, platformType = 'auto', palette = None):
     if platformType == 'auto' and rleFilename.find('~bw') != -1:
         platformType = 'aplite'
 
-    if platformType == 'aplite':
-        return make_rle_image_1bit(rleFilename, image)
-    else:
-        return make_rle_image_basalt(rleFilename, image)
+    # The encoding depends only on the pixels (and the shared palette,
+    # if any), so we can reuse a cached encoding of the same image
+    # made under any filename.
+    inputs = (platformType, asset_cache.image_digest(image), speedWeight, tryUnscreen)
+    if palette is not None:
+        inputs += (tuple(palette),)
+    entry = asset_cache.fetch('rle', inputs, [rleFilename])
+    if entry is None:
+        if platformType == 'aplite':
+            entry = make_rle_image_1bit(rleFilename, image)
+        else:
+            entry = make_rle_image_basalt(rleFilename, image, palette = palette)
+        asset_cache.store('rle', inputs, [rleFilename], entry)
+    report_rle((rleFilename,) + tuple(entry[1:]))
 
-def make_rle(filename, prefix = 'resources/', useRle = True, platformType = 'auto', modes = []):
+def make_rle(filename, prefix = 'resources/', useRle = True, platformType = 'auto', modes = [], palette = None):
     if useRle:
         basename, ext = os.path.splitext(filename)
         for mode in modes:
@@ -526,13 +652,13 @@ def make_rle(filename, prefix = 'resources/', useRle = True, platformType = 'aut
             if os.path.exists(prefix + basename + mode + ext):
                 image = PIL.Image.open(prefix + basename + mode + ext)
                 rleFilename = basename + mode + '.rle'
-                make_rle_image(prefix + rleFilename, image, platformType = platformType)
+                make_rle_image(prefix + rleFilename, image, platformType = platformType, palette = palette)
 
         # Primary file.
         rleFilename = basename + '.rle'
         if os.path.exists(prefix + basename + ext):
             image = PIL.Image.open(prefix + filename)
-            make_rle_image(prefix + rleFilename, image, platformType = platformType)
+            make_rle_image(prefix + rleFilename, image, platformType = platformType, palette = palette)
         return rleFilename, 'raw'
     else:
         ptype = 'png'
@@ -578,13 +704,16 @@ def make_rle_trans_file(filename, prefix = 'resources/', useRle = True, platform
             rleWhiteFilename = basename + '_white' + mode + '.rle'
             rleBlackFilename = basename + '_black' + mode + '.rle'
             make_rle_image(prefix + rleWhiteFilename, image, platformType = platformType)
+            unlink_output(prefix + rleBlackFilename)
             open(prefix + rleBlackFilename, 'wb')
             return rleWhiteFilename, rleBlackFilename, 'raw'
         else:
             rleWhiteFilename = basename + '_white' + mode + '.png'
+            unlink_output(prefix + rleWhiteFilename)
             shutil.copyfile(prefix + filename, prefix + rleWhiteFilename)
             rleBlackFilename = basename + '_black' + mode + '.png'
             image = PIL.Image.new('1', (1, 1), 0)
+            unlink_output(prefix + rleBlackFilename)
             image.save(prefix + rleBlackFilename)
             return rleWhiteFilename, rleBlackFilename, 'png'
             
@@ -611,13 +740,19 @@ def make_rle_trans_file(filename, prefix = 'resources/', useRle = True, platform
         return rleWhiteFilename, rleBlackFilename, 'raw'
     else:
         rleWhiteFilename = basename + '_white' + mode + '.png'
+        unlink_output(prefix + rleWhiteFilename)
         white.save(prefix + rleWhiteFilename)
         rleBlackFilename = basename + '_black' + mode + '.png'
+        unlink_output(prefix + rleBlackFilename)
         black.save(prefix + rleBlackFilename)
         print filename
         return rleWhiteFilename, rleBlackFilename, 'pbi'
 
-def unpack_rle_file(rleFilename):
+def unpack_rle_file(rleFilename, sharedPalette = None):
+    """ Decodes the .rle file back to an image.  If the file was
+    encoded with a shared palette, sharedPalette must be that palette,
+    as returned by shared_palette(). """
+
     rb = open(rleFilename, 'rb')
     width = ord(rb.read(1))
     height = ord(rb.read(1))
@@ -633,6 +768,10 @@ def unpack_rle_file(rleFilename):
     do_unscreen = ((n & 0x80) != 0)
     n = n & 0x7f
 
+    useSharedPalette = ((format & RLESharedPalette) != 0)
+    format = format & ~RLESharedPalette
+    assert not useSharedPalette or sharedPalette is not None
+
     #print "n = %s, format = %s, vo = %s, po = %s" % (n, format, vo, po)
 
     if (format == GBitmapFormat1Bit or format == GBitmapFormat1BitPalette):
@@ -666,6 +805,8 @@ def unpack_rle_file(rleFilename):
     values_data = rb.read(po - vo)
     assert(po == rb.tell())
     palette = map(ord, rb.read())
+    if useSharedPalette:
+        palette = list(sharedPalette)
 
     # Unpack values_data into the list of values.
     unpacker = Rl2Unpacker(values_data, vn, zero_expands = False)
@@ -750,7 +891,7 @@ if __name__ == '__main__':
     import getopt
 
     try:
-        opts, args = getopt.getopt(sys.argv[1:], 'tp:uh')
+        opts, args = getopt.getopt(sys.argv[1:], 'tp:uR:Uh')
     except getopt.error, msg:
         usage(1, msg)
 
@@ -764,6 +905,10 @@ if __name__ == '__main__':
             platformType = arg
         elif opt == '-u':
             doUnpack = True
+        elif opt == '-R':
+            speedWeight = float(arg)
+        elif opt == '-U':
+            tryUnscreen = False
         elif opt == '-h':
             usage(0)
 
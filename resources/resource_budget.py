@@ -0,0 +1,245 @@
+""" resource_budget.py
+
+Estimates the resource and memory budget of a configured watch, for
+config_watch.py.  For each target platform, this lists every resource
+in the generated appinfo.json with its size in the resource pack and
+the heap it occupies once decoded, works out the heap that the second
+hand resource caches (SECOND_RESOURCE_CACHE_SIZE and friends) will
+eventually fill, and adds up the worst-case heap in use at any one
+time.  The result is written as JSON, so a build script can check it.
+
+The estimates follow the decoding code in src/bwd.c and the bitmap
+layout in host/pebble_host.c; they count only the bitmap data and
+palettes, not the heap overhead of each allocation, nor fonts, which
+are managed by the system.  Treat the totals as a lower bound on the
+real heap use.
+"""
+
+import os
+import re
+import json
+import PIL.Image
+from host import host_build
+
+# The format codes in an RLE header; see make_rle.py.
+GBitmapFormat1Bit        = 0
+GBitmapFormat8Bit        = 1
+GBitmapFormat1BitPalette = 2
+GBitmapFormat2BitPalette = 3
+GBitmapFormat4BitPalette = 4
+RLESharedPalette         = 0x80
+
+# The screen size of each platform, for the saved copy of the
+# framebuffer, and the framebuffer's format.
+screenSizes = {
+    'aplite' : ((144, 168), GBitmapFormat1Bit),
+    'basalt' : ((144, 168), GBitmapFormat8Bit),
+    'chalk' : ((180, 180), GBitmapFormat8Bit),
+    }
+
+# Resources that are never loaded together.  Each of these groups
+# shares a single slot on the heap, which holds the largest of them.
+# Numbered resources (CLOCK_FACE_0, HOUR_3_MASK, ...) already share a
+# slot with the other resources of the same name.
+sharedSlots = {
+    'MOON_WHEEL_WHITE' : 'MOON_WHEEL',
+    'MOON_WHEEL_BLACK' : 'MOON_WHEEL',
+    'CHRONO_DIAL_TENTHS_WHITE' : 'CHRONO_DIAL_WHITE',
+    'CHRONO_DIAL_HOURS_WHITE' : 'CHRONO_DIAL_WHITE',
+    'CHRONO_DIAL_TENTHS_BLACK' : 'CHRONO_DIAL_BLACK',
+    'CHRONO_DIAL_HOURS_BLACK' : 'CHRONO_DIAL_BLACK',
+    }
+
+# The slot that also holds the saved copy of the framebuffer, which
+# wright.c allocates only after it has freed the face bitmap.
+faceSlot = 'CLOCK_FACE'
+
+def row_size_bytes(format, width):
+    """ Returns the bytes per row of a decoded bitmap, as in
+    gbitmap_create_blank(). """
+
+    if format == GBitmapFormat1Bit:
+        # The native 1-bit format is padded to a word boundary.
+        return ((width + 31) / 32) * 4
+    elif format == GBitmapFormat1BitPalette:
+        return (width + 7) / 8
+    elif format == GBitmapFormat2BitPalette:
+        return (width + 3) / 4
+    elif format == GBitmapFormat4BitPalette:
+        return (width + 1) / 2
+    else:
+        return width
+
+paletteCounts = {
+    GBitmapFormat1BitPalette : 2,
+    GBitmapFormat2BitPalette : 4,
+    GBitmapFormat4BitPalette : 16,
+    }
+
+def bitmap_size(format, width, height):
+    """ Returns the heap used by the data and palette of a decoded
+    bitmap of the indicated format and size. """
+    return row_size_bytes(format, width) * height + paletteCounts.get(format, 0)
+
+def decoded_size(type, pathname, platform):
+    """ Returns the heap occupied by the indicated resource once it
+    has been loaded on the indicated platform, or None if it isn't
+    loaded onto the heap. """
+
+    if type == 'font' or not os.path.exists(pathname):
+        return None
+
+    if pathname.endswith('.rle'):
+        header = bytearray(open(pathname, 'rb').read(4))
+        if len(header) < 4:
+            # An empty placeholder, such as the black half of a
+            # make_rle_trans() pair on a color platform.
+            return None
+        width, height, n, format = header
+        if format & RLESharedPalette:
+            # The palette is shared with the other rotations of the
+            # hand, and lives in the HandCache, not on the heap.
+            format &= ~RLESharedPalette
+            return bitmap_size(format, width, height) - paletteCounts.get(format, 0)
+        return bitmap_size(format, width, height)
+
+    if type in ['png', 'pbi']:
+        # A png is decoded to the platform's native format.
+        width, height = PIL.Image.open(pathname).size
+        if platform == 'aplite':
+            return bitmap_size(GBitmapFormat1Bit, width, height)
+        return bitmap_size(GBitmapFormat8Bit, width, height)
+
+    # Any other raw resource (e.g. the date names) is read into a
+    # static buffer.
+    return None
+
+def slot_name(name):
+    """ Returns the name of the heap slot that holds the indicated
+    resource while it is loaded. """
+    group = re.sub('_[0-9]+(_MASK)?$', '\\1', name)
+    return sharedSlots.get(group, group)
+
+def cached_resources(media, firstName, cacheSize):
+    """ Returns the resources that a resource cache of the indicated
+    size, indexed from the resource named firstName, will eventually
+    hold, following rle_bwd_create_with_cache(). """
+
+    names = [entry[1] for entry in media]
+    if cacheSize == 0 or firstName not in names:
+        return []
+    first = names.index(firstName)
+    return media[first:first + cacheSize]
+
+def resource_cache_sizes(platform, cacheSizes, limitCache, limitCacheAplite):
+    """ Returns the numbers of entries in the second and chrono_second
+    resource caches on the indicated platform, as defined in
+    generated_config.h. """
+
+    if limitCache or (limitCacheAplite and platform == 'aplite'):
+        return { 'second' : 0, 'chrono_second' : 0 }
+
+    numSecond, numSecondMask = cacheSizes['second']
+    numChronoSecond, numChronoSecondMask = cacheSizes['chrono_second']
+    if platform == 'aplite':
+        # Aplite caches the second hand masks, but not the
+        # chrono_second hand at all.
+        return { 'second' : numSecond + numSecondMask, 'chrono_second' : 0 }
+    return { 'second' : numSecond, 'chrono_second' : numChronoSecond }
+
+def platform_budget(appinfo, platform, cacheSizes, limitCache, limitCacheAplite, projectDir):
+    """ Returns the budget report for one platform, as a dictionary. """
+
+    menuIcons = set([entry['name'] for entry in appinfo['resources']['media'] if entry.get('menuIcon')])
+    media = host_build.getPlatformMedia(appinfo, platform, projectDir)
+    resourcesDir = os.path.join(projectDir, 'resources')
+
+    resources = []
+    decoded = {}
+    slots = {}
+    totalBytes = 0
+    for resourceId, name, type, pathname in media:
+        numBytes = os.path.getsize(pathname) if os.path.exists(pathname) else 0
+        totalBytes += numBytes
+        decodedBytes = None
+        if name not in menuIcons:
+            decodedBytes = decoded_size(type, pathname, platform)
+        decoded[name] = decodedBytes or 0
+        entry = {
+            'id' : resourceId,
+            'name' : name,
+            'type' : type,
+            'file' : os.path.relpath(pathname, resourcesDir),
+            'bytes' : numBytes,
+            'decoded_bytes' : decodedBytes,
+            }
+        if decodedBytes is not None:
+            slot = slot_name(name)
+            entry['slot'] = slot
+            if decodedBytes > slots.get(slot, (None, 0))[1]:
+                slots[slot] = (name, decodedBytes)
+        resources.append(entry)
+
+    (width, height), format = screenSizes[platform]
+    framebufferBytes = bitmap_size(format, width, height)
+    if framebufferBytes > slots.get(faceSlot, (None, 0))[1]:
+        slots[faceSlot] = ('framebuffer', framebufferBytes)
+
+    cacheEntries = resource_cache_sizes(platform, cacheSizes, limitCache, limitCacheAplite)
+    caches = {}
+    cacheBytes = 0
+    for hand in ['second', 'chrono_second']:
+        cached = cached_resources(media, '%s_0' % (hand.upper()), cacheEntries[hand])
+        bytes = sum([decoded[entry[1]] for entry in cached])
+        caches[hand] = {
+            'entries' : cacheEntries[hand],
+            'bytes' : bytes,
+            }
+        cacheBytes += bytes
+
+    slotBytes = sum([bytes for name, bytes in slots.values()])
+    return {
+        'resources' : resources,
+        'resource_count' : len(resources),
+        'resource_bytes' : totalBytes,
+        'decoded_bytes' : sum(decoded.values()),
+        'resource_caches' : caches,
+        'heap' : {
+            'slots' : dict([(slot, { 'resource' : name, 'bytes' : bytes }) for slot, (name, bytes) in slots.items()]),
+            'slot_bytes' : slotBytes,
+            'resource_cache_bytes' : cacheBytes,
+            'worst_case_bytes' : slotBytes + cacheBytes,
+            },
+        }
+
+def make_budget(platforms, cacheSizes, limitCache, limitCacheAplite, heapBudget, projectDir = host_build.rootDir):
+    """ Returns the budget report for each of the indicated platforms,
+    from the generated appinfo.json in projectDir.  heapBudget maps
+    each platform to its limit on the worst-case heap, if any. """
+
+    appinfo = host_build.readAppinfo(projectDir)
+    report = { 'platforms' : {} }
+    for platform in platforms:
+        budget = platform_budget(appinfo, platform, cacheSizes, limitCache, limitCacheAplite, projectDir)
+        limit = heapBudget.get(platform)
+        budget['heap']['budget'] = limit
+        budget['heap']['over_budget'] = limit is not None and budget['heap']['worst_case_bytes'] > limit
+        report['platforms'][platform] = budget
+    return report
+
+def write_budget(report, pathname):
+    json.dump(report, open(pathname, 'w'), indent = 2, sort_keys = True)
+
+def summary(report):
+    """ Returns one line per platform summarizing the report. """
+
+    lines = []
+    for platform, budget in sorted(report['platforms'].items()):
+        heap = budget['heap']
+        line = '%s: %s resources, %s bytes; worst-case heap %s bytes (%s in resource caches)' % (
+            platform, budget['resource_count'], budget['resource_bytes'],
+            heap['worst_case_bytes'], heap['resource_cache_bytes'])
+        if heap['budget'] is not None:
+            line += ', budget %s%s' % (heap['budget'], ' EXCEEDED' if heap['over_budget'] else '')
+        lines.append(line)
+    return '\n'.join(lines)
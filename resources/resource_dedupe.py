@@ -0,0 +1,120 @@
+""" resource_dedupe.py
+
+Finds the bitmap resources of a configured watch that are
+byte-for-byte copies of an earlier resource on the same platform, for
+config_watch.py.  This happens more often than one might think: the
+trivial masks of a color hand without an explicit mask, the white moon
+wheel on a color platform, which doesn't rotate, and the odd hand
+rotation that happens to come out identical to another.
+
+Each copy becomes an alias of the first resource with the same
+contents, listed in resource_aliases[] in generated_table.c; the
+decoding code in src/bwd.c loads (and caches) the first resource in
+its place.  A copy's resource ID remains, so the IDs of a hand's
+bitmaps stay consecutive, but if it is a copy on every platform that
+uses its file, that file is replaced with a placeholder, so it costs
+next to nothing in the resource pack.
+"""
+
+import os
+import hashlib
+import PIL.Image
+from host import host_build
+
+def is_bitmap(type, pathname):
+    """ Returns true if the indicated resource is a bitmap, and so is
+    loaded through src/bwd.c, which resolves aliases. """
+    return pathname.endswith('.rle') or type in ['png', 'pbi']
+
+def find_aliases(appinfo, platform, projectDir):
+    """ Returns (aliases, media) for the indicated platform, where
+    aliases is the list of (name, resourceName, pathname) for each
+    resource that copies the earlier resource named resourceName, and
+    media is as returned by host_build.getPlatformMedia(). """
+
+    menuIcons = set([entry['name'] for entry in appinfo['resources']['media'] if entry.get('menuIcon')])
+    media = host_build.getPlatformMedia(appinfo, platform, projectDir)
+
+    firstNames = {}
+    aliases = []
+    for resourceId, name, type, pathname in media:
+        if name in menuIcons or not is_bitmap(type, pathname) or not os.path.exists(pathname):
+            continue
+        data = open(pathname, 'rb').read()
+        if not data:
+            # An empty placeholder is never loaded anyway.
+            continue
+        key = (type, hashlib.sha1(data).hexdigest())
+        if key in firstNames:
+            aliases.append((name, firstNames[key], pathname))
+        else:
+            firstNames[key] = name
+    return aliases, media
+
+def write_placeholder(pathname):
+    """ Replaces the indicated resource file with a placeholder of the
+    same type, as small as possible. """
+
+    if pathname.endswith('.rle'):
+        open(pathname, 'wb').close()
+    else:
+        # The SDK must still be able to convert a png.
+        PIL.Image.new('1', (1, 1), 0).save(pathname)
+
+def dedupe(platforms, projectDir):
+    """ Finds the aliases on each of the indicated platforms, and
+    replaces with a placeholder every generated file that is an alias
+    on all of the platforms that use it.  Returns (aliasesByPlatform,
+    numFiles, numBytes), where aliasesByPlatform maps each platform to
+    its list of (name, resourceName), and numFiles and numBytes count
+    the files replaced. """
+
+    appinfo = host_build.readAppinfo(projectDir)
+    buildDir = os.path.join(projectDir, 'resources', 'build')
+
+    aliasesByPlatform = {}
+    aliasFiles = set()
+    keepFiles = set()
+    for platform in platforms:
+        aliases, media = find_aliases(appinfo, platform, projectDir)
+        aliasesByPlatform[platform] = [(name, resourceName) for name, resourceName, pathname in aliases]
+
+        # A file may be replaced only if every resource that uses it,
+        # on every platform, is an alias.
+        aliasNames = set([name for name, resourceName, pathname in aliases])
+        for resourceId, name, type, pathname in media:
+            if name in aliasNames:
+                aliasFiles.add(pathname)
+            else:
+                keepFiles.add(pathname)
+
+    numFiles = 0
+    numBytes = 0
+    for pathname in sorted(aliasFiles - keepFiles):
+        # Only generated files may be replaced, never the sources.
+        if os.path.dirname(os.path.abspath(pathname)) != os.path.abspath(buildDir):
+            continue
+        numBytes += os.path.getsize(pathname)
+        write_placeholder(pathname)
+        numBytes -= os.path.getsize(pathname)
+        numFiles += 1
+
+    return aliasesByPlatform, numFiles, numBytes
+
+def write_alias_table(generatedTable, platforms, aliasesByPlatform):
+    """ Writes resource_aliases[] for each platform to the generated
+    table.  The entries are in resource ID order, as bwd_resolve_alias()
+    requires. """
+
+    for platform in platforms:
+        define = host_build.platformDefines[platform]
+        aliases = aliasesByPlatform.get(platform, [])
+        print >> generatedTable, "#ifdef %s" % (define)
+        print >> generatedTable, "struct ResourceAlias resource_aliases[] = {"
+        for name, resourceName in aliases:
+            print >> generatedTable, "  { RESOURCE_ID_%s, RESOURCE_ID_%s }," % (name, resourceName)
+        if not aliases:
+            print >> generatedTable, "  { 0, 0 },"
+        print >> generatedTable, "};"
+        print >> generatedTable, "int num_resource_aliases = %s;" % (len(aliases))
+        print >> generatedTable, "#endif  // %s\n" % (define)
@@ -26,7 +26,7 @@ void draw_battery_gauge(GContext *ctx, int x, int y, bool invert) {
   BatteryChargeState charge_state = battery_state_service_peek();
 
 #ifdef BATTERY_HACK
-  time_t now = time(NULL);  
+  time_t now = clock_time(NULL);
   charge_state.charge_percent = 100 - ((now / 2) % 11) * 10;
 #endif  // BATTERY_HACK
 
@@ -18,6 +18,26 @@ void bwd_clear_cache(struct ResourceCache *resource_cache, size_t resource_cache
 }
 #endif  // SUPPORT_RESOURCE_CACHE
 
+// Returns the resource to load in place of the indicated one: the
+// resource it copies, if it is one of the resource_aliases[], or else
+// resource_id itself.
+int bwd_resolve_alias(int resource_id) {
+  int lo = 0;
+  int hi = num_resource_aliases;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (resource_aliases[mid].alias_id < resource_id) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < num_resource_aliases && resource_aliases[lo].alias_id == resource_id) {
+    return resource_aliases[lo].resource_id;
+  }
+  return resource_id;
+}
+
 BitmapWithData bwd_create(GBitmap *bitmap, unsigned char *data) {
   BitmapWithData bwd;
   bwd.bitmap = bitmap;
@@ -40,6 +60,22 @@ BitmapWithData bwd_copy(BitmapWithData *source) {
   return bwd_copy_bitmap(source->bitmap);
 }
 
+// Returns a copy of the source bitmap that uses the indicated shared
+// palette (see rle_bwd_create_shared()), instead of a copy of its own
+// palette.  If shared_palette is NULL, this is the same as bwd_copy().
+BitmapWithData bwd_copy_shared(BitmapWithData *source, GColor *shared_palette) {
+#ifndef PBL_SDK_2
+  if (shared_palette != NULL) {
+    BitmapWithData dest;
+    dest.bitmap = gbitmap_create_blank_with_palette(gbitmap_get_bounds(source->bitmap).size, gbitmap_get_format(source->bitmap), shared_palette, false);
+    dest.data = NULL;
+    bwd_copy_into_from_bitmap(&dest, source->bitmap);
+    return dest;
+  }
+#endif  // PBL_SDK_2
+  return bwd_copy(source);
+}
+
 BitmapWithData bwd_copy_bitmap(GBitmap *source) {
   BitmapWithData dest;
   dest.bitmap = NULL;
@@ -97,7 +133,9 @@ void bwd_copy_into_from_bitmap(BitmapWithData *dest, GBitmap *source) {
       bwd_destroy(dest);
       return;
     }
-    memcpy(dest_palette, source_palette, palette_count);
+    if (dest_palette != source_palette) {
+      memcpy(dest_palette, source_palette, palette_count);
+    }
   }
 #endif  // PBL_SDK_2
 
@@ -136,12 +174,239 @@ void bwd_copy_into_from_bitmap(BitmapWithData *dest, GBitmap *source) {
 #endif  // PBL_SDK_2
 }
 
+// Returns a new bitmap holding a copy of the indicated rectangle of
+// the source bitmap, which is normally the captured framebuffer.  Only
+// the framebuffer formats are supported: 1-bit, and 8-bit or 8-bit
+// circular (which is copied as plain 8-bit).  The rectangle need not
+// be byte-aligned; any part of it that falls outside the source (or
+// outside the visible span of a circular row) is left as 0.
+BitmapWithData bwd_copy_bitmap_rect(GBitmap *source, GRect rect) {
+  BitmapWithData dest;
+  dest.bitmap = NULL;
+  dest.data = NULL;
+
+  GSize source_size = gbitmap_get_bounds(source).size;
+
+#ifdef PBL_SDK_2
+  bool is_8bit = false;
+  dest.bitmap = __gbitmap_create_blank(rect.size);
+#else
+  GBitmapFormat format = gbitmap_get_format(source);
+  bool is_8bit = (format == GBitmapFormat8Bit || format == GBitmapFormat8BitCircular);
+  if (!is_8bit && format != GBitmapFormat1Bit) {
+    return dest;
+  }
+  dest.bitmap = gbitmap_create_blank(rect.size, is_8bit ? GBitmapFormat8Bit : GBitmapFormat1Bit);
+#endif
+  if (dest.bitmap == NULL) {
+    return dest;
+  }
+
+  uint8_t *source_data = gbitmap_get_data(source);
+  int source_stride = gbitmap_get_bytes_per_row(source);
+  uint8_t *dest_data = gbitmap_get_data(dest.bitmap);
+  int dest_stride = gbitmap_get_bytes_per_row(dest.bitmap);
+
+  for (int y = 0; y < rect.size.h; ++y) {
+    int sy = rect.origin.y + y;
+    if (sy < 0 || sy >= source_size.h) {
+      continue;
+    }
+    uint8_t *dest_row = dest_data + y * dest_stride;
+
+#ifndef PBL_SDK_2
+    if (is_8bit) {
+      GBitmapDataRowInfo info = gbitmap_get_data_row_info(source, sy);
+      for (int x = 0; x < rect.size.w; ++x) {
+        int sx = rect.origin.x + x;
+        if (sx >= info.min_x && sx <= info.max_x) {
+          dest_row[x] = info.data[sx];
+        }
+      }
+      continue;
+    }
+#endif  // PBL_SDK_2
+
+    uint8_t *source_row = source_data + sy * source_stride;
+    for (int x = 0; x < rect.size.w; ++x) {
+      int sx = rect.origin.x + x;
+      if (sx >= 0 && sx < source_size.w && (source_row[sx >> 3] & (1 << (sx & 7)))) {
+        dest_row[x >> 3] |= (1 << (x & 7));
+      }
+    }
+  }
+
+  return dest;
+}
+
+#ifdef RUNTIME_HAND_ROTATION
+// Returns the number of bits per pixel in the indicated bitmap, and
+// fills in *palette_count with the number of colors in its palette,
+// or 0 if it has none.
+static int bwd_bits_per_pixel(GBitmap *bitmap, int *palette_count) {
+  *palette_count = 0;
+#ifndef PBL_SDK_2
+  switch (gbitmap_get_format(bitmap)) {
+  case GBitmapFormat1BitPalette:
+    *palette_count = 2;
+    return 1;
+  case GBitmapFormat2BitPalette:
+    *palette_count = 4;
+    return 2;
+  case GBitmapFormat4BitPalette:
+    *palette_count = 16;
+    return 4;
+  case GBitmapFormat8Bit:
+  case GBitmapFormat8BitCircular:
+    return 8;
+  default:
+    break;
+  }
+#endif  // PBL_SDK_2
+  return 1;
+}
+
+// Returns pixel x of a row packed as by pack_1bit() (least
+// significant bit first), or by pack_2bit() and pack_4bit() (most
+// significant bits first).
+static inline int get_packed_pixel(uint8_t *row, int x, int bits_per_pixel) {
+  switch (bits_per_pixel) {
+  case 1:
+    return (row[x >> 3] >> (x & 7)) & 0x1;
+  case 2:
+    return (row[x >> 2] >> (6 - ((x & 3) << 1))) & 0x3;
+  case 4:
+    return (row[x >> 1] >> ((x & 1) ? 0 : 4)) & 0xf;
+  default:
+    return row[x];
+  }
+}
+
+// Sets pixel x of a row packed as above.
+static inline void set_packed_pixel(uint8_t *row, int x, int bits_per_pixel, int value) {
+  switch (bits_per_pixel) {
+  case 1:
+    row[x >> 3] = (row[x >> 3] & ~(0x1 << (x & 7))) | (value << (x & 7));
+    break;
+  case 2:
+    row[x >> 2] = (row[x >> 2] & ~(0x3 << (6 - ((x & 3) << 1)))) | (value << (6 - ((x & 3) << 1)));
+    break;
+  case 4:
+    row[x >> 1] = (row[x >> 1] & ~(0xf << ((x & 1) ? 0 : 4))) | (value << ((x & 1) ? 0 : 4));
+    break;
+  default:
+    row[x] = value;
+  }
+}
+
+// Returns a new bitmap holding the source bitmap rotated clockwise by
+// angle (in units of TRIG_MAX_ANGLE) about the pixel *center, which is
+// updated to the corresponding pixel of the new bitmap.  The new
+// bitmap is just large enough to hold the rotated source; pixels
+// outside the source are clear.  Each pixel is sampled from its
+// nearest source pixel, so the colors (or palette indices) are never
+// mixed, and a palette bitmap shares the source's palette, which must
+// outlive it.
+BitmapWithData bwd_rotate(GBitmap *source, int32_t angle, GPoint *center) {
+  BitmapWithData dest;
+  dest.bitmap = NULL;
+  dest.data = NULL;
+
+  GSize size = gbitmap_get_bounds(source).size;
+  int palette_count;
+  int bits_per_pixel = bwd_bits_per_pixel(source, &palette_count);
+
+  // The sine and cosine, in 16.16 fixed point.  sin_lookup() peaks
+  // at TRIG_MAX_RATIO, one short of 1.0, which we correct so that the
+  // quarter turns come out exact.
+  int32_t s = sin_lookup(angle);
+  int32_t c = cos_lookup(angle);
+  s = (s == TRIG_MAX_RATIO) ? 0x10000 : (s == -TRIG_MAX_RATIO) ? -0x10000 : s;
+  c = (c == TRIG_MAX_RATIO) ? 0x10000 : (c == -TRIG_MAX_RATIO) ? -0x10000 : c;
+
+  // Find the bounds of the rotated bitmap, relative to the center, by
+  // rotating the corners of the source.
+  int min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+  for (int ci = 0; ci < 4; ++ci) {
+    int x = ((ci & 1) ? size.w : 0) - center->x;
+    int y = ((ci & 2) ? size.h : 0) - center->y;
+    int rx = (x * c - y * s) >> 16;
+    int ry = (x * s + y * c) >> 16;
+    min_x = (rx < min_x) ? rx : min_x;
+    max_x = (rx > max_x) ? rx : max_x;
+    min_y = (ry < min_y) ? ry : min_y;
+    max_y = (ry > max_y) ? ry : max_y;
+  }
+  GSize dest_size = GSize(max_x - min_x + 1, max_y - min_y + 1);
+
+#ifdef PBL_SDK_2
+  dest.bitmap = __gbitmap_create_blank(dest_size);
+#else
+  GBitmapFormat format = gbitmap_get_format(source);
+  if (format == GBitmapFormat8BitCircular) {
+    format = GBitmapFormat8Bit;
+  }
+  if (palette_count != 0) {
+    dest.bitmap = gbitmap_create_blank_with_palette(dest_size, format, gbitmap_get_palette(source), false);
+  } else {
+    dest.bitmap = gbitmap_create_blank(dest_size, format);
+  }
+#endif  // PBL_SDK_2
+  if (dest.bitmap == NULL) {
+    return dest;
+  }
+
+  // The background is the first clear color in the palette, if any;
+  // otherwise 0, which is clear (or black) in the other formats.
+  int background = 0;
+#ifndef PBL_SDK_2
+  if (palette_count != 0) {
+    GColor *palette = gbitmap_get_palette(source);
+    for (int pi = 0; pi < palette_count; ++pi) {
+      if (palette[pi].a == 0) {
+        background = pi;
+        break;
+      }
+    }
+  }
+#endif  // PBL_SDK_2
+
+  uint8_t *source_data = gbitmap_get_data(source);
+  int source_stride = gbitmap_get_bytes_per_row(source);
+  uint8_t *dest_data = gbitmap_get_data(dest.bitmap);
+  int dest_stride = gbitmap_get_bytes_per_row(dest.bitmap);
+
+  // Walk through the new bitmap, rotating each pixel back into the
+  // source.  Along a row, the source point advances by (c, -s).
+  for (int y = 0; y < dest_size.h; ++y) {
+    uint8_t *dest_row = dest_data + y * dest_stride;
+    int dy = y + min_y;
+    int32_t sx = (center->x << 16) + 0x8000 + min_x * c + dy * s;
+    int32_t sy = (center->y << 16) + 0x8000 - min_x * s + dy * c;
+    for (int x = 0; x < dest_size.w; ++x) {
+      int value = background;
+      if (sx >= 0 && sy >= 0 && (sx >> 16) < size.w && (sy >> 16) < size.h) {
+        value = get_packed_pixel(source_data + (sy >> 16) * source_stride, sx >> 16, bits_per_pixel);
+      }
+      set_packed_pixel(dest_row, x, bits_per_pixel, value);
+      sx += c;
+      sy -= s;
+    }
+  }
+
+  center->x = -min_x;
+  center->y = -min_y;
+  return dest;
+}
+#endif  // RUNTIME_HAND_ROTATION
+
 // Initialize a bitmap from a regular unencoded resource (i.e. as
 // loaded from a png file).  This is the same as
 // gbitmap_create_with_resource(), but wrapped within the
 // BitmapWithData interface to be consistent with rle_bwd_create().
 // The returned bitmap must be released with bwd_destroy().
 BitmapWithData png_bwd_create(int resource_id) {
+  resource_id = bwd_resolve_alias(resource_id);
   app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "png_bwd_create(%d)", resource_id);
   ++bwd_resource_reads;
   GBitmap *image = gbitmap_create_with_resource(resource_id);
@@ -150,8 +415,11 @@ BitmapWithData png_bwd_create(int resource_id) {
 
 #ifdef SUPPORT_RESOURCE_CACHE
 BitmapWithData png_bwd_create_with_cache(int resource_id_offset, int resource_id, struct ResourceCache *resource_cache, size_t resource_cache_size) {
+  // An alias shares the cache entry of the resource it copies, if
+  // that's in the same cache.
+  resource_id = bwd_resolve_alias(resource_id);
   int index = resource_id - resource_id_offset;
-  if (index >= (int)resource_cache_size) {
+  if (index < 0 || index >= (int)resource_cache_size) {
     // No cache in use.
     return png_bwd_create(resource_id);
   }
@@ -172,8 +440,12 @@ BitmapWithData rle_bwd_create(int resource_id) {
   return png_bwd_create(resource_id);
 }
 
+BitmapWithData rle_bwd_create_shared(int resource_id, GColor *shared_palette) {
+  return png_bwd_create(resource_id);
+}
+
 #ifdef SUPPORT_RESOURCE_CACHE
-BitmapWithData rle_bwd_create_with_cache(int resource_id_offset, int resource_id, struct ResourceCache *resource_cache, size_t resource_cache_size) {
+BitmapWithData rle_bwd_create_with_cache(int resource_id_offset, int resource_id, GColor *shared_palette, struct ResourceCache *resource_cache, size_t resource_cache_size) {
   return png_bwd_create_with_cache(resource_id_offset, resource_id, resource_cache, resource_cache_size);
 }
 #endif  // SUPPORT_RESOURCE_CACHE
@@ -225,8 +497,9 @@ static void rbuffer_init_data(RBuffer *rb, unsigned char *data, size_t data_size
 // the rb_back is initialized with a new RBuffer that receives all of
 // the bytes of the first RBuffer from point to the end.  The caller
 // should eventually call rbuffer_deinit() on rb_back, which should
-// not persist longer than rb_front does.
-static void rbuffer_split(RBuffer *rb_front, RBuffer *rb_back, size_t point) {
+// not persist longer than rb_front does.  Returns false if rb_front
+// has already read past point, which means the data is corrupt.
+static bool rbuffer_split(RBuffer *rb_front, RBuffer *rb_back, size_t point) {
   rb_back->_rh = rb_front->_rh;
   rb_back->_total_size = rb_front->_total_size;
   rb_back->_i = 0;
@@ -252,10 +525,11 @@ static void rbuffer_split(RBuffer *rb_front, RBuffer *rb_back, size_t point) {
         // Whoops, we've already overrun the new point.
         rb_front->_filled_size = 0;
         rb_front->_i = 0;
-        assert(false);
+        return false;
       }
     }
   }
+  return true;
 }
 
 // Gets the next byte from the rbuffer.  Returns EOF at end.
@@ -299,7 +573,10 @@ static void rbuffer_deinit(RBuffer *rb) {
 }
 
 // Used to unpack the integers of an rl2-encoding back into their
-// original rle sequence.  See make_rle.py.
+// original rle sequence.  See make_rle.py.  No valid run length or
+// value needs more than RL2_MAX_BITS bits (a bitmap is at most 255 x
+// 255 pixels), so anything longer is rejected as corrupt.
+#define RL2_MAX_BITS 24
 typedef struct {
   RBuffer *rb;
   int n;
@@ -348,6 +625,11 @@ static int rl2unpacker_getc(Rl2Unpacker *rl2) {
   // bits, that make up the value we will extract.
   int num_chunks = (zero_count + 1);
   int bit_count = num_chunks * rl2->n;
+  if (bit_count > RL2_MAX_BITS) {
+    // No valid value is this long; the data is corrupt.
+    rl2->b = EOF;
+    return EOF;
+  }
 
   // OK, now we need to extract the next bitCount bits into a word.
   int result = 0;
@@ -364,6 +646,11 @@ static int rl2unpacker_getc(Rl2Unpacker *rl2) {
     }
   }
 
+  if (bit_count > 0 && rl2->b == EOF) {
+    // The data was truncated in the middle of a value.
+    return EOF;
+  }
+
   if (bit_count > 0) {
     // A partial word in the middle of the byte.
     int bottom_count = rl2->bi - bit_count;
@@ -400,6 +687,30 @@ void unscreen_bitmap(GBitmap *image) {
 
 typedef void Packer(int value, int count, int *b, uint8_t **dp, uint8_t *dp_stop);
 
+// The size of the RLE header, below.
+#define RLE_HEADER_SIZE 8
+
+// A flag in the format byte of the RLE header: the palette is not
+// stored in the resource, but supplied by the caller, and shared with
+// other bitmaps.
+#define RLE_SHARED_PALETTE 0x80
+
+// Returns true if n is a valid chunk size for an rl2 encoding, i.e. an
+// integer divisor of 8.
+static inline bool rl2_valid_n(int n) {
+  return n == 1 || n == 2 || n == 4 || n == 8;
+}
+
+// Logs and discards a partially-decoded bitmap from a corrupt RLE
+// resource, and returns the empty BitmapWithData.
+static BitmapWithData rle_reject(GBitmap *image, int line_number) {
+  app_log(APP_LOG_LEVEL_WARNING, __FILE__, line_number, "corrupt rle resource");
+  if (image != NULL) {
+    gbitmap_destroy(image);
+  }
+  return bwd_create(NULL, NULL);
+}
+
 // Packs a series of identical 1-bit values into (*dp) beginning at bit (*b).
 void pack_1bit(int value, int count, int *b, uint8_t **dp, uint8_t *dp_stop) {
   assert(*dp < dp_stop);
@@ -459,7 +770,7 @@ void pack_2bit(int value, int count, int *b, uint8_t **dp, uint8_t *dp_stop) {
       ++(*dp);
       (*b) = 0;
     }
-    assert((*b) == 0);
+    assert(count == 0 || (*b) == 0);
     uint8_t byte = (value << 6) | (value << 4) | (value << 2) | value;
     while (count >= 4) {
       // Now pack a full byte's worth at a time.
@@ -536,21 +847,26 @@ void pack_8bit(int value, int count, int *b, uint8_t **dp, uint8_t *dp_stop) {
 
 // Initialize a bitmap from an rle-encoded resource.  The returned
 // bitmap must be released with bwd_destroy().  See make_rle.py for
-// the program that generates these rle sequences.
+// the program that generates these rle sequences.  If the resource
+// was encoded with a shared palette, the bitmap uses shared_palette,
+// which must remain valid for the life of the bitmap; a resource
+// with a shared palette is rejected if shared_palette is NULL.
 BitmapWithData
-rle_bwd_create_rb(RBuffer *rb) {
+rle_bwd_create_rb(RBuffer *rb, GColor *shared_palette) {
   // RLE header (NB: All fields are little-endian)
   //         (uint8_t)  width
   //         (uint8_t)  height
   //         (uint8_t)  n (number of chunks of pixels to take at a time; unscreen if 0x80 set)
-  //         (uint8_t)  format (see below)
+  //         (uint8_t)  format (see below; shared palette if 0x80 set)
   //         (uint16_t) offset to start of values, or 0 if format == 0
   //         (uint16_t) offset to start of palette, or 0 if format <= 1
   
   int width = rbuffer_getc(rb);
   int height = rbuffer_getc(rb);
   int n = rbuffer_getc(rb);
-  GBitmapFormat format = (GBitmapFormat)rbuffer_getc(rb);
+  int format_byte = rbuffer_getc(rb);
+  bool use_shared_palette = (format_byte != EOF && (format_byte & RLE_SHARED_PALETTE) != 0);
+  GBitmapFormat format = (GBitmapFormat)(use_shared_palette ? (format_byte & ~RLE_SHARED_PALETTE) : format_byte);
 
   uint8_t vo_lo = rbuffer_getc(rb);
   uint8_t vo_hi = rbuffer_getc(rb);
@@ -560,10 +876,19 @@ rle_bwd_create_rb(RBuffer *rb) {
   uint8_t po_hi = rbuffer_getc(rb);
   unsigned int po = (po_hi << 8) | po_lo;
 
-  assert(vo != 0 && po >= vo && po <= rb->_total_size);
+  // Everything in the header is checked up front, since a corrupt
+  // resource (e.g. after a partial install) must not be allowed to
+  // write past the end of the bitmap.
+  if (width <= 0 || height <= 0 || n == EOF ||
+      vo < RLE_HEADER_SIZE || po < vo || po > rb->_total_size) {
+    return rle_reject(NULL, __LINE__);
+  }
   
   int do_unscreen = (n & 0x80);
   n = n & 0x7f;
+  if (!rl2_valid_n(n)) {
+    return rle_reject(NULL, __LINE__);
+  }
 
   Packer *packer_func = NULL;
   size_t palette_count = 0;
@@ -594,17 +919,34 @@ rle_bwd_create_rb(RBuffer *rb) {
     packer_func = pack_8bit;
     break;
   }
-  assert(packer_func != NULL);
+  if (packer_func == NULL) {
+    return rle_reject(NULL, __LINE__);
+  }
+  if (use_shared_palette && (palette_count == 0 || shared_palette == NULL)) {
+    return rle_reject(NULL, __LINE__);
+  }
 
   GColor *palette = NULL;
-  if (palette_count != 0) {
-    palette = (GColor *)malloc(palette_count * sizeof(GColor));
-  }
-  
-  GBitmap *image = gbitmap_create_blank_with_palette(GSize(width, height), format, palette, true);
-  if (image == NULL) {
-    free(palette);
-    return bwd_create(NULL, NULL);
+  GBitmap *image = NULL;
+  if (use_shared_palette) {
+    // The palette is already filled in; the bitmap just borrows it.
+    palette = shared_palette;
+    image = gbitmap_create_blank_with_palette(GSize(width, height), format, palette, false);
+    if (image == NULL) {
+      return bwd_create(NULL, NULL);
+    }
+  } else {
+    if (palette_count != 0) {
+      palette = (GColor *)malloc(palette_count * sizeof(GColor));
+      if (palette == NULL) {
+        return bwd_create(NULL, NULL);
+      }
+    }
+    image = gbitmap_create_blank_with_palette(GSize(width, height), format, palette, true);
+    if (image == NULL) {
+      free(palette);
+      return bwd_create(NULL, NULL);
+    }
   }
   int stride = gbitmap_get_bytes_per_row(image);
   uint8_t *bitmap_data = gbitmap_get_data(image);
@@ -618,7 +960,9 @@ rle_bwd_create_rb(RBuffer *rb) {
   // shortened to that point.  We also create a new rb_vo buffer to
   // read the values data which begins at vo.
   RBuffer rb_vo;
-  rbuffer_split(rb, &rb_vo, vo);
+  if (!rbuffer_split(rb, &rb_vo, vo)) {
+    return rle_reject(image, __LINE__);
+  }
 
   Rl2Unpacker rl2_vo;
   if (vn != 0) {
@@ -628,6 +972,13 @@ rle_bwd_create_rb(RBuffer *rb) {
   uint8_t *dp = bitmap_data;
   uint8_t *dp_stop = dp + data_size;
   int b = 0;
+
+  // Each run is checked against the number of pixels still to be
+  // filled before it is packed; this is the only check in the inner
+  // loop, and it's once per run, not per pixel.
+  int bits_per_pixel = (vn != 0) ? vn : 1;
+  unsigned int pixels_remaining = data_size * 8 / bits_per_pixel;
+  bool corrupt = false;
   
   if (packer_func == pack_1bit) {
     // Unpack a 1-bit file.
@@ -636,11 +987,15 @@ rle_bwd_create_rb(RBuffer *rb) {
     int value = 0;
     int count = rl2unpacker_getc(&rl2);
     if (count != EOF) {
-      assert(count > 0);
       // We discard the first, implicit black pixel; it's not part of the image.
       --count;
     }
     while (count != EOF) {
+      if ((unsigned int)count > pixels_remaining) {
+        corrupt = true;
+        break;
+      }
+      pixels_remaining -= count;
       pack_1bit(value, count, &b, &dp, dp_stop);
       value = 1 - value;
       count = rl2unpacker_getc(&rl2);
@@ -653,22 +1008,34 @@ rle_bwd_create_rb(RBuffer *rb) {
     int count = rl2unpacker_getc(&rl2);
     while (count != EOF) {
       int value = rl2unpacker_getc(&rl2_vo);
+      if (value == EOF || (unsigned int)count > pixels_remaining) {
+        corrupt = true;
+        break;
+      }
+      pixels_remaining -= count;
       (*packer_func)(value, count, &b, &dp, dp_stop);
       count = rl2unpacker_getc(&rl2);
     }
   }
 
   //app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "wrote %d bytes", dp - bitmap_data);
+  if (corrupt || pixels_remaining != 0) {
+    rbuffer_deinit(&rb_vo);
+    return rle_reject(image, __LINE__);
+  }
   assert(dp == dp_stop && b == 0);
   
   if (do_unscreen) {
     unscreen_bitmap(image);
   }
 
-  if (palette_count != 0) {
+  if (palette_count != 0 && !use_shared_palette) {
     // Now we need to apply the palette.
     RBuffer rb_po;
-    rbuffer_split(&rb_vo, &rb_po, po);
+    if (!rbuffer_split(&rb_vo, &rb_po, po)) {
+      rbuffer_deinit(&rb_vo);
+      return rle_reject(image, __LINE__);
+    }
     for (int i = 0; i < (int)palette_count; ++i) {
       palette[i].argb = rbuffer_getc(&rb_po);
     }
@@ -682,13 +1049,14 @@ rle_bwd_create_rb(RBuffer *rb) {
 
 #else  // PBL_PLATFORM_APLITE
 
-// Here's the simpler Aplite implementation, which only supports GColorFormat1Bit.
+// Here's the simpler Aplite implementation, which only supports
+// GColorFormat1Bit, and so never uses shared_palette.
 
 // Initialize a bitmap from an rle-encoded resource.  The returned
 // bitmap must be released with bwd_destroy().  See make_rle.py for
 // the program that generates these rle sequences.
 BitmapWithData
-rle_bwd_create_rb(RBuffer *rb) {
+rle_bwd_create_rb(RBuffer *rb, GColor *shared_palette) {
   // RLE header (NB: All fields are little-endian)
   //         (uint8_t)  width
   //         (uint8_t)  height
@@ -699,7 +1067,9 @@ rle_bwd_create_rb(RBuffer *rb) {
   
   int width = rbuffer_getc(rb);
   int height = rbuffer_getc(rb);
-  assert(width > 0 && width <= SCREEN_WIDTH && height > 0 && height <= SCREEN_HEIGHT);
+  if (width <= 0 || width > SCREEN_WIDTH || height <= 0 || height > SCREEN_HEIGHT) {
+    return rle_reject(NULL, __LINE__);
+  }
   int n = rbuffer_getc(rb);
   int format = rbuffer_getc(rb);
   if (format != 0) {
@@ -712,8 +1082,14 @@ rle_bwd_create_rb(RBuffer *rb) {
   /*uint8_t po_lo = */rbuffer_getc(rb);
   /*uint8_t po_hi = */rbuffer_getc(rb);
   
+  if (n == EOF) {
+    return rle_reject(NULL, __LINE__);
+  }
   int do_unscreen = (n & 0x80);
   n = n & 0x7f;
+  if (!rl2_valid_n(n)) {
+    return rle_reject(NULL, __LINE__);
+  }
 
   app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "reading bitmap %d x %d, n = %d, format = %d", width, height, n, format);
   
@@ -733,6 +1109,10 @@ rle_bwd_create_rb(RBuffer *rb) {
   uint8_t *dp = bitmap_data;
   uint8_t *dp_stop = dp + data_size;
   int b = 0;
+
+  // Each run is checked against the number of pixels still to be
+  // filled before it is packed, once per run.
+  unsigned int pixels_remaining = data_size * 8;
   
   // Unpack a 1-bit file.
 
@@ -740,17 +1120,23 @@ rle_bwd_create_rb(RBuffer *rb) {
   int value = 0;
   int count = rl2unpacker_getc(&rl2);
   if (count != EOF) {
-    assert(count > 0);
     // We discard the first, implicit black pixel; it's not part of the image.
     --count;
   }
   while (count != EOF) {
+    if ((unsigned int)count > pixels_remaining) {
+      return rle_reject(image, __LINE__);
+    }
+    pixels_remaining -= count;
     pack_1bit(value, count, &b, &dp, dp_stop);
     value = 1 - value;
     count = rl2unpacker_getc(&rl2);
   }
 
   //app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "wrote %d bytes", dp - bitmap_data);
+  if (pixels_remaining != 0) {
+    return rle_reject(image, __LINE__);
+  }
   assert(dp == dp_stop && b == 0);
   
   if (do_unscreen) {
@@ -764,29 +1150,41 @@ rle_bwd_create_rb(RBuffer *rb) {
 
 BitmapWithData
 rle_bwd_create(int resource_id) {
+  return rle_bwd_create_shared(resource_id, NULL);
+}
+
+// As above, for a resource that may have been encoded with a shared
+// palette (see config_watch.py -P); the returned bitmap uses
+// shared_palette, which the caller has filled in, instead of a palette
+// of its own.
+BitmapWithData
+rle_bwd_create_shared(int resource_id, GColor *shared_palette) {
+  resource_id = bwd_resolve_alias(resource_id);
   app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "rle_bwd_create(%d)", resource_id);
   ++bwd_resource_reads;
   
   RBuffer rb;
   rbuffer_init_resource(&rb, resource_id, 0);
-  BitmapWithData result = rle_bwd_create_rb(&rb);
+  BitmapWithData result = rle_bwd_create_rb(&rb, shared_palette);
   rbuffer_deinit(&rb);
   return result;
 }
 
 #ifdef SUPPORT_RESOURCE_CACHE
-BitmapWithData rle_bwd_create_with_cache(int resource_id_offset, int resource_id, struct ResourceCache *resource_cache, size_t resource_cache_size) {
+BitmapWithData rle_bwd_create_with_cache(int resource_id_offset, int resource_id, GColor *shared_palette, struct ResourceCache *resource_cache, size_t resource_cache_size) {
+  // As in png_bwd_create_with_cache(), above.
+  resource_id = bwd_resolve_alias(resource_id);
   int index = resource_id - resource_id_offset;
-  if (index >= (int)resource_cache_size) {
+  if (index < 0 || index >= (int)resource_cache_size) {
     // No cache in use.
-    return rle_bwd_create(resource_id);
+    return rle_bwd_create_shared(resource_id, shared_palette);
   }
 
   struct ResourceCache *cache = &resource_cache[index];
   if (cache->bwd.bitmap == NULL) {
-    cache->bwd = rle_bwd_create(resource_id);
+    cache->bwd = rle_bwd_create_shared(resource_id, shared_palette);
   }
-  return bwd_copy(&(cache->bwd));
+  return bwd_copy_shared(&(cache->bwd), shared_palette);
 }
 #endif  // SUPPORT_RESOURCE_CACHE
 
@@ -828,6 +1226,15 @@ void bwd_remap_colors(BitmapWithData *bwd, GColor cb, GColor c1, GColor c2, GCol
   GColor *palette = gbitmap_get_palette(bwd->bitmap);
   assert(palette != NULL);
 
+  bwd_remap_palette(palette, palette_size, cb, c1, c2, c3, invert_colors);
+#endif // PBL_PLATFORM_APLITE
+}
+
+// As bwd_remap_colors(), but remaps the colors of a palette directly,
+// e.g. a shared palette (see rle_bwd_create_shared()), which need be
+// remapped only once for all of the bitmaps that use it.
+void bwd_remap_palette(GColor *palette, int palette_size, GColor cb, GColor c1, GColor c2, GColor c3, bool invert_colors) {
+#ifndef PBL_PLATFORM_APLITE
   for (int pi = 0; pi < palette_size; ++pi) {
     int r = cb.r;
     int g = cb.g;
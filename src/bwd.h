@@ -22,31 +22,53 @@ struct __attribute__((__packed__)) ResourceCache {
   BitmapWithData bwd;
 };
 
+// An entry in resource_aliases[], which config_watch.py generates in
+// generated_table.c: the resource alias_id is a byte-for-byte copy
+// of the earlier resource resource_id, so it is loaded in its place.
+// (The copy itself is left as an empty placeholder.)  The table is
+// sorted by alias_id.  The IDs take 16 bits, since a watch with many
+// hand rotations has well over 255 resources.
+struct __attribute__((__packed__)) ResourceAlias {
+  uint16_t alias_id;
+  uint16_t resource_id;
+};
+
+extern struct ResourceAlias resource_aliases[];
+extern int num_resource_aliases;
+
 extern int bwd_resource_reads;
 extern int bwd_cache_hits;
 extern size_t bwd_cache_total_size;
 
+int bwd_resolve_alias(int resource_id);
 BitmapWithData bwd_create(GBitmap *bitmap, unsigned char *data);
 void bwd_destroy(BitmapWithData *bwd);
 BitmapWithData bwd_copy(BitmapWithData *source);
+BitmapWithData bwd_copy_shared(BitmapWithData *source, GColor *shared_palette);
 BitmapWithData bwd_copy_bitmap(GBitmap *bitmap);
 void bwd_copy_into_from_bitmap(BitmapWithData *dest, GBitmap *source);
+BitmapWithData bwd_copy_bitmap_rect(GBitmap *source, GRect rect);
+#ifdef RUNTIME_HAND_ROTATION
+BitmapWithData bwd_rotate(GBitmap *source, int32_t angle, GPoint *center);
+#endif  // RUNTIME_HAND_ROTATION
 BitmapWithData png_bwd_create(int resource_id);
 BitmapWithData rle_bwd_create(int resource_id);
+BitmapWithData rle_bwd_create_shared(int resource_id, GColor *shared_palette);
 
 #ifdef SUPPORT_RESOURCE_CACHE
 void bwd_clear_cache(struct ResourceCache *resource_cache, size_t resource_cache_size);
 BitmapWithData png_bwd_create_with_cache(int resource_id_offset, int resource_id, struct ResourceCache *resource_cache, size_t resource_cache_size);
-BitmapWithData rle_bwd_create_with_cache(int resource_id_offset, int resource_id, struct ResourceCache *resource_cache, size_t resource_cache_size);
+BitmapWithData rle_bwd_create_with_cache(int resource_id_offset, int resource_id, GColor *shared_palette, struct ResourceCache *resource_cache, size_t resource_cache_size);
 
 #else  // SUPPORT_RESOURCE_CACHE
 
 #define bwd_clear_cache(resource_cache, resource_cache_size) { }
 #define png_bwd_create_with_cache(resource_id_offset, resource_id) png_bwd_create(resource_id)
-#define rle_bwd_create_with_cache(resource_id_offset, resource_id) rle_bwd_create(resource_id)
+#define rle_bwd_create_with_cache(resource_id_offset, resource_id, shared_palette) rle_bwd_create_shared(resource_id, shared_palette)
 
 #endif  // SUPPORT_RESOURCE_CACHE
 
 void bwd_remap_colors(BitmapWithData *bwd, GColor cb, GColor c1, GColor c2, GColor c3, bool invert_colors);
+void bwd_remap_palette(GColor *palette, int palette_size, GColor cb, GColor c1, GColor c2, GColor c3, bool invert_colors);
 
 #endif
@@ -0,0 +1,135 @@
+#include "wright.h"
+#include "clock_source.h"
+
+typedef enum {
+  CS_real,
+  CS_fixed,
+  CS_accelerated,
+  CS_scripted,
+} ClockSourceMode;
+
+static ClockSourceMode clock_mode = CS_real;
+
+// For CS_fixed, the fixed time; for CS_accelerated and CS_scripted,
+// the simulated and real times at which the mode was selected.  All
+// of these are in milliseconds since the Unix epoch.
+static int64_t clock_base_ms = 0;
+static int64_t clock_real_base_ms = 0;
+
+static int clock_factor = 1;
+static const ClockScriptStep *clock_script = NULL;
+static int clock_num_steps = 0;
+static int clock_step_index = 0;
+
+// Returns the real time, from the SDK, in milliseconds since the Unix
+// epoch.
+static int64_t real_time_ms() {
+  time_t t;
+  uint16_t t_ms;
+  time_ms(&t, &t_ms);
+  return (int64_t)t * 1000 + t_ms;
+}
+
+// Returns the current time according to the clock source, in
+// milliseconds since the Unix epoch.
+static int64_t clock_now_ms() {
+  switch (clock_mode) {
+  case CS_real:
+    break;
+
+  case CS_fixed:
+    return clock_base_ms;
+
+  case CS_accelerated:
+    return clock_base_ms + (real_time_ms() - clock_real_base_ms) * clock_factor;
+
+  case CS_scripted:
+    {
+      int64_t elapsed_ms = real_time_ms() - clock_real_base_ms;
+
+      // The clock normally moves forward, so we resume the search
+      // from the step we found last time.
+      if (clock_step_index >= clock_num_steps || (int64_t)clock_script[clock_step_index].at_ms > elapsed_ms) {
+        clock_step_index = 0;
+      }
+      while (clock_step_index + 1 < clock_num_steps && (int64_t)clock_script[clock_step_index + 1].at_ms <= elapsed_ms) {
+        ++clock_step_index;
+      }
+      const ClockScriptStep *step = &clock_script[clock_step_index];
+      int64_t since_step_ms = elapsed_ms - step->at_ms;
+      if (since_step_ms < 0) {
+        since_step_ms = 0;
+      }
+      return (int64_t)step->t * 1000 + since_step_ms;
+    }
+  }
+
+  return real_time_ms();
+}
+
+void clock_source_real() {
+  clock_mode = CS_real;
+}
+
+// Holds the clock at the indicated time.
+void clock_source_fixed(time_t t, uint16_t t_ms) {
+  clock_mode = CS_fixed;
+  clock_base_ms = (int64_t)t * 1000 + t_ms;
+}
+
+// Runs the clock factor times faster than real time, beginning from
+// the current time.
+void clock_source_accelerated(int factor) {
+  int64_t now_ms = clock_now_ms();
+  clock_mode = CS_accelerated;
+  clock_base_ms = now_ms;
+  clock_real_base_ms = real_time_ms();
+  clock_factor = factor;
+}
+
+// Drives the clock from the indicated trace, beginning now.  The
+// script is not copied, and must remain valid until the clock source
+// is changed again.
+void clock_source_scripted(const ClockScriptStep *script, int num_steps) {
+  if (num_steps <= 0) {
+    clock_source_real();
+    return;
+  }
+  clock_mode = CS_scripted;
+  clock_real_base_ms = real_time_ms();
+  clock_script = script;
+  clock_num_steps = num_steps;
+  clock_step_index = 0;
+}
+
+bool clock_source_is_real() {
+  return clock_mode == CS_real;
+}
+
+// A replacement for the SDK's time().
+time_t clock_time(time_t *tloc) {
+  if (clock_mode == CS_real) {
+    return time(tloc);
+  }
+  time_t t = (time_t)(clock_now_ms() / 1000);
+  if (tloc != NULL) {
+    *tloc = t;
+  }
+  return t;
+}
+
+// A replacement for the SDK's time_ms().
+uint16_t clock_time_ms(time_t *tloc, uint16_t *out_ms) {
+  if (clock_mode == CS_real) {
+    return time_ms(tloc, out_ms);
+  }
+  int64_t now_ms = clock_now_ms();
+  uint16_t t_ms = (uint16_t)(now_ms % 1000);
+  if (tloc != NULL) {
+    *tloc = (time_t)(now_ms / 1000);
+  }
+  if (out_ms != NULL) {
+    *out_ms = t_ms;
+  }
+  return t_ms;
+}
@@ -0,0 +1,34 @@
+#ifndef CLOCK_SOURCE_H
+#define CLOCK_SOURCE_H
+
+#include <pebble.h>
+
+// This module is the watch's single source for the current time.  The
+// rest of the code calls clock_time() and clock_time_ms() instead of
+// the SDK's time() and time_ms(), so that the clock can be replaced at
+// runtime for development and testing: held at a fixed moment, run
+// faster than real time, or driven from a scripted trace.  The
+// default is the real clock.
+
+// The speed of the accelerated clock in a FAST_TIME build.
+#define FAST_TIME_FACTOR 67
+
+// One step of a scripted trace: from at_ms milliseconds (real time)
+// after the trace was started, the clock reads t and runs forward in
+// real time, until the next step.  Steps must be in increasing order
+// of at_ms.
+typedef struct {
+  uint32_t at_ms;
+  time_t t;
+} ClockScriptStep;
+
+void clock_source_real();
+void clock_source_fixed(time_t t, uint16_t t_ms);
+void clock_source_accelerated(int factor);
+void clock_source_scripted(const ClockScriptStep *script, int num_steps);
+bool clock_source_is_real();
+
+time_t clock_time(time_t *tloc);
+uint16_t clock_time_ms(time_t *tloc, uint16_t *out_ms);
+
+#endif  // CLOCK_SOURCE_H
@@ -2,6 +2,7 @@
 #include "config_options.h"
 
 ConfigOptions config;
+uint32_t config_inbox_size = 0;
 
 // Defines the default values of the config options.  Note that these
 // defaults are used only if the Pebble is not connected to the phone
@@ -16,152 +17,486 @@ static ConfigOptions default_options = {
   WNM_mon_4, false
 };
 
+// How each value received from the phone is brought into range before
+// it is stored, so it can't cause crashes.
+typedef enum {
+  CV_bool,         // Any nonzero value is true.
+  CV_count,        // Reduced modulo count.
+  CV_lang,         // Reduced modulo num_langs, which isn't a constant.
+  CV_date_window,  // As CV_count, into the date window named by the key.
+} ConfigValidator;
+
+// Where each ConfigKey is stored within ConfigOptions, and how its
+// value is validated.
+typedef struct {
+  unsigned char offset;
+  unsigned char size;
+  unsigned char validator;
+  unsigned char count;
+} ConfigField;
+
+#define CONFIG_FIELD(field, validator, count) \
+  { offsetof(ConfigOptions, field), sizeof(((ConfigOptions *)0)->field), validator, count }
+
+static const ConfigField config_fields[CK_num_keys] = {
+  [CK_battery_gauge] = CONFIG_FIELD(battery_gauge, CV_count, IM_digital + 1),
+  [CK_bluetooth_indicator] = CONFIG_FIELD(bluetooth_indicator, CV_count, IM_always + 1),
+  [CK_second_hand] = CONFIG_FIELD(second_hand, CV_bool, 0),
+  [CK_hour_buzzer] = CONFIG_FIELD(hour_buzzer, CV_bool, 0),
+  [CK_draw_mode] = CONFIG_FIELD(draw_mode, CV_count, 2),
+  [CK_chrono_dial] = CONFIG_FIELD(chrono_dial, CV_count, CDM_dual + 1),
+  [CK_sweep_seconds] = CONFIG_FIELD(sweep_seconds, CV_bool, 0),
+  [CK_display_lang] = CONFIG_FIELD(display_lang, CV_lang, 0),
+  [CK_face_index] = CONFIG_FIELD(face_index, CV_count, NUM_FACES),
+  [CK_date_window_a] = CONFIG_FIELD(date_windows[0], CV_date_window, DWM_debug_cache_total_size + 1),
+  [CK_date_window_b] = CONFIG_FIELD(date_windows[0], CV_date_window, DWM_debug_cache_total_size + 1),
+  [CK_date_window_c] = CONFIG_FIELD(date_windows[0], CV_date_window, DWM_debug_cache_total_size + 1),
+  [CK_date_window_d] = CONFIG_FIELD(date_windows[0], CV_date_window, DWM_debug_cache_total_size + 1),
+  [CK_bluetooth_buzzer] = CONFIG_FIELD(bluetooth_buzzer, CV_bool, 0),
+  [CK_lunar_background] = CONFIG_FIELD(lunar_background, CV_bool, 0),
+  [CK_lunar_direction] = CONFIG_FIELD(lunar_direction, CV_bool, 0),
+  [CK_color_mode] = CONFIG_FIELD(color_mode, CV_count, NUM_FACE_COLORS),
+  [CK_top_subdial] = CONFIG_FIELD(top_subdial, CV_count, TSM_moon_phase + 1),
+  [CK_show_debug] = CONFIG_FIELD(show_debug, CV_bool, 0),
+  [CK_week_numbering] = CONFIG_FIELD(week_numbering, CV_count, WNM_sat_1 + 1),
+};
+
+// Returns the address within config of the field set by the indicated
+// key, or NULL if the key doesn't name a field in this build.
+static uint8_t *config_field_ptr(uint32_t key) {
+  if (key >= CK_num_keys || config_fields[key].size == 0) {
+    return NULL;
+  }
+  const ConfigField *cf = &config_fields[key];
+  uint8_t *p = (uint8_t *)&config + cf->offset;
+  if (cf->validator == CV_date_window) {
+    // The date windows built into this watch are named by letter in
+    // DATE_WINDOW_KEYS; the others are ignored.
+    const char *dw = strchr(DATE_WINDOW_KEYS, 'a' + (key - CK_date_window_a));
+    if (dw == NULL) {
+      return NULL;
+    }
+    p += (dw - DATE_WINDOW_KEYS) * cf->size;
+  }
+  return p;
+}
+
+static uint32_t read_config_field(const uint8_t *p, int size) {
+  switch (size) {
+  case 1:
+    return *p;
+  case 2:
+    {
+      uint16_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+  default:
+    {
+      uint32_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+  }
+}
+
+static void write_config_field(uint8_t *p, int size, uint32_t value) {
+  switch (size) {
+  case 1:
+    *p = (uint8_t)value;
+    break;
+  case 2:
+    {
+      uint16_t v = (uint16_t)value;
+      memcpy(p, &v, sizeof(v));
+    }
+    break;
+  default:
+    memcpy(p, &value, sizeof(value));
+    break;
+  }
+}
+
+// Returns value brought into range for the indicated key's field.  As
+// with a plain assignment, the value is first truncated to the size of
+// the field (except for a bool, which is simply tested for nonzero).
+static uint32_t validate_config_value(uint32_t key, uint32_t value) {
+  const ConfigField *cf = &config_fields[key];
+  if (cf->validator == CV_bool) {
+    return (value != 0);
+  }
+  if (cf->size < sizeof(value)) {
+    value &= ((uint32_t)1 << (8 * cf->size)) - 1;
+  }
+  if (cf->validator == CV_lang) {
+    return value % num_langs;
+  }
+  return value % cf->count;
+}
+
+// Validates and stores a single config value, if its key names a field
+// in this build.
+static void set_config_value(uint32_t key, uint32_t value) {
+  uint8_t *p = config_field_ptr(key);
+  if (p != NULL) {
+    write_config_field(p, config_fields[key].size, validate_config_value(key, value));
+  }
+}
+
 void sanitize_config() {
   // Ensures that the newly-loaded config parameters are within a
   // reasonable range for the program and won't cause crashes.
-  config.battery_gauge = config.battery_gauge % (IM_digital + 1);
-  config.bluetooth_indicator = config.bluetooth_indicator % (IM_always + 1);
-  config.draw_mode = config.draw_mode & 1;
-  config.chrono_dial = config.chrono_dial % (CDM_dual + 1);
-  config.display_lang = config.display_lang % num_langs;
-  config.face_index = config.face_index % NUM_FACES;
-  for (int i = 0; i < NUM_DATE_WINDOWS; ++i) {
-    config.date_windows[i] = config.date_windows[i] % (DWM_debug_cache_total_size + 1);
+  for (uint32_t key = 0; key < CK_num_keys; ++key) {
+    uint8_t *p = config_field_ptr(key);
+    if (p != NULL) {
+      int size = config_fields[key].size;
+      write_config_field(p, size, validate_config_value(key, read_config_field(p, size)));
+    }
   }
-  config.week_numbering = config.week_numbering % (WNM_sat_1 + 1);
-  config.top_subdial = config.top_subdial % (TSM_moon_phase + 1);
-  config.color_mode = config.color_mode % NUM_FACE_COLORS;
 }
 
-void save_config() {
-  int wrote = persist_write_data(PERSIST_KEY, &config, sizeof(config));
-  if (wrote == sizeof(config)) {
-    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Saved config (%d, %d)", PERSIST_KEY, sizeof(config));
-  } else {
-    app_log(APP_LOG_LEVEL_ERROR, __FILE__, __LINE__, "Error saving config (%d, %d): %d", PERSIST_KEY, sizeof(config), wrote);
+static uint32_t fnv_byte(uint32_t hash, uint8_t b) {
+  return (hash ^ b) * 16777619u;
+}
+
+// Returns the FNV-1a hash of the config as the phone sees it: each key
+// that names a field in this build, in order, followed by its value as
+// four bytes, least significant first.  hashConfiguration() in
+// pebble-js-app.js computes the same hash from the phone's copy.
+uint32_t config_hash() {
+  uint32_t hash = 2166136261u;
+  for (uint32_t key = 0; key < CK_num_keys; ++key) {
+    uint8_t *p = config_field_ptr(key);
+    if (p != NULL) {
+      uint32_t value = read_config_field(p, config_fields[key].size);
+      hash = fnv_byte(hash, key);
+      for (int i = 0; i < 4; ++i) {
+        hash = fnv_byte(hash, value >> (8 * i));
+      }
+    }
   }
+  return hash;
 }
 
-void load_config() {
-  config = default_options;
+// Answers a sync message from the phone with the hash of the config we
+// now have.
+static void send_config_hash(uint32_t hash) {
+  DictionaryIterator *iter;
+  AppMessageResult result = app_message_outbox_begin(&iter);
+  if (result != APP_MSG_OK) {
+    app_log(APP_LOG_LEVEL_WARNING, __FILE__, __LINE__, "Couldn't send config hash: 0x%04x", result);
+    return;
+  }
+  dict_write_uint32(iter, CK_config_hash, hash);
+  dict_write_uint8(iter, CK_config_protocol, CONFIG_PROTOCOL_VERSION);
+  dict_write_uint32(iter, CK_config_inbox_size, config_inbox_size);
+  app_message_outbox_send();
+}
 
-  ConfigOptions local_config;
-  int read_size = persist_read_data(PERSIST_KEY, &local_config, sizeof(local_config));
-  if (read_size == sizeof(local_config)) {
-    config = local_config;
-    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Loaded config (%d, %d)", PERSIST_KEY, sizeof(config));
-  } else {
-    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "No previous config (%d, %d): %d", PERSIST_KEY, sizeof(config), read_size);
+// Reads the integer value of a tuple from the phone into *value.
+// Returns false if the tuple isn't an integer.
+static bool read_tuple_int(const Tuple *tuple, int32_t *value) {
+  if (tuple->type != TUPLE_INT && tuple->type != TUPLE_UINT) {
+    return false;
   }
+  bool is_signed = (tuple->type == TUPLE_INT);
+  switch (tuple->length) {
+  case 1:
+    *value = is_signed ? tuple->value->int8 : tuple->value->uint8;
+    return true;
+  case 2:
+    *value = is_signed ? tuple->value->int16 : tuple->value->uint16;
+    return true;
+  case 4:
+    *value = tuple->value->int32;
+    return true;
+  default:
+    return false;
+  }
+}
 
-  sanitize_config();
+// The config is saved as a header followed by a bit-packed run of
+// tagged records, one per field: the field's ConfigKey in 5 bits, the
+// width of its value less 1 in 3 bits, then the value itself in that
+// many bits, least significant bit first throughout.  Since each
+// record is tagged and self-describing, a field added in a later
+// version simply keeps its default when an older config is loaded,
+// and a field since removed is skipped.  The header also records the
+// config version the values were saved under, so that a value whose
+// meaning has changed since can be mapped by migrate_config_value().
+// Format 1 was the raw ConfigOptions struct, which is still read once,
+// and rewritten.  Format 2, which lacked the config version, was never
+// released, and isn't read.
+#define CONFIG_FORMAT_VERSION 3
+#define CONFIG_MAGIC 0xc0
+#define CONFIG_KEY_BITS 5
+#define CONFIG_WIDTH_BITS 3
+#define CONFIG_RECORDS_MAX ((CK_num_keys * (CONFIG_KEY_BITS + CONFIG_WIDTH_BITS + 8) + 7) / 8)
+
+typedef struct __attribute__((__packed__)) {
+  uint8_t magic;       // CONFIG_MAGIC.
+  uint8_t version;     // CONFIG_FORMAT_VERSION when it was saved.
+  uint8_t config_version_major;  // CONFIG_VERSION_MAJOR and _MINOR when it was saved.
+  uint8_t config_version_minor;
+  uint8_t size;        // The number of bytes of records that follow.
+  uint16_t checksum;   // The Fletcher-16 checksum of those bytes.
+} SavedConfigHeader;
+
+typedef struct __attribute__((__packed__)) {
+  SavedConfigHeader header;
+  uint8_t records[CONFIG_RECORDS_MAX];
+} SavedConfig;
+
+typedef struct {
+  uint8_t *data;
+  int size;      // In bytes.
+  int bit;       // The next bit to read or write.
+} ConfigBits;
+
+static void put_config_bits(ConfigBits *cb, uint32_t value, int num_bits) {
+  for (int i = 0; i < num_bits; ++i, ++cb->bit) {
+    if (value & (1 << i)) {
+      cb->data[cb->bit / 8] |= (1 << (cb->bit % 8));
+    }
+  }
 }
 
+// Reads num_bits into *value.  Returns false if there aren't that
+// many bits left.
+static bool get_config_bits(ConfigBits *cb, uint32_t *value, int num_bits) {
+  if (cb->bit + num_bits > cb->size * 8) {
+    return false;
+  }
+  *value = 0;
+  for (int i = 0; i < num_bits; ++i, ++cb->bit) {
+    if (cb->data[cb->bit / 8] & (1 << (cb->bit % 8))) {
+      *value |= (1 << i);
+    }
+  }
+  return true;
+}
 
-void dropped_config_handler(AppMessageResult reason, void *context) {
-  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "dropped message: 0x%04x", reason);
+static uint16_t config_checksum(const uint8_t *data, int size) {
+  uint16_t sum1 = 0, sum2 = 0;
+  for (int i = 0; i < size; ++i) {
+    sum1 = (sum1 + data[i]) % 255;
+    sum2 = (sum2 + sum1) % 255;
+  }
+  return (sum2 << 8) | sum1;
 }
 
-void receive_config_handler(DictionaryIterator *received, void *context) {
-  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "receive_config_handler, memory_panic_count = %d", memory_panic_count);
-  ConfigOptions orig_config = config;
+static bool config_saved_before(const SavedConfigHeader *header, int major, int minor) {
+  return (header->config_version_major < major ||
+          (header->config_version_major == major && header->config_version_minor < minor));
+}
 
-  Tuple *battery_gauge = dict_find(received, CK_battery_gauge);
-  if (battery_gauge != NULL) {
-    config.battery_gauge = (IndicatorMode)battery_gauge->value->int32;
+// Maps a value saved under an older config version to its meaning in
+// the current version, as the phone does in pebble-js-app.js for its
+// own copy.
+static uint32_t migrate_config_value(const SavedConfigHeader *header, uint32_t key, uint32_t value) {
+  if (config_saved_before(header, 4, 3)) {
+    // 4.3 inserted DWM_yday and DWM_week at positions 4 and 5.
+    if (key >= CK_date_window_a && key <= CK_date_window_d && value >= DWM_yday) {
+      value += 2;
+    }
   }
+  return value;
+}
 
-  Tuple *bluetooth_indicator = dict_find(received, CK_bluetooth_indicator);
-  if (bluetooth_indicator != NULL) {
-    config.bluetooth_indicator = (IndicatorMode)bluetooth_indicator->value->int32;
+void save_config() {
+  SavedConfig saved;
+  memset(&saved, 0, sizeof(saved));
+  ConfigBits cb = { saved.records, sizeof(saved.records), 0 };
+  for (uint32_t key = 0; key < CK_num_keys; ++key) {
+    uint8_t *p = config_field_ptr(key);
+    if (p != NULL) {
+      uint32_t value = read_config_field(p, config_fields[key].size);
+      int width = 1;
+      while (width < 8 && (value >> width) != 0) {
+        ++width;
+      }
+      put_config_bits(&cb, key, CONFIG_KEY_BITS);
+      put_config_bits(&cb, width - 1, CONFIG_WIDTH_BITS);
+      put_config_bits(&cb, value, width);
+    }
   }
 
-  Tuple *second_hand = dict_find(received, CK_second_hand);
-  if (second_hand != NULL) {
-    config.second_hand = (second_hand->value->int32 != 0);
+  saved.header.magic = CONFIG_MAGIC;
+  saved.header.version = CONFIG_FORMAT_VERSION;
+  saved.header.config_version_major = CONFIG_VERSION_MAJOR;
+  saved.header.config_version_minor = CONFIG_VERSION_MINOR;
+  saved.header.size = (cb.bit + 7) / 8;
+  saved.header.checksum = config_checksum(saved.records, saved.header.size);
+
+  int size = sizeof(saved.header) + saved.header.size;
+  int wrote = persist_write_data(PERSIST_KEY, &saved, size);
+  if (wrote == size) {
+    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Saved config (%d, %d)", PERSIST_KEY, size);
+  } else {
+    app_log(APP_LOG_LEVEL_ERROR, __FILE__, __LINE__, "Error saving config (%d, %d): %d", PERSIST_KEY, size, wrote);
   }
+}
 
-  Tuple *hour_buzzer = dict_find(received, CK_hour_buzzer);
-  if (hour_buzzer != NULL) {
-    config.hour_buzzer = (hour_buzzer->value->int32 != 0);
+// Decodes a saved config into config, over the defaults already
+// there.  Returns false if it isn't a valid saved config.
+static bool decode_saved_config(const SavedConfig *saved, int read_size) {
+  const SavedConfigHeader *header = &saved->header;
+  if (read_size < (int)sizeof(*header) || header->magic != CONFIG_MAGIC ||
+      header->version != CONFIG_FORMAT_VERSION ||
+      header->size > read_size - (int)sizeof(*header) ||
+      header->checksum != config_checksum(saved->records, header->size)) {
+    return false;
   }
 
-  Tuple *bluetooth_buzzer = dict_find(received, CK_bluetooth_buzzer);
-  if (bluetooth_buzzer != NULL) {
-    config.bluetooth_buzzer = (bluetooth_buzzer->value->int32 != 0);
+  ConfigBits cb = { (uint8_t *)saved->records, header->size, 0 };
+  uint32_t key, width, value;
+  while (get_config_bits(&cb, &key, CONFIG_KEY_BITS) &&
+         get_config_bits(&cb, &width, CONFIG_WIDTH_BITS) &&
+         get_config_bits(&cb, &value, width + 1)) {
+    set_config_value(key, migrate_config_value(header, key, value));
   }
+  return true;
+}
+
+void load_config() {
+  config = default_options;
+
+  union {
+    SavedConfig saved;
+    ConfigOptions legacy;
+  } buffer;
+  int read_size = persist_read_data(PERSIST_KEY, &buffer, sizeof(buffer));
+  if (decode_saved_config(&buffer.saved, read_size)) {
+    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Loaded config (%d, %d)", PERSIST_KEY, read_size);
+
+  } else if (read_size == sizeof(ConfigOptions)) {
+    // A config saved in format 1, the raw struct.  This is the same
+    // struct we still use, so it needs only to be checked, and saved
+    // again in the current format.
+    config = buffer.legacy;
+    sanitize_config();
+    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Migrating config (%d, %d)", PERSIST_KEY, read_size);
+    save_config();
 
-  Tuple *draw_mode = dict_find(received, CK_draw_mode);
-  if (draw_mode != NULL) {
-    config.draw_mode = draw_mode->value->int32;
+  } else {
+    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "No previous config (%d): %d", PERSIST_KEY, read_size);
   }
+}
 
-  Tuple *color_mode = dict_find(received, CK_color_mode);
-  if (color_mode != NULL) {
-    config.color_mode = color_mode->value->int32;
+
+// Compares the two configs field by field, and returns the set of
+// ConfigChange bits naming the parts of the watch that depend on the
+// fields that differ.
+unsigned int config_changes(const ConfigOptions *orig_config, const ConfigOptions *new_config) {
+  unsigned int changes = 0;
+
+  if (orig_config->battery_gauge != new_config->battery_gauge ||
+      orig_config->bluetooth_indicator != new_config->bluetooth_indicator) {
+    // The indicators are drawn into the clock face.
+    changes |= CC_clock_face;
   }
 
-  Tuple *chrono_dial = dict_find(received, CK_chrono_dial);
-  if (chrono_dial != NULL) {
-    config.chrono_dial = (ChronoDialMode)chrono_dial->value->int32;
+  if (orig_config->second_hand != new_config->second_hand) {
+    // The second hand is drawn fresh each frame, but it sets the tick
+    // rate.
+    changes |= CC_redraw | CC_tick_timer;
   }
 
-  Tuple *sweep_seconds = dict_find(received, CK_sweep_seconds);
-  if (sweep_seconds != NULL) {
-    config.sweep_seconds = sweep_seconds->value->int32;
+  // hour_buzzer and bluetooth_buzzer are consulted only when the
+  // event happens; nothing depends on them otherwise.
+
+  if (orig_config->draw_mode != new_config->draw_mode ||
+      orig_config->color_mode != new_config->color_mode) {
+    changes |= CC_colors | CC_clock_face;
   }
 
-  Tuple *display_lang = dict_find(received, CK_display_lang);
-  if (display_lang != NULL) {
-    config.display_lang = display_lang->value->int32;
+  if (orig_config->chrono_dial != new_config->chrono_dial) {
+    // The dial is drawn into the clock face, and the tenths hand
+    // moves differently on each dial.
+    changes |= CC_hands | CC_clock_face;
   }
 
-  Tuple *face_index = dict_find(received, CK_face_index);
-  if (face_index != NULL) {
-    config.face_index = face_index->value->int32;
+  if (orig_config->sweep_seconds != new_config->sweep_seconds) {
+    changes |= CC_hands | CC_tick_timer;
   }
 
-  for (int i = 0; i < NUM_DATE_WINDOWS; ++i) {
-    char key = DATE_WINDOW_KEYS[i];
-    Tuple *date_window_x = dict_find(received, CK_date_window_a + (key - 'a'));
-    if (date_window_x != NULL) {
-      config.date_windows[i] = date_window_x->value->int32;
-    }
+  if (orig_config->display_lang != new_config->display_lang) {
+    changes |= CC_date_names | CC_date_fonts | CC_clock_face;
   }
 
-  Tuple *lunar_background = dict_find(received, CK_lunar_background);
-  if (lunar_background != NULL) {
-    config.lunar_background = (lunar_background->value->int32 != 0);
+  if (orig_config->face_index != new_config->face_index) {
+    changes |= CC_face_bitmap | CC_clock_face;
   }
 
-  Tuple *lunar_direction = dict_find(received, CK_lunar_direction);
-  if (lunar_direction != NULL) {
-    config.lunar_direction = (lunar_direction->value->int32 != 0);
+  bool shows_week = false;
+  for (int i = 0; i < NUM_DATE_WINDOWS; ++i) {
+    if (orig_config->date_windows[i] != new_config->date_windows[i]) {
+      changes |= CC_clock_face;
+    }
+    if (new_config->date_windows[i] == DWM_week) {
+      shows_week = true;
+    }
   }
 
-  Tuple *week_numbering = dict_find(received, CK_week_numbering);
-  if (week_numbering != NULL) {
-    config.week_numbering = week_numbering->value->int32;
+  if (orig_config->week_numbering != new_config->week_numbering && shows_week) {
+    changes |= CC_clock_face;
   }
 
-  Tuple *top_subdial = dict_find(received, CK_top_subdial);
-  if (top_subdial != NULL) {
-    config.top_subdial = top_subdial->value->int32;
+  if (orig_config->lunar_background != new_config->lunar_background ||
+      orig_config->lunar_direction != new_config->lunar_direction ||
+      orig_config->top_subdial != new_config->top_subdial) {
+    // The indicator placement also depends on top_subdial.
+    changes |= CC_top_subdial | CC_clock_face;
   }
 
-  Tuple *show_debug = dict_find(received, CK_show_debug);
-  if (show_debug != NULL) {
-    config.show_debug = (show_debug->value->int32 != 0);
+  // show_debug is used only by the config page.
+
+  return changes;
+}
+
+void dropped_config_handler(AppMessageResult reason, void *context) {
+  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "dropped message: 0x%04x", reason);
+}
+
+void receive_config_handler(DictionaryIterator *received, void *context) {
+  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "receive_config_handler, memory_panic_count = %d", memory_panic_count);
+  ConfigOptions orig_config = config;
+
+  // Walk through the message once, validating each value as it is
+  // stored.
+  bool sync = false;
+  uint32_t expected_hash = 0;
+  for (Tuple *tuple = dict_read_first(received); tuple != NULL; tuple = dict_read_next(received)) {
+    int32_t value;
+    if (!read_tuple_int(tuple, &value)) {
+      continue;
+    }
+    if (tuple->key == CK_config_protocol) {
+      sync = true;
+    } else if (tuple->key == CK_config_hash) {
+      expected_hash = (uint32_t)value;
+    } else {
+      set_config_value(tuple->key, (uint32_t)value);
+    }
   }
-  
-  sanitize_config();
 
   app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "New config");
   if (memcmp(&orig_config, &config, sizeof(config)) == 0) {
     app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Config is unchanged.");
   } else {
     save_config();
-    apply_config();
+    unsigned int changes = config_changes(&orig_config, &config);
+    if (changes != 0) {
+      apply_config_changes(changes);
+    }
+  }
+
+  if (sync) {
+    uint32_t hash = config_hash();
+    if (hash != expected_hash) {
+      app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Config hash 0x%08x, phone expected 0x%08x", (unsigned int)hash, (unsigned int)expected_hash);
+    }
+    send_config_hash(hash);
   }
 }
 
@@ -27,8 +27,26 @@ typedef enum {
   CK_top_subdial = 17,
   CK_show_debug = 18,
   CK_week_numbering = 19,
+
+  // These keys carry the sync protocol, not config fields.
+  CK_config_hash = 20,
+  CK_config_protocol = 21,
+  CK_config_inbox_size = 22,
+
+  CK_num_keys = 23,
 } ConfigKey;
 
+// The version of the config sync protocol.  The phone sends
+// CK_config_protocol, and CK_config_hash with the hash of the whole
+// config it expects the watch to have, along with only the keys that
+// have changed since the watch last acknowledged a config.  The watch
+// applies those keys, and answers with the same two keys, carrying
+// config_hash() of the config it now has, along with
+// CK_config_inbox_size, so the phone knows how many keys it can send
+// in one message.  If the hashes differ, the phone sends the whole
+// config again.
+#define CONFIG_PROTOCOL_VERSION 1
+
 typedef enum {
   IM_off = 0,
   IM_when_needed = 1,
@@ -106,7 +124,24 @@ typedef struct {
   bool show_debug;
 } __attribute__((__packed__)) ConfigOptions;
 
+// The parts of the watch that may need to be rebuilt when the config
+// changes.  config_changes() maps each changed field to the parts that
+// depend on it, so a new setting from the phone rebuilds only those.
+typedef enum {
+  CC_redraw = 0x0001,         // Redraw the window.
+  CC_clock_face = 0x0002,     // Redraw the cached clock face.
+  CC_face_bitmap = 0x0004,    // Reload the face background.
+  CC_colors = 0x0008,         // Reload every color-remapped bitmap and hand.
+  CC_top_subdial = 0x0010,    // Reload the top subdial and moon wheel.
+  CC_date_names = 0x0020,     // Reload the weekday, month, and ampm names.
+  CC_date_fonts = 0x0040,     // Reload the date window fonts.
+  CC_hands = 0x0080,          // Recompute the hand placement.
+  CC_tick_timer = 0x0100,     // Resubscribe the tick and sweep timers.
+  CC_all = 0xffff,            // Recreate everything from scratch.
+} ConfigChange;
+
 extern ConfigOptions config;
+extern uint32_t config_inbox_size;  // As passed to app_message_open().
 
 void init_default_options();
 void save_config();
@@ -114,8 +149,11 @@ void load_config();
 
 void dropped_config_handler(AppMessageResult reason, void *context);
 void receive_config_handler(DictionaryIterator *received, void *context);
+unsigned int config_changes(const ConfigOptions *orig_config, const ConfigOptions *new_config);
+uint32_t config_hash();
 
 void apply_config();  // implemented in the main program
+void apply_config_changes(unsigned int changes);  // implemented in the main program
 
 #ifdef SCREENSHOT_BUILD
 void config_set_click_config(struct Window *window);
@@ -90,11 +90,35 @@ struct __attribute__((__packed__)) HandDef {
   // unneeded cost of constantly decompressing these things.)
   bool use_rle;
 
+  // This is true if the hand's masks must actually be drawn on this
+  // platform.  It is false for a hand without a mask, and also for a
+  // color hand that has masks only for the sake of Aplite (no
+  // explicit _mask.png): its masks on a color platform are trivial
+  // placeholders, which are never loaded.
+  bool use_mask;
+
+  // This is true if the hand is rotated at runtime (see
+  // RUNTIME_HAND_ROTATION), rather than drawn from a baked bitmap for
+  // each step.  In this case, resource_id (and resource_mask_id) is a
+  // single master bitmap of the hand at 12:00, bitmap_centers has a
+  // single entry for it, and bitmap_table is NULL.
+  bool use_rotation;
+
   // The table of center values, one for each of bitmap_index.
   struct BitmapHandCenterRow *bitmap_centers;
 
+  // If the hand's bitmaps (or its masks) were all encoded with one
+  // shared palette (config_watch.py -P), these are the ARGB8 colors
+  // of that palette, and the number of them; otherwise NULL and 0,
+  // and each bitmap carries a palette of its own.
+  uint8_t *palette_argb8;
+  uint8_t palette_size;
+  uint8_t *mask_palette_argb8;
+  uint8_t mask_palette_size;
+
   // The table of hand positions, one for each of NUM_STEPS.  This
-  // table is NULL if bitmaps are not in use for this hand.
+  // table is NULL if bitmaps are not in use for this hand, or if it
+  // is rotated at runtime.
   struct BitmapHandTableRow *bitmap_table;
 
   // The vector definition for the hand, or NULL if vectors are not in
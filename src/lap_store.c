@@ -0,0 +1,339 @@
+#include "wright.h"
+#include "lap_store.h"
+
+#ifdef MAKE_CHRONOGRAPH
+
+#define LAP_STORE_BLOCK_SIZE PERSIST_DATA_MAX_LENGTH
+#define LAP_VARINT_MAX 5  // Enough for any 32-bit value.
+
+// The header records which blocks of the ring are in use.  Blocks are
+// numbered by a sequence number that increases with each new block;
+// block seq lives in persist slot seq % LAP_STORE_NUM_BLOCKS.
+typedef struct __attribute__((__packed__)) {
+  uint16_t first_seq;   // The sequence number of the oldest block.
+  uint8_t num_blocks;   // The number of blocks in use, 0 if no laps.
+  uint16_t block_first_lap[LAP_STORE_NUM_BLOCKS];  // By slot: the number of the first lap in each block.
+} LapStoreHeader;
+
+static LapStoreHeader lap_header;
+
+// The newest block, which is the only one that is ever written to, is
+// kept in memory.
+static uint8_t lap_tail[LAP_STORE_BLOCK_SIZE];
+static size_t lap_tail_size = 0;
+static int lap_tail_count = 0;
+static unsigned int lap_tail_last = 0;
+
+// When a new block is begun before the newest one has been written,
+// the closed block is held here until it is.
+static uint8_t lap_closed[LAP_STORE_BLOCK_SIZE];
+static size_t lap_closed_size = 0;
+static int lap_closed_slot = 0;
+
+// Changes are written to persistent storage only by
+// lap_store_flush(), so that recording a lap or resetting never waits
+// on the flash.  These record what it has yet to do.
+static bool lap_reset_pending = false;
+static bool lap_header_dirty = false;
+static bool lap_closed_dirty = false;
+static bool lap_tail_dirty = false;
+
+// Walks through the laps of a block.
+typedef struct {
+  const uint8_t *p;
+  const uint8_t *end;
+  int count;
+  unsigned int value;
+} LapDecoder;
+
+static void lap_decoder_init(LapDecoder *ld, const uint8_t *data, size_t size) {
+  ld->p = data;
+  ld->end = data + size;
+  ld->count = 0;
+  ld->value = 0;
+}
+
+// Reads the next lap into ld->value.  Returns false at the end of the
+// block, or if the remaining data is malformed.
+static bool lap_decoder_next(LapDecoder *ld) {
+  uint32_t v = 0;
+  int shift = 0;
+  while (true) {
+    if (ld->p >= ld->end || shift >= 7 * LAP_VARINT_MAX) {
+      return false;
+    }
+    uint8_t b = *(ld->p)++;
+    v |= (uint32_t)(b & 0x7f) << shift;
+    shift += 7;
+    if ((b & 0x80) == 0) {
+      break;
+    }
+  }
+
+  if (ld->count == 0) {
+    // The first lap in the block is stored in full.
+    ld->value = v;
+  } else {
+    // The rest are zigzag-encoded deltas from the previous lap.  A lap
+    // time can be less than the one before it: the chrono is timed
+    // against the wall clock, so if the clock is set back while it
+    // runs, the next lap reads earlier.
+    int32_t delta = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+    ld->value += delta;
+  }
+  ++(ld->count);
+  return true;
+}
+
+// Encodes v as a varint into buffer, and returns its length.
+static size_t lap_encode_varint(uint8_t *buffer, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    buffer[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  buffer[n++] = (uint8_t)v;
+  return n;
+}
+
+static int lap_slot(int seq) {
+  return (uint16_t)seq % LAP_STORE_NUM_BLOCKS;
+}
+
+static int lap_tail_slot() {
+  return lap_slot(lap_header.first_seq + lap_header.num_blocks - 1);
+}
+
+static void save_lap_header() {
+  int wrote = persist_write_data(LAP_STORE_HEADER_KEY, &lap_header, sizeof(lap_header));
+  if (wrote != sizeof(lap_header)) {
+    app_log(APP_LOG_LEVEL_ERROR, __FILE__, __LINE__, "Error saving lap header: %d", wrote);
+  }
+}
+
+static void save_lap_block(int slot, const uint8_t *data, size_t size) {
+  int key = LAP_STORE_BLOCK_KEY + slot;
+  int wrote = persist_write_data(key, data, size);
+  if (wrote != (int)size) {
+    app_log(APP_LOG_LEVEL_ERROR, __FILE__, __LINE__, "Error saving lap block %d: %d", key, wrote);
+  }
+}
+
+// Begins a new, empty block at the end of the ring, dropping the
+// oldest block if the ring is full.  If the block being closed hasn't
+// been written yet, it is set aside in lap_closed for the next
+// lap_store_flush().
+static void lap_store_new_block() {
+  if (lap_tail_dirty) {
+    if (lap_closed_dirty) {
+      // Another block was closed since the last flush.  That takes a
+      // few hundred laps without a pause, so just flush now.
+      lap_store_flush();
+    } else {
+      memcpy(lap_closed, lap_tail, lap_tail_size);
+      lap_closed_size = lap_tail_size;
+      lap_closed_slot = lap_tail_slot();
+      lap_closed_dirty = true;
+      lap_tail_dirty = false;
+    }
+  }
+
+  int first_lap = lap_store_count();
+  int seq = lap_header.first_seq + lap_header.num_blocks;
+  if (lap_header.num_blocks == LAP_STORE_NUM_BLOCKS) {
+    ++lap_header.first_seq;
+    --lap_header.num_blocks;
+  }
+  ++lap_header.num_blocks;
+  lap_header.block_first_lap[lap_slot(seq)] = first_lap;
+  lap_header_dirty = true;
+
+  lap_tail_size = 0;
+  lap_tail_count = 0;
+  lap_tail_last = 0;
+}
+
+// Reads the header and the newest block from persistent storage.
+void lap_store_load() {
+  memset(&lap_header, 0, sizeof(lap_header));
+  lap_tail_size = 0;
+  lap_tail_count = 0;
+  lap_tail_last = 0;
+  lap_reset_pending = false;
+  lap_header_dirty = false;
+  lap_closed_dirty = false;
+  lap_tail_dirty = false;
+
+  LapStoreHeader local_header;
+  if (persist_read_data(LAP_STORE_HEADER_KEY, &local_header, sizeof(local_header)) != sizeof(local_header) ||
+      local_header.num_blocks > LAP_STORE_NUM_BLOCKS) {
+    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "No previous laps.");
+    return;
+  }
+  lap_header = local_header;
+  if (lap_header.num_blocks == 0) {
+    return;
+  }
+
+  int read_size = persist_read_data(LAP_STORE_BLOCK_KEY + lap_tail_slot(), lap_tail, sizeof(lap_tail));
+  if (read_size < 0) {
+    read_size = 0;
+  }
+
+  // Count the laps in the newest block, and find the last one.  If the
+  // block is somehow damaged, we keep only the laps that decode.
+  LapDecoder ld;
+  lap_decoder_init(&ld, lap_tail, read_size);
+  const uint8_t *good_end = lap_tail;
+  while (lap_decoder_next(&ld)) {
+    good_end = ld.p;
+    lap_tail_last = ld.value;
+  }
+  lap_tail_size = good_end - lap_tail;
+  lap_tail_count = ld.count;
+
+  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Loaded %d laps in %d blocks", lap_store_count() - lap_store_first(), lap_header.num_blocks);
+}
+
+// Removes all laps.  They are removed from persistent storage at the
+// next lap_store_flush().
+void lap_store_reset() {
+  memset(&lap_header, 0, sizeof(lap_header));
+  lap_tail_size = 0;
+  lap_tail_count = 0;
+  lap_tail_last = 0;
+  lap_reset_pending = true;
+  lap_header_dirty = false;
+  lap_closed_dirty = false;
+  lap_tail_dirty = false;
+}
+
+// Records a new lap.  It is written to persistent storage at the next
+// lap_store_flush().
+void lap_store_append(unsigned int lap_ms) {
+  if (lap_store_count() >= 0xffff) {
+    // The lap numbers are 16 bits.  That's a lot of laps.
+    return;
+  }
+
+  uint8_t buffer[LAP_VARINT_MAX];
+  size_t n = 0;
+  if (lap_header.num_blocks != 0 && lap_tail_count != 0) {
+    int32_t delta = (int32_t)(lap_ms - lap_tail_last);
+    n = lap_encode_varint(buffer, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+  }
+
+  if (lap_header.num_blocks == 0 || lap_tail_count == 0 || lap_tail_size + n > LAP_STORE_BLOCK_SIZE) {
+    if (lap_header.num_blocks == 0 || lap_tail_count != 0) {
+      lap_store_new_block();
+    }
+    n = lap_encode_varint(buffer, lap_ms);
+  }
+
+  memcpy(lap_tail + lap_tail_size, buffer, n);
+  lap_tail_size += n;
+  ++lap_tail_count;
+  lap_tail_last = lap_ms;
+  lap_tail_dirty = true;
+}
+
+// Returns true if there are changes not yet written to persistent
+// storage.
+bool lap_store_dirty() {
+  return lap_reset_pending || lap_header_dirty || lap_closed_dirty || lap_tail_dirty;
+}
+
+// Writes any pending changes to persistent storage now.  A pending
+// reset deletes the old blocks first, before any laps recorded since
+// are written.
+void lap_store_flush() {
+  if (lap_reset_pending) {
+    for (int slot = 0; slot < LAP_STORE_NUM_BLOCKS; ++slot) {
+      persist_delete(LAP_STORE_BLOCK_KEY + slot);
+    }
+    persist_delete(LAP_STORE_HEADER_KEY);
+    lap_reset_pending = false;
+  }
+  if (lap_closed_dirty) {
+    save_lap_block(lap_closed_slot, lap_closed, lap_closed_size);
+    lap_closed_dirty = false;
+  }
+  if (lap_header_dirty) {
+    save_lap_header();
+    lap_header_dirty = false;
+  }
+  if (lap_tail_dirty) {
+    save_lap_block(lap_tail_slot(), lap_tail, lap_tail_size);
+    lap_tail_dirty = false;
+  }
+}
+
+// Returns the number of laps recorded since the last reset; this is
+// also one more than the number of the newest lap.
+int lap_store_count() {
+  if (lap_header.num_blocks == 0) {
+    return 0;
+  }
+  return lap_header.block_first_lap[lap_tail_slot()] + lap_tail_count;
+}
+
+// Returns the number of the oldest lap still in storage.
+int lap_store_first() {
+  if (lap_header.num_blocks == 0) {
+    return 0;
+  }
+  return lap_header.block_first_lap[lap_slot(lap_header.first_seq)];
+}
+
+// Reads laps [first, first + count) into laps[], reading each block
+// from persistent storage as needed.  Laps that are no longer
+// available are returned as 0.  Returns the number of laps actually
+// read.
+int lap_store_read(int first, int count, unsigned int laps[]) {
+  int num_read = 0;
+  memset(laps, 0, count * sizeof(unsigned int));
+
+  for (int bi = 0; bi < lap_header.num_blocks; ++bi) {
+    int seq = lap_header.first_seq + bi;
+    int slot = lap_slot(seq);
+    int block_first = lap_header.block_first_lap[slot];
+    int block_end = (bi + 1 < lap_header.num_blocks) ? lap_header.block_first_lap[lap_slot(seq + 1)] : lap_store_count();
+    if (block_end <= first || block_first >= first + count) {
+      // No laps wanted from this block.
+      continue;
+    }
+
+    const uint8_t *data = lap_tail;
+    size_t size = lap_tail_size;
+    uint8_t buffer[LAP_STORE_BLOCK_SIZE];
+    if (bi + 1 < lap_header.num_blocks && lap_closed_dirty && slot == lap_closed_slot) {
+      // This block hasn't been written yet.
+      data = lap_closed;
+      size = lap_closed_size;
+    } else if (bi + 1 < lap_header.num_blocks) {
+      int read_size = persist_read_data(LAP_STORE_BLOCK_KEY + slot, buffer, sizeof(buffer));
+      if (read_size < 0) {
+        continue;
+      }
+      data = buffer;
+      size = read_size;
+    }
+
+    LapDecoder ld;
+    lap_decoder_init(&ld, data, size);
+    while (lap_decoder_next(&ld)) {
+      int lap = block_first + ld.count - 1;
+      if (lap >= first + count) {
+        break;
+      }
+      if (lap >= first) {
+        laps[lap - first] = ld.value;
+        ++num_read;
+      }
+    }
+  }
+
+  return num_read;
+}
+
+#endif  // MAKE_CHRONOGRAPH
@@ -0,0 +1,40 @@
+#ifndef LAP_STORE_H
+#define LAP_STORE_H
+
+#include <pebble.h>
+#include "../resources/generated_config.h"
+
+#ifdef MAKE_CHRONOGRAPH
+
+// This module keeps the chronograph's lap history in persistent
+// storage, in a ring of blocks of up to PERSIST_DATA_MAX_LENGTH bytes
+// each, so that the number of laps is limited only by the storage
+// set aside for them.  Each block holds a run of laps, with the first
+// stored in full and the rest as the difference from the previous
+// lap, as varints.  Recording a lap rewrites only the newest block
+// (and the small header, when a new block is begun); when the ring is
+// full, the oldest block is dropped to make room.  Changes are held
+// in memory until lap_store_flush(), which the chronograph calls from
+// its deferred save and at exit.  Laps are read back
+// lazily, a few at a time, for the lap view.
+
+// Laps are numbered from 0, in the order they were recorded, since
+// the last reset.  Once the ring has wrapped, the oldest laps are
+// lost, and lap_store_first() returns the first lap still available.
+
+#define LAP_STORE_HEADER_KEY (PERSIST_KEY + 0x200)
+#define LAP_STORE_BLOCK_KEY (PERSIST_KEY + 0x201)  // through + LAP_STORE_NUM_BLOCKS - 1
+#define LAP_STORE_NUM_BLOCKS 8
+
+void lap_store_load();
+void lap_store_reset();
+void lap_store_append(unsigned int lap_ms);
+bool lap_store_dirty();
+void lap_store_flush();
+int lap_store_count();
+int lap_store_first();
+int lap_store_read(int first, int count, unsigned int laps[]);
+
+#endif  // MAKE_CHRONOGRAPH
+
+#endif  // LAP_STORE_H
@@ -178,6 +178,7 @@ VibePattern tap = {
 void create_temporal_objects();
 void destroy_temporal_objects();
 void recreate_all_objects();
+void load_date_fonts();
 void draw_full_date_window(GContext *ctx, int date_window_index);
 void draw_date_window_debug_text(GContext *ctx, int date_window_index);
 
@@ -225,10 +226,21 @@ void hand_cache_init(struct HandCache *hand_cache) {
   memset(hand_cache, 0, sizeof(struct HandCache));
 }
 
-// Release any memory held within a HandCache structure.
+// Release any memory held within a HandCache structure.  This also
+// forgets the remapped shared palettes, so they are remapped again
+// (e.g. in new colors) on next use.
 void hand_cache_destroy(struct HandCache *hand_cache) {
   bwd_destroy(&hand_cache->image);
   bwd_destroy(&hand_cache->mask);
+#ifdef RUNTIME_HAND_ROTATION
+  // The rotations borrow the palettes of the masters, so the masters
+  // go last.
+  bwd_destroy(&hand_cache->master_image);
+  bwd_destroy(&hand_cache->master_mask);
+#endif  // RUNTIME_HAND_ROTATION
+#ifndef PBL_PLATFORM_APLITE
+  hand_cache->palettes_ready = false;
+#endif  // PBL_PLATFORM_APLITE
   int gi;
   for (gi = 0; gi < HAND_CACHE_MAX_GROUPS; ++gi) {
     if (hand_cache->path[gi] != NULL) {
@@ -248,6 +260,35 @@ make_gmt_date(int mday, int mon, int year) {
   return mktime(&t);
 }
 
+// Sets the hour, minute, and second hand indexes, and the buzzed
+// hour, from the indicated number of milliseconds since midnight.
+// Each division is done with STEP_DIV(), and each hand's time within
+// its own cycle is taken from the next larger one.
+void compute_hand_indexes(unsigned int ms, struct HandPlacement *placement) {
+  unsigned int hours = STEP_DIV(MS_HOURS, ms);
+  unsigned int hour_ms = ms - hours * (SECONDS_PER_HOUR * 1000);
+  unsigned int half_day_hours = hours;
+  while (half_day_hours >= 12) {
+    half_day_hours -= 12;
+  }
+  unsigned int half_day_ms = half_day_hours * (SECONDS_PER_HOUR * 1000) + hour_ms;
+  unsigned int minute_ms = hour_ms - STEP_DIV(MS_MINUTES, hour_ms) * (60 * 1000);
+
+  placement->hour_hand_index = STEP_DIV(HOUR_HAND, half_day_ms);
+  placement->minute_hand_index = STEP_DIV(MINUTE_HAND, hour_ms);
+  {
+    unsigned int use_ms = minute_ms;
+    if (!config.sweep_seconds) {
+      // Constrain to an integer second if we've not enabled
+      // sweep-second resolution.
+      use_ms = STEP_DIV(MS_SECONDS, use_ms) * 1000;
+    }
+    placement->second_hand_index = STEP_DIV(SECOND_HAND, use_ms);
+  }
+
+  placement->buzzed_hour = (hours >= 24) ? hours - 24 : hours;
+}
+
 // Determines the specific hand bitmaps that should be displayed based
 // on the current time.
 void compute_hands(struct tm *stime, struct HandPlacement *placement) {
@@ -269,45 +310,37 @@ void compute_hands(struct tm *stime, struct HandPlacement *placement) {
     // structure we were passed in.
     
     // Get the Unix time (in UTC).
-    time_ms(&gmt, &t_ms);
+    clock_time_ms(&gmt, &t_ms);
 
     // Compute the number of milliseconds elapsed since midnight, local time.
     struct tm *tm = localtime(&gmt);
     unsigned int s = (unsigned int)(tm->tm_hour * 60 + tm->tm_min) * 60 + tm->tm_sec;
     ms = (unsigned int)(s * 1000 + t_ms);
+    if (stime != NULL && !clock_source_is_real()) {
+      // The stime we were passed is the real time, not the clock
+      // source's time.
+      (*stime) = *tm;
+    }
 
   } else {
     // If we don't need sub-second precision, just use the existing
     // stime structure.  We still need UTC time, though, for the lunar
     // phase at least.
     assert(stime != NULL);
-    gmt = time(NULL);
+    gmt = clock_time(NULL);
+    if (!clock_source_is_real()) {
+      (*stime) = *localtime(&gmt);
+    }
     unsigned int s = (unsigned int)(stime->tm_hour * 60 + stime->tm_min) * 60 + stime->tm_sec;
     ms = (unsigned int)(s * 1000);
   }
 
 #ifdef MAKE_CHRONOGRAPH
   // For the chronograph, compute the number of milliseconds elapsed
-  // since midnight, UTC.
-  unsigned int ms_utc = (unsigned int)((gmt % SECONDS_PER_DAY) * 1000 + t_ms);
+  // since the epoch.
+  int64_t ms_utc = (int64_t)gmt * 1000 + t_ms;
 #endif  // MAKE_CHRONOGRAPH
   
-#ifdef FAST_TIME
-  {
-    if (stime != NULL) {
-      int s = ms / 1000;
-      int yday = s % 365;
-      
-      gmt = make_gmt_date(yday, 0, stime->tm_year);
-      (*stime) = *gmtime(&gmt);
-    }
-    ms *= 67;
-#ifdef MAKE_CHRONOGRAPH
-    ms_utc *= 67;
-#endif  // MAKE_CHRONOGRAPH
-  }
-#endif  // FAST_TIME
-
 #ifdef SCREENSHOT_BUILD
   // Freeze the time to 10:09 for screenshots.
   {
@@ -331,25 +364,7 @@ void compute_hands(struct tm *stime, struct HandPlacement *placement) {
   }
 #endif  // SCREENSHOT_BUILD
   
-  {
-    // Avoid overflowing the integer arithmetic by pre-constraining
-    // the ms value to the appropriate range.
-    unsigned int use_ms = ms % (SECONDS_PER_HOUR * 12 * 1000);
-    placement->hour_hand_index = ((NUM_STEPS_HOUR * use_ms) / (SECONDS_PER_HOUR * 12 * 1000)) % NUM_STEPS_HOUR;
-  }
-  {
-    unsigned int use_ms = ms % (SECONDS_PER_HOUR * 1000);
-    placement->minute_hand_index = ((NUM_STEPS_MINUTE * use_ms) / (SECONDS_PER_HOUR * 1000)) % NUM_STEPS_MINUTE;
-  }
-  {
-    unsigned int use_ms = ms % (60 * 1000);
-    if (!config.sweep_seconds) {
-      // Also constrain to an integer second if we've not enabled
-      // sweep-second resolution.
-      use_ms = (use_ms / 1000) * 1000;
-    }
-    placement->second_hand_index = ((NUM_STEPS_SECOND * use_ms) / (60 * 1000));
-  }
+  compute_hand_indexes(ms, placement);
 
   // Record data for date windows.
   if (stime != NULL) {
@@ -381,7 +396,7 @@ void compute_hands(struct tm *stime, struct HandPlacement *placement) {
       // (This integer computation is a bit less precise than the full
       // decimal value--by 2114 it have drifted off by about 2 hours.
       // Close enough.)
-      unsigned int lunar_age_s = lunar_offset_s % 2551443;
+      unsigned int lunar_age_s = lunar_offset_s - STEP_DIV(LUNAR_CYCLES, lunar_offset_s) * 2551443;
 
       // That gives the age of the moon in seconds.
 
@@ -389,14 +404,11 @@ void compute_hands(struct tm *stime, struct HandPlacement *placement) {
       // Compute the index of the moon wheel for the moon_phase
       // variant of the top subdial.  This ranges from 0 to
       // NUM_STEPS_MOON - 1 over the lunar month.
-      unsigned int lunar_index = (NUM_STEPS_MOON * lunar_age_s) / 2551443;
-      placement->lunar_index = lunar_index % NUM_STEPS_MOON;
+      placement->lunar_index = STEP_DIV(MOON, lunar_age_s);
 #endif  // TOP_SUBDIAL
     }
   }
 
-  placement->buzzed_hour = (ms / (SECONDS_PER_HOUR * 1000)) % 24;
-
 #ifdef MAKE_CHRONOGRAPH
   compute_chrono_hands(ms_utc, placement);
 #endif  // MAKE_CHRONOGRAPH
@@ -630,10 +642,100 @@ void draw_vector_hand(struct HandCache *hand_cache, struct HandDef *hand_def, in
   }
 }
 
-// Clears the mask given hand on the face, using the bitmap
-// structures, if the mask is in use.  This must be called before
-// draw_bitmap_hand_fg().
-void draw_bitmap_hand_mask(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARAMS, struct HandDef *hand_def, int hand_index, bool no_basalt_mask, GContext *ctx) {
+#ifndef PBL_PLATFORM_APLITE
+// Fills in a shared hand palette from its ARGB8 colors, remapped to the current colors.
+static void load_hand_palette(GColor *palette, uint8_t *palette_argb8, int palette_size) {
+  for (int pi = 0; pi < palette_size; ++pi) {
+    palette[pi].argb = palette_argb8[pi];
+  }
+  remap_palette_clock(palette, palette_size);
+}
+#endif  // PBL_PLATFORM_APLITE
+
+// Returns the hand's shared bitmap (or mask) palette, or NULL if each bitmap has its own.
+static GColor *get_hand_palette(struct HandCache *hand_cache, struct HandDef *hand_def, bool is_mask) {
+#ifndef PBL_PLATFORM_APLITE
+  if (!hand_def->use_rle) {
+    // Only RLE bitmaps can share a palette.
+    return NULL;
+  }
+  if (!hand_cache->palettes_ready) {
+    load_hand_palette(hand_cache->palette, hand_def->palette_argb8, hand_def->palette_size);
+    load_hand_palette(hand_cache->mask_palette, hand_def->mask_palette_argb8, hand_def->mask_palette_size);
+    hand_cache->palettes_ready = true;
+  }
+  if (is_mask) {
+    return (hand_def->mask_palette_argb8 != NULL) ? hand_cache->mask_palette : NULL;
+  }
+  return (hand_def->palette_argb8 != NULL) ? hand_cache->palette : NULL;
+#else  // PBL_PLATFORM_APLITE
+  return NULL;
+#endif  // PBL_PLATFORM_APLITE
+}
+
+#ifdef RUNTIME_HAND_ROTATION
+// Decodes the indicated master bitmap of a hand that is rotated at
+// runtime into *master, if it isn't there already, and remaps it to
+// the current colors.
+static void load_master_bitmap(BitmapWithData *master, struct HandDef *hand_def, int resource_id, GColor *palette) {
+  if (master->bitmap != NULL) {
+    return;
+  }
+  if (hand_def->use_rle) {
+    *master = rle_bwd_create_shared(resource_id, palette);
+  } else {
+    *master = png_bwd_create(resource_id);
+  }
+  if (master->bitmap != NULL && palette == NULL) {
+    remap_colors_clock(master);
+  }
+}
+
+// Fills in the HandCache with the indicated step of a hand that is
+// rotated at runtime (and its mask, if with_mask is true), rotated
+// from the master bitmaps.  Returns false on failure.
+static bool rotate_bitmap_hand(struct HandCache *hand_cache, struct HandDef *hand_def, int hand_index, bool with_mask) {
+  load_master_bitmap(&hand_cache->master_image, hand_def, hand_def->resource_id, get_hand_palette(hand_cache, hand_def, false));
+  if (hand_cache->master_image.bitmap == NULL) {
+    return false;
+  }
+  if (with_mask) {
+    load_master_bitmap(&hand_cache->master_mask, hand_def, hand_def->resource_mask_id, get_hand_palette(hand_cache, hand_def, true));
+    if (hand_cache->master_mask.bitmap == NULL) {
+      return false;
+    }
+  }
+
+  int32_t angle = TRIG_MAX_ANGLE * hand_index / hand_def->num_steps;
+  struct BitmapHandCenterRow *lookup = &hand_def->bitmap_centers[0];
+  GPoint center = GPoint(lookup->cx, lookup->cy);
+  hand_cache->image = bwd_rotate(hand_cache->master_image.bitmap, angle, &center);
+  if (with_mask) {
+    // The mask has the same size and center as the image, so it comes
+    // out the same.
+    GPoint mask_center = GPoint(lookup->cx, lookup->cy);
+    hand_cache->mask = bwd_rotate(hand_cache->master_mask.bitmap, angle, &mask_center);
+    if (hand_cache->mask.bitmap == NULL) {
+      return false;
+    }
+  }
+  hand_cache->cx = center.x;
+  hand_cache->cy = center.y;
+  return hand_cache->image.bitmap != NULL;
+}
+#endif  // RUNTIME_HAND_ROTATION
+
+// Fills in the HandCache with the bitmap for the indicated step of a
+// bitmap hand (and its mask, if with_mask is true), loaded from the
+// resource file, and remapped and flipped into place.  Returns false
+// on failure.
+static bool load_bitmap_hand(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARAMS, struct HandDef *hand_def, int hand_index, bool with_mask) {
+#ifdef RUNTIME_HAND_ROTATION
+  if (hand_def->use_rotation) {
+    return rotate_bitmap_hand(hand_cache, hand_def, hand_index, with_mask);
+  }
+#endif  // RUNTIME_HAND_ROTATION
+
   struct BitmapHandTableRow *hand = &hand_def->bitmap_table[hand_index];
   int bitmap_index = hand->bitmap_index;
   struct BitmapHandCenterRow *lookup = &hand_def->bitmap_centers[bitmap_index];
@@ -641,47 +743,71 @@ void draw_bitmap_hand_mask(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PA
   int hand_resource_id = hand_def->resource_id + bitmap_index;
   int hand_resource_mask_id = hand_def->resource_mask_id + bitmap_index;
 
+  GColor *palette = get_hand_palette(hand_cache, hand_def, false);
+  GColor *mask_palette = get_hand_palette(hand_cache, hand_def, true);
+  if (hand_def->use_rle) {
+    hand_cache->image = rle_bwd_create_with_cache(hand_def->resource_id, hand_resource_id, palette RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
+    if (with_mask) {
+      hand_cache->mask = rle_bwd_create_with_cache(hand_def->resource_id, hand_resource_mask_id, mask_palette RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
+    }
+  } else {
+    hand_cache->image = png_bwd_create_with_cache(hand_def->resource_id, hand_resource_id RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
+    if (with_mask) {
+      hand_cache->mask = png_bwd_create_with_cache(hand_def->resource_id, hand_resource_mask_id RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
+    }
+  }
+  if (hand_cache->image.bitmap == NULL || (with_mask && hand_cache->mask.bitmap == NULL)) {
+    return false;
+  }
+  if (palette == NULL) {
+    remap_colors_clock(&hand_cache->image);
+  }
+  if (with_mask && mask_palette == NULL) {
+    remap_colors_clock(&hand_cache->mask);
+  }
+
+  hand_cache->cx = lookup->cx;
+  hand_cache->cy = lookup->cy;
+
+  if (hand->flip_x) {
+    // To minimize wasteful resource usage, if the hand is symmetric
+    // we can store only the bitmaps for the right half of the clock
+    // face, and flip them for the left half.
+    flip_bitmap_x(hand_cache->image.bitmap, &hand_cache->cx);
+    if (with_mask) {
+      flip_bitmap_x(hand_cache->mask.bitmap, NULL);
+    }
+  }
+
+  if (hand->flip_y) {
+    // We can also do this vertically.
+    flip_bitmap_y(hand_cache->image.bitmap, &hand_cache->cy);
+    if (with_mask) {
+      flip_bitmap_y(hand_cache->mask.bitmap, NULL);
+    }
+  }
+  return true;
+}
+
+// Clears the mask given hand on the face, using the bitmap
+// structures, if the mask is in use.  This must be called before
+// draw_bitmap_hand_fg().
+void draw_bitmap_hand_mask(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARAMS, struct HandDef *hand_def, int hand_index, bool no_basalt_mask, GContext *ctx) {
 #ifdef PBL_PLATFORM_APLITE
-  if (hand_def->resource_id == hand_def->resource_mask_id)
+  if (!hand_def->use_mask)
 #else
-  if (no_basalt_mask || hand_def->resource_id == hand_def->resource_mask_id)
+  if (no_basalt_mask || !hand_def->use_mask)
 #endif  // PBL_PLATFORM_APLITE
   {
     // The draw-without-a-mask case.  Do nothing here.
   } else {
     // The hand has a mask, so use it to draw the hand opaquely.
     if (hand_cache->image.bitmap == NULL) {
-      if (hand_def->use_rle) {
-        hand_cache->image = rle_bwd_create_with_cache(hand_def->resource_id, hand_resource_id RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
-        hand_cache->mask = rle_bwd_create_with_cache(hand_def->resource_id, hand_resource_mask_id RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
-      } else {
-        hand_cache->image = png_bwd_create_with_cache(hand_def->resource_id, hand_resource_id RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
-        hand_cache->mask = png_bwd_create_with_cache(hand_def->resource_id, hand_resource_mask_id RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
-      }
-      if (hand_cache->image.bitmap == NULL || hand_cache->mask.bitmap == NULL) {
+      if (!load_bitmap_hand(hand_cache RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size), hand_def, hand_index, true)) {
         hand_cache_destroy(hand_cache);
 	trigger_memory_panic(__LINE__);
         return;
       }
-      remap_colors_clock(&hand_cache->image);
-      remap_colors_clock(&hand_cache->mask);
-
-      hand_cache->cx = lookup->cx;
-      hand_cache->cy = lookup->cy;
-    
-      if (hand->flip_x) {
-        // To minimize wasteful resource usage, if the hand is symmetric
-        // we can store only the bitmaps for the right half of the clock
-        // face, and flip them for the left half.
-        flip_bitmap_x(hand_cache->image.bitmap, &hand_cache->cx);
-        flip_bitmap_x(hand_cache->mask.bitmap, NULL);
-      }
-    
-      if (hand->flip_y) {
-        // We can also do this vertically.
-        flip_bitmap_y(hand_cache->image.bitmap, &hand_cache->cy);
-        flip_bitmap_y(hand_cache->mask.bitmap, NULL);
-      }
     }
     
     GRect destination = gbitmap_get_bounds(hand_cache->image.bitmap);
@@ -696,47 +822,20 @@ void draw_bitmap_hand_mask(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PA
 // Draws a given hand on the face, using the bitmap structures.  You
 // must have already called draw_bitmap_hand_mask().
 void draw_bitmap_hand_fg(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARAMS, struct HandDef *hand_def, int hand_index, bool no_basalt_mask, GContext *ctx) {
-  struct BitmapHandTableRow *hand = &hand_def->bitmap_table[hand_index];
-  int bitmap_index = hand->bitmap_index;
-  struct BitmapHandCenterRow *lookup = &hand_def->bitmap_centers[bitmap_index];
-
-  int hand_resource_id = hand_def->resource_id + bitmap_index;
-
 #ifdef PBL_PLATFORM_APLITE
-  if (hand_def->resource_id == hand_def->resource_mask_id)
+  if (!hand_def->use_mask)
 #else
-  if (no_basalt_mask || hand_def->resource_id == hand_def->resource_mask_id)
+  if (no_basalt_mask || !hand_def->use_mask)
 #endif  // PBL_PLATFORM_APLITE
   {
     // The hand does not have a mask.  Draw the hand on top of the scene.
     if (hand_cache->image.bitmap == NULL) {
       // All right, load it from the resource file.
-      if (hand_def->use_rle) {
-        hand_cache->image = rle_bwd_create_with_cache(hand_def->resource_id, hand_resource_id RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
-      } else {
-        hand_cache->image = png_bwd_create_with_cache(hand_def->resource_id, hand_resource_id RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size));
-      }
-      if (hand_cache->image.bitmap == NULL) {
+      if (!load_bitmap_hand(hand_cache RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size), hand_def, hand_index, false)) {
         hand_cache_destroy(hand_cache);
         trigger_memory_panic(__LINE__);
         return;
       }
-      remap_colors_clock(&hand_cache->image);
-
-      hand_cache->cx = lookup->cx;
-      hand_cache->cy = lookup->cy;
-
-      if (hand->flip_x) {
-        // To minimize wasteful resource usage, if the hand is symmetric
-        // we can store only the bitmaps for the right half of the clock
-        // face, and flip them for the left half.
-        flip_bitmap_x(hand_cache->image.bitmap, &hand_cache->cx);
-      }
-    
-      if (hand->flip_y) {
-        // We can also do this vertically.
-        flip_bitmap_y(hand_cache->image.bitmap, &hand_cache->cy);
-      }
     }
       
     // We make sure the dimensions of the GRect to draw into
@@ -777,7 +876,7 @@ void draw_bitmap_hand_fg(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARA
 // In general, prepares a hand for being drawn.  Specifically, this
 // clears the background behind a hand, if necessary.
 void draw_hand_mask(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARAMS, struct HandDef *hand_def, int hand_index, bool no_basalt_mask, GContext *ctx) {
-  if (hand_def->bitmap_table != NULL) {
+  if (hand_def->bitmap_centers != NULL) {
     if (hand_cache->bitmap_hand_index != hand_index) {
       // Force a new bitmap.
       if (hand_cache->image.bitmap != NULL) {
@@ -801,7 +900,7 @@ void draw_hand_fg(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARAMS, str
     draw_vector_hand(hand_cache, hand_def, hand_index, ctx);
   }
 
-  if (hand_def->bitmap_table != NULL) {
+  if (hand_def->bitmap_centers != NULL) {
     draw_bitmap_hand_fg(hand_cache RESOURCE_CACHE_PARAMS(resource_cache, resource_cache_size), hand_def, hand_index, no_basalt_mask, ctx);
   }
 }
@@ -821,6 +920,14 @@ void remap_colors_clock(BitmapWithData *bwd) {
 #endif  // PBL_PLATFORM_APLITE
 }
 
+// As above, for a shared palette.
+void remap_palette_clock(GColor *palette, int palette_size) {
+#ifndef PBL_PLATFORM_APLITE
+  struct FaceColorDef *cd = &clock_face_color_table[config.color_mode];
+  bwd_remap_palette(palette, palette_size, (GColor8){.argb=cd->cb_argb8}, (GColor8){.argb=cd->c1_argb8}, (GColor8){.argb=cd->c2_argb8}, (GColor8){.argb=cd->c3_argb8}, config.draw_mode);
+#endif  // PBL_PLATFORM_APLITE
+}
+
 // Applies the appropriate Basalt color-remapping according to the
 // selected color mode, for the indicated date-window bitmap.
 static void remap_colors_date(BitmapWithData *bwd) {
@@ -1632,7 +1739,11 @@ void update_hands(struct tm *time) {
 
   if (new_placement.second_hand_index != current_placement.second_hand_index) {
     current_placement.second_hand_index = new_placement.second_hand_index;
-    layer_mark_dirty(clock_face_layer);
+    if (config.second_hand) {
+      // No need to redraw for a second hand that isn't shown (we may
+      // be ticking every second anyway, with a fast clock source).
+      layer_mark_dirty(clock_face_layer);
+    }
   }
 
   if (new_placement.buzzed_hour != current_placement.buzzed_hour) {
@@ -1754,11 +1865,14 @@ void window_unload_handler(struct Window *window) {
 void reset_tick_timer() {
   tick_timer_service_unsubscribe();
 
-#if defined(FAST_TIME) || defined(BATTERY_HACK)
+  // When the clock source isn't the real clock (for instance, in a
+  // FAST_TIME build), the hands may move by more than a minute per
+  // real minute, so we need to check them every second.
+#if defined(BATTERY_HACK)
   tick_timer_service_subscribe(SECOND_UNIT, handle_tick);
 
 #elif defined(MAKE_CHRONOGRAPH)
-  if (config.second_hand || chrono_data.running) {
+  if (config.second_hand || chrono_data.running || !clock_source_is_real()) {
     tick_timer_service_subscribe(SECOND_UNIT, handle_tick);
   } else {
     tick_timer_service_subscribe(MINUTE_UNIT, handle_tick);
@@ -1767,7 +1881,7 @@ void reset_tick_timer() {
   reset_chrono_digital_timer();
 
 #else
-  if (config.second_hand) {
+  if (config.second_hand || !clock_source_is_real()) {
     tick_timer_service_subscribe(SECOND_UNIT, handle_tick);
   } else {
     tick_timer_service_subscribe(MINUTE_UNIT, handle_tick);
@@ -1823,9 +1937,49 @@ void reset_memory_panic_count() {
   hide_clock_face = false;
 }
 
+// Releases the top subdial bitmaps, so they are reloaded as needed
+// for the current top_subdial and lunar settings.
+void destroy_top_subdial_objects() {
+  bwd_destroy(&pebble_label);
+  bwd_destroy(&top_subdial_frame_mask);
+  bwd_destroy(&top_subdial_mask);
+  bwd_destroy(&top_subdial_bitmap);
+  bwd_destroy(&moon_wheel_bitmap);
+}
+
+// Releases every bitmap that has been remapped to the current
+// draw_mode and color_mode, along with the cached hands, so they are
+// reloaded in the new colors.  The resource caches hold the bitmaps
+// as they were before remapping, so they may be kept.
+void destroy_color_objects() {
+  bwd_destroy(&face_bitmap);
+  bwd_destroy(&date_window);
+  destroy_top_subdial_objects();
+
+  hand_cache_destroy(&hour_cache);
+  hand_cache_destroy(&minute_cache);
+  hand_cache_destroy(&second_cache);
+
+#ifdef MAKE_CHRONOGRAPH
+  destroy_chrono_color_objects();
+#endif  // MAKE_CHRONOGRAPH
+}
+
 // Updates any runtime settings as needed when the config changes.
 void apply_config() {
-  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "apply_config");
+  apply_config_changes(CC_all);
+}
+
+// Rebuilds just the parts of the watch named in changes, a set of
+// ConfigChange bits from config_changes().
+void apply_config_changes(unsigned int changes) {
+  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "apply_config_changes 0x%04x", changes);
+
+  if (memory_panic_count != 0) {
+    // We've had to give up some memory along the way.  Since we're
+    // about to reset that, rebuild everything too.
+    changes = CC_all;
+  }
 
   // Reset the memory panic count when we get a new config setting.
   // Maybe the user knows what he's doing.
@@ -1836,17 +1990,49 @@ void apply_config() {
     face_index = config.face_index;
   }
 
-  if (display_lang != config.display_lang) {
+  if ((changes & CC_date_names) && display_lang != config.display_lang) {
     // Reload the weekday, month, and ampm names from the appropriate
     // language resource.
     fill_date_names(date_names, NUM_DATE_NAMES, date_names_buffer, DATE_NAMES_MAX_BUFFER, lang_table[config.display_lang].date_name_id);
     display_lang = config.display_lang;
   }
 
-  // Reload all bitmaps just for good measure.  Maybe the user changed
-  // the draw mode or something else.
-  recreate_all_objects();
-  reset_tick_timer();
+  if (changes == CC_all) {
+    // Reload all bitmaps, at startup, or to recover memory.
+    recreate_all_objects();
+    reset_tick_timer();
+    return;
+  }
+
+  if (changes & CC_colors) {
+    destroy_color_objects();
+  }
+  if (changes & CC_face_bitmap) {
+    bwd_destroy(&face_bitmap);
+  }
+  if (changes & CC_top_subdial) {
+    destroy_top_subdial_objects();
+  }
+  if (changes & CC_date_fonts) {
+    load_date_fonts();
+  }
+
+  if (changes & CC_hands) {
+    time_t now = clock_time(NULL);
+    update_hands(localtime(&now));
+  }
+  if (changes & CC_tick_timer) {
+    reset_tick_timer();
+#if ENABLE_SWEEP_SECONDS
+    reset_sweep();
+#endif  // ENABLE_SWEEP_SECONDS
+  }
+
+  if (changes & CC_clock_face) {
+    invalidate_clock_face();
+  } else if (changes & CC_redraw) {
+    layer_mark_dirty(clock_face_layer);
+  }
 }
 
 // Call this to force the clock_face bitmap cache to be recomputed and
@@ -2026,6 +2212,9 @@ void handle_init() {
   app_message_register_inbox_received(receive_config_handler);
   app_message_register_inbox_dropped(dropped_config_handler);
 
+// The inbox is allocated from the app heap, so it is kept small.  The
+// phone splits a sync that won't fit into several messages, each sized
+// to the config_inbox_size we report.
 #define INBOX_MESSAGE_SIZE 200
 #define OUTBOX_MESSAGE_SIZE 50
 
@@ -2042,16 +2231,24 @@ void handle_init() {
   app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "app_message_open(%u, %u)", (unsigned int)inbox_max, (unsigned int)outbox_max);
   AppMessageResult open_result = app_message_open(inbox_max, outbox_max);
   app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "open_result = %d", open_result);
+  config_inbox_size = inbox_max;
 
 #else  // NDEBUG
   app_message_open(INBOX_MESSAGE_SIZE, OUTBOX_MESSAGE_SIZE);
+  config_inbox_size = INBOX_MESSAGE_SIZE;
 #endif  // NDEBUG
 
   reset_memory_panic_count();
   create_permanent_objects();
   create_temporal_objects();
 
-  time_t now = time(NULL);
+#ifdef FAST_TIME
+  // Make the hands fly around the face, so you can easily see them in
+  // several different orientations.
+  clock_source_accelerated(FAST_TIME_FACTOR);
+#endif  // FAST_TIME
+
+  time_t now = clock_time(NULL);
   struct tm *startup_time = localtime(&now);
   compute_hands(startup_time, &current_placement);
 
@@ -9,6 +9,7 @@
 #include "../resources/generated_defs.h"
 #include "bluetooth_indicator.h"
 #include "battery_gauge.h"
+#include "clock_source.h"
 #include "config_options.h"
 #include "assert.h"
 #include "bwd.h"
@@ -23,6 +24,13 @@
 #define SECONDS_PER_HOUR 3600
 #define MS_PER_DAY (SECONDS_PER_DAY * 1000)
 
+// Computes (x * numer) / denom for one of the divisions listed in
+// STEP_DIV_LIST, as a multiply and a shift.  config_watch.py chooses
+// the constants for each build's step counts, so the result is exact
+// for every x in range.  This saves a software division or two per
+// hand on each tick, which adds up at sweep rates.
+#define STEP_DIV(name, x) ((unsigned int)(((uint64_t)(x) * STEP_DIV_##name##_M) >> STEP_DIV_##name##_S))
+
 #ifdef PBL_ROUND
 #define SCREEN_WIDTH 180
 #define SCREEN_HEIGHT 180
@@ -65,6 +73,7 @@ struct __attribute__((__packed__)) HandPlacement {
 // hand, so we don't need to do as much work if we're redrawing a hand
 // in the same position as last time.
 #define HAND_CACHE_MAX_GROUPS 2
+#define HAND_CACHE_PALETTE_SIZE 16
 struct __attribute__((__packed__)) HandCache {
   unsigned char bitmap_hand_index;
   BitmapWithData image;
@@ -72,6 +81,25 @@ struct __attribute__((__packed__)) HandCache {
   unsigned char vector_hand_index;
   short cx, cy;
   GPath *path[HAND_CACHE_MAX_GROUPS];
+
+#ifndef PBL_PLATFORM_APLITE
+  // The hand's shared palettes, if it has them (see
+  // HandDef.palette_argb8), already remapped to the current colors.
+  // Every bitmap of the hand borrows these, so they are remapped just
+  // once, when palettes_ready is false.
+  bool palettes_ready;
+  GColor palette[HAND_CACHE_PALETTE_SIZE];
+  GColor mask_palette[HAND_CACHE_PALETTE_SIZE];
+#endif  // PBL_PLATFORM_APLITE
+
+#ifdef RUNTIME_HAND_ROTATION
+  // The master bitmap and mask of a hand that is rotated at runtime
+  // (see HandDef.use_rotation), decoded and remapped once, and kept
+  // for as long as the hand is.  image and mask hold the current
+  // rotation of these.
+  BitmapWithData master_image;
+  BitmapWithData master_mask;
+#endif  // RUNTIME_HAND_ROTATION
 };
 
 // The DrawModeTable is defined in write.c, and allows us to switch
@@ -123,6 +151,7 @@ void draw_hand_mask(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARAMS, s
 void draw_hand_fg(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARAMS, struct HandDef *hand_def, int hand_index, bool no_basalt_mask, GContext *ctx);
 void draw_hand(struct HandCache *hand_cache RESOURCE_CACHE_FORMAL_PARAMS, struct HandDef *hand_def, int hand_index, GContext *ctx);
 void remap_colors_clock(BitmapWithData *bwd);
+void remap_palette_clock(GColor *palette, int palette_size);
 void invalidate_clock_face();
 void destroy_objects();
 void create_objects();
@@ -1,5 +1,6 @@
 #include "wright.h"
 #include "wright_chrono.h"
+#include "lap_store.h"
 
 // The code in this file is used only when enabling Chronograph
 // features, including start/stop and lap buttons on the chrono dials.
@@ -35,15 +36,51 @@ Window *chrono_digital_window;
 StatusBarLayer *chrono_status_bar_layer = NULL;
 Layer *chrono_digital_contents_layer = NULL;
 #endif  // PBL_SDK_3
-TextLayer *chrono_digital_current_layer = NULL;
-TextLayer *chrono_digital_laps_layer[CHRONO_MAX_LAPS];
-Layer *chrono_digital_line_layer = NULL;
+// A single layer draws the laps, the current time, and the line
+// between them.
+Layer *chrono_digital_layer = NULL;
 bool chrono_digital_window_showing = false;
 AppTimer *chrono_digital_timer = NULL;
 
-#define CHRONO_DIGITAL_BUFFER_SIZE 11 // Enough space for "hh:mm:ss.d" plus a null byte
-char chrono_current_buffer[CHRONO_DIGITAL_BUFFER_SIZE];
-char chrono_laps_buffer[CHRONO_MAX_LAPS][CHRONO_DIGITAL_BUFFER_SIZE];
+#define CHRONO_DIGITAL_BUFFER_SIZE 12 // Enough space for "hhh:mm:ss.d" plus a null byte
+
+#define MS_PER_HALF_DAY (12 * SECONDS_PER_HOUR * 1000)
+
+// The elapsed chrono time, in 64-bit milliseconds, along with the same
+// time split into whole half-days and the milliseconds within the
+// current half-day.  Everything displayed (the hands, and the digital
+// readout) is derived from the 32-bit half_day_ms, so the usual
+// update, a fraction of a second after the last one, needs no 64-bit
+// division; see update_chrono_elapsed().
+typedef struct {
+  int64_t elapsed_ms;
+  uint32_t half_days;
+  uint32_t half_day_ms;
+} ChronoElapsed;
+
+// For the hands, and for the bottom row of the digital window.
+ChronoElapsed chrono_hands_elapsed = { 0, 0, 0 };
+ChronoElapsed chrono_digital_elapsed = { 0, 0, 0 };
+
+// The laps currently shown in the digital window, oldest first, read
+// from the lap store; 0 for an empty row.  The select button scrolls
+// back through older laps, a page at a time; chrono_lap_scroll is the
+// number of laps scrolled back from the newest.
+unsigned int chrono_digital_laps[CHRONO_MAX_LAPS];
+int chrono_lap_scroll = 0;
+
+// The digital readout is drawn from a cache of pre-rendered glyphs,
+// rather than through the system text engine, since it is redrawn ten
+// times a second.  The glyphs are rendered with the system font and
+// captured from the framebuffer the first time the window is drawn.
+#define CHRONO_GLYPH_COLON 10
+#define CHRONO_GLYPH_POINT 11
+#define CHRONO_NUM_GLYPHS 12
+static const char chrono_glyph_chars[CHRONO_NUM_GLYPHS + 1] = "0123456789:.";
+
+BitmapWithData chrono_glyph_cache[CHRONO_NUM_GLYPHS];
+uint8_t chrono_glyph_width[CHRONO_NUM_GLYPHS];
+bool chrono_glyph_cache_ready = false;
 
 #define CHRONO_DIGITAL_TICK_MS 100 // Every 0.1 seconds
 
@@ -53,39 +90,70 @@ bool chrono_dial_shows_tenths = false;
 
 int sweep_chrono_seconds_ms = 60 * 1000 / NUM_STEPS_CHRONO_SECOND;
 
-ChronoData chrono_data = { false, false, 0, 0, { 0, 0, 0, 0 } };
+ChronoData chrono_data = { 0, 0, false, false };
 ChronoData saved_chrono_data;
 
+// The older layout of ChronoData, which kept start_ms as milliseconds
+// past midnight UTC, and held the last few laps, before they moved to
+// the lap store.  If we find one of these in persistent storage, we
+// migrate it.
+typedef struct __attribute__((__packed__)) {
+  unsigned int start_ms;
+  unsigned int hold_ms;
+  unsigned char running;
+  unsigned char lap_paused;
+  unsigned int laps[4];
+} ChronoDataV1;
+
+// chrono_data and the lap store are written back to persistent
+// storage shortly after they change, rather than only at exit, so that
+// a crash or a dead battery doesn't lose a running chronograph.  The
+// write is deferred until they have been left alone for
+// CHRONO_SAVE_DELAY_MS, so a burst of button presses costs only one
+// write, and none of them waits on the flash.
+#define CHRONO_SAVE_DELAY_MS 3000
+AppTimer *chrono_save_timer = NULL;
+
 static const uint32_t chrono_tap_segments[] = { 50 };
 static VibePattern chrono_tap = {
   chrono_tap_segments,
   1,
 };
 
-// Returns the number of milliseconds since midnight, UTC.
-unsigned int get_time_ms() {
-  time_t gmt;
-  uint16_t t_ms;
-  unsigned int ms_utc;
+void handle_chrono_save_timer(void *data) {
+  chrono_save_timer = NULL;  // When the timer is handled, it is implicitly canceled.
+  save_chrono_data();
+}
 
-  time_ms(&gmt, &t_ms);
-  ms_utc = (unsigned int)((gmt % SECONDS_PER_DAY) * 1000 + t_ms);
+// Call this whenever chrono_data or the lap store has been changed, to
+// schedule it to be saved.  Each call pushes the save back again.
+void chrono_data_changed() {
+  if (chrono_save_timer == NULL || !app_timer_reschedule(chrono_save_timer, CHRONO_SAVE_DELAY_MS)) {
+    chrono_save_timer = app_timer_register(CHRONO_SAVE_DELAY_MS, &handle_chrono_save_timer, 0);
+  }
+}
 
-#ifdef FAST_TIME
-  ms_utc *= 67;
-#endif  // FAST_TIME
+// Returns the number of milliseconds since the Unix epoch.
+int64_t get_time_ms() {
+  time_t gmt;
+  uint16_t t_ms;
 
-  return ms_utc;
+  clock_time_ms(&gmt, &t_ms);
+  return (int64_t)gmt * 1000 + t_ms;
 }
 
 // Returns the time showing on the chronograph, given the ms returned
 // by get_time_ms().  Returns the current lap time if the lap is
 // paused.
-unsigned int get_chrono_ms(unsigned int ms) {
-  unsigned int chrono_ms;
+int64_t get_chrono_ms(int64_t ms) {
+  int64_t chrono_ms;
   if (chrono_data.running && !chrono_data.lap_paused) {
     // The chronograph is running.  Show the active elapsed time.
-    chrono_ms = (ms - chrono_data.start_ms + MS_PER_DAY) % MS_PER_DAY;
+    chrono_ms = ms - chrono_data.start_ms;
+    if (chrono_ms < 0) {
+      // The clock has been set back since the chrono was started.
+      chrono_ms = 0;
+    }
   } else {
     // The chronograph is paused.  Show the time it is paused on.
     chrono_ms = chrono_data.hold_ms;
@@ -94,8 +162,36 @@ unsigned int get_chrono_ms(unsigned int ms) {
   return chrono_ms;
 }
 
-void compute_chrono_hands(unsigned int ms, struct HandPlacement *placement) {
-  unsigned int chrono_ms = get_chrono_ms(ms);
+// Brings ce up to date with the indicated elapsed time.  Normally
+// this is only a little later than the last time, and we can just
+// carry the difference into half_day_ms; otherwise (the chrono was
+// reset or paused, or a long time has passed) we divide it out
+// again.
+void update_chrono_elapsed(ChronoElapsed *ce, int64_t elapsed_ms) {
+  int64_t delta = elapsed_ms - ce->elapsed_ms;
+  if (delta >= 0 && delta < MS_PER_HALF_DAY) {
+    ce->half_day_ms += (uint32_t)delta;
+    if (ce->half_day_ms >= MS_PER_HALF_DAY) {
+      ce->half_day_ms -= MS_PER_HALF_DAY;
+      ++(ce->half_days);
+    }
+  } else {
+    ce->half_days = (uint32_t)(elapsed_ms / MS_PER_HALF_DAY);
+    ce->half_day_ms = (uint32_t)(elapsed_ms - (int64_t)ce->half_days * MS_PER_HALF_DAY);
+  }
+  ce->elapsed_ms = elapsed_ms;
+}
+
+void compute_chrono_hands(int64_t ms, struct HandPlacement *placement) {
+  int64_t chrono_ms = get_chrono_ms(ms);
+  update_chrono_elapsed(&chrono_hands_elapsed, chrono_ms);
+
+  // Each hand's position within its own cycle, each derived from the
+  // next larger one.  The half-day is a whole number of each cycle.
+  unsigned int half_day_ms = chrono_hands_elapsed.half_day_ms;
+  unsigned int half_hour_ms = half_day_ms - STEP_DIV(MS_HALF_HOURS, half_day_ms) * (1800 * 1000);
+  unsigned int minute_ms = half_hour_ms - STEP_DIV(MS_MINUTES, half_hour_ms) * (60 * 1000);
+  unsigned int second_ms = minute_ms - STEP_DIV(MS_SECONDS, minute_ms) * 1000;
 
   bool chrono_dial_wants_tenths = true;
   switch (config.chrono_dial) {
@@ -127,22 +223,17 @@ void compute_chrono_hands(unsigned int ms, struct HandPlacement *placement) {
 #ifdef ENABLE_CHRONO_MINUTE_HAND
   // The chronograph minute hand rolls completely around in 30
   // minutes (not 60).
-  {
-    unsigned int use_ms = chrono_ms % (1800 * 1000);
-    placement->chrono_minute_hand_index = ((NUM_STEPS_CHRONO_MINUTE * use_ms) / (1800 * 1000)) % NUM_STEPS_CHRONO_MINUTE;
-  }
+  placement->chrono_minute_hand_index = STEP_DIV(CHRONO_MINUTE_HAND, half_hour_ms);
 #endif  // ENABLE_CHRONO_MINUTE_HAND
 
 #ifdef ENABLE_CHRONO_SECOND_HAND
   {
-    // Avoid overflowing the integer arithmetic by pre-constraining
-    // the ms value to the appropriate range.
-    unsigned int use_ms = chrono_ms % (60 * 1000);
+    unsigned int use_ms = minute_ms;
     if (!config.sweep_seconds) {
-      // Also constrain to an integer second if we've not enabled sweep-second resolution.
-      use_ms = (use_ms / 1000) * 1000;
+      // Constrain to an integer second if we've not enabled sweep-second resolution.
+      use_ms -= second_ms;
     }
-    placement->chrono_second_hand_index = ((NUM_STEPS_CHRONO_SECOND * use_ms) / (60 * 1000));
+    placement->chrono_second_hand_index = STEP_DIV(CHRONO_SECOND_HAND, use_ms);
   }
 #endif  // ENABLE_CHRONO_SECOND_HAND
 
@@ -159,16 +250,15 @@ void compute_chrono_hands(unsigned int ms, struct HandPlacement *placement) {
       } else {
 	// We show the tenths time when the chrono is stopped or showing
 	// the lap time.
-	unsigned int use_ms = chrono_ms % 1000;
+	unsigned int use_ms = second_ms;
 	// Truncate to the previous 0.1 seconds (100 ms), just to
 	// make the dial easier to read.
 	use_ms = 100 * (use_ms / 100);
-	placement->chrono_tenth_hand_index = ((NUM_STEPS_CHRONO_TENTH * use_ms) / (1000)) % NUM_STEPS_CHRONO_TENTH;
+	placement->chrono_tenth_hand_index = STEP_DIV(CHRONO_TENTH_HAND, use_ms);
       }
     } else {
       // Drawing hours.  12-hour scale.
-      unsigned int use_ms = chrono_ms % (12 * SECONDS_PER_HOUR * 1000);
-      placement->chrono_tenth_hand_index = ((NUM_STEPS_CHRONO_TENTH * use_ms) / (12 * SECONDS_PER_HOUR * 1000)) % NUM_STEPS_CHRONO_TENTH;
+      placement->chrono_tenth_hand_index = STEP_DIV(CHRONO_HOURS_HAND, half_day_ms);
     }
   }
 #endif  // ENABLE_CHRONO_TENTH_HAND
@@ -281,15 +371,19 @@ void update_chrono_hands(struct HandPlacement *new_placement) {
 
 void chrono_start_stop_handler(ClickRecognizerRef recognizer, void *context) {
   Window *window = (Window *)context;
-  unsigned int ms = get_time_ms();
+  int64_t ms = get_time_ms();
 
   // The start/stop button was pressed.
   if (chrono_data.running) {
     // If the chronograph is currently running, this means to stop (or
     // pause).
     chrono_data.hold_ms = ms - chrono_data.start_ms;
+    if (chrono_data.hold_ms < 0) {
+      chrono_data.hold_ms = 0;
+    }
     chrono_data.running = false;
     chrono_data.lap_paused = false;
+    chrono_data_changed();
     vibes_enqueue_custom_pattern(chrono_tap);
     update_hands(NULL);
     reset_tick_timer();
@@ -306,6 +400,7 @@ void chrono_start_stop_handler(ClickRecognizerRef recognizer, void *context) {
     // start, from the currently showing Chronograph time.
     chrono_data.start_ms = ms - chrono_data.hold_ms;
     chrono_data.running = true;
+    chrono_data_changed();
 #if ENABLE_SWEEP_SECONDS
     if (config.sweep_seconds) {
       if (sweep_chrono_seconds_ms < sweep_timer_ms) {
@@ -325,7 +420,7 @@ void chrono_start_stop_handler(ClickRecognizerRef recognizer, void *context) {
 }
 
 void chrono_lap_button() {
-  unsigned int ms;
+  int64_t ms;
  
   ms = get_time_ms();
 
@@ -333,18 +428,20 @@ void chrono_lap_button() {
     // If we were already paused, this resumes the motion, jumping
     // ahead to the currently elapsed time.
     chrono_data.lap_paused = false;
+    chrono_data_changed();
     vibes_enqueue_custom_pattern(chrono_tap);
     update_hands(NULL);
   } else {
     // If we were not already paused, this pauses the hands here (but
     // does not stop the timer).
-    unsigned int lap_ms = ms - chrono_data.start_ms;
+    int64_t lap_ms = get_chrono_ms(ms);
     record_chrono_lap(lap_ms);
     if (!chrono_digital_window_showing) {
       // Actually, we only pause the hands if we're not looking at the
       // digital timer.
       chrono_data.hold_ms = lap_ms;
       chrono_data.lap_paused = true;
+      chrono_data_changed();
     }
     vibes_enqueue_custom_pattern(chrono_tap);
     update_hands(NULL);
@@ -356,13 +453,15 @@ void chrono_reset_button() {
   time_t now;
   struct tm *this_time;
 
-  now = time(NULL);
+  now = clock_time(NULL);
   this_time = localtime(&now);
   chrono_data.running = false;
   chrono_data.lap_paused = false;
   chrono_data.start_ms = 0;
   chrono_data.hold_ms = 0;
-  memset(&chrono_data.laps[0], 0, sizeof(chrono_data.laps[0]) * CHRONO_MAX_LAPS);
+  lap_store_reset();
+  chrono_data_changed();
+  chrono_lap_scroll = 0;
   vibes_double_pulse();
   update_chrono_laps_time();
   update_hands(this_time);
@@ -390,19 +489,171 @@ void chrono_lap_or_reset_handler(ClickRecognizerRef recognizer, void *context) {
   }
 }
   
-void chrono_digital_line_layer_update_callback(Layer *me, GContext *ctx) {
-  GRect destination = layer_get_bounds(me);
+void destroy_chrono_glyph_cache() {
+  for (int i = 0; i < CHRONO_NUM_GLYPHS; ++i) {
+    bwd_destroy(&chrono_glyph_cache[i]);
+  }
+  chrono_glyph_cache_ready = false;
+}
 
-  // Paint the background black.
-  graphics_context_set_fill_color(ctx, GColorBlack);
-  graphics_fill_rect(ctx, destination, 0, GCornerNone);
+// Renders each of the glyphs with the system font, into the layer's
+// own area of the framebuffer, and copies them into
+// chrono_glyph_cache.  The layer is cleared again afterwards, so none
+// of this is ever seen.  If there isn't enough memory for the cache,
+// chrono_glyph_cache_ready remains false, and the readout is drawn as
+// text instead.
+void build_chrono_glyph_cache(Layer *me, GContext *ctx, GFont font) {
+  GRect bounds = layer_get_bounds(me);
+  GRect box = GRect(0, 0, bounds.size.w, LAP_HEIGHT);
+  GPoint cell[CHRONO_NUM_GLYPHS];
+  char text[2] = { '\0', '\0' };
+
+  graphics_context_set_fill_color(ctx, GColorWhite);
+  graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+  graphics_context_set_text_color(ctx, GColorBlack);
+
+  // Lay the glyphs out in rows across the layer.
+  int x = 0;
+  int y = 0;
+  for (int i = 0; i < CHRONO_NUM_GLYPHS; ++i) {
+    text[0] = chrono_glyph_chars[i];
+    int width = graphics_text_layout_get_content_size(text, font, box, GTextOverflowModeFill, GTextAlignmentLeft).w;
+    if (width < 1) {
+      width = 1;
+    }
+    if (x + width > bounds.size.w) {
+      x = 0;
+      y += LAP_HEIGHT;
+    }
+    cell[i] = GPoint(x, y);
+    chrono_glyph_width[i] = width;
+    x += width;
+  }
+
+  // Then center the rows vertically, which keeps them within the
+  // visible part of the screen on Chalk, and draw them.
+  int y_offset = (bounds.size.h - (y + LAP_HEIGHT)) / 2;
+  for (int i = 0; i < CHRONO_NUM_GLYPHS; ++i) {
+    text[0] = chrono_glyph_chars[i];
+    cell[i].y += y_offset;
+    graphics_draw_text(ctx, text, font, GRect(cell[i].x, cell[i].y, chrono_glyph_width[i], LAP_HEIGHT), GTextOverflowModeFill, GTextAlignmentLeft, NULL);
+  }
+
+  // Find the layer's origin on the screen.
+  GPoint origin = layer_get_frame(me).origin;
+#ifdef PBL_SDK_3
+  GPoint contents_origin = layer_get_frame(chrono_digital_contents_layer).origin;
+  origin.x += contents_origin.x;
+  origin.y += contents_origin.y;
+#endif  // PBL_SDK_3
+
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if (fb == NULL) {
+    return;
+  }
+  bool success = true;
+  for (int i = 0; i < CHRONO_NUM_GLYPHS && success; ++i) {
+    GRect rect = GRect(origin.x + cell[i].x, origin.y + cell[i].y, chrono_glyph_width[i], LAP_HEIGHT);
+    chrono_glyph_cache[i] = bwd_copy_bitmap_rect(fb, rect);
+    success = (chrono_glyph_cache[i].bitmap != NULL);
+  }
+  graphics_release_frame_buffer(ctx, fb);
+
+  if (success) {
+    chrono_glyph_cache_ready = true;
+  } else {
+    app_log(APP_LOG_LEVEL_WARNING, __FILE__, __LINE__, "couldn't build chrono glyph cache");
+    destroy_chrono_glyph_cache();
+  }
 }
 
-void chrono_digital_window_load_handler(struct Window *window) {
-  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "chrono digital loads");
+// Fills glyphs[] with the glyph indexes for "h:mm:ss.d", given the
+// whole hours and the milliseconds past the hour, and returns the
+// number of glyphs.
+int get_chrono_glyphs(unsigned int chrono_h, unsigned int hour_ms, uint8_t glyphs[CHRONO_DIGITAL_BUFFER_SIZE]) {
+  unsigned int chrono_m = hour_ms / (1000 * 60);
+  unsigned int chrono_s = (hour_ms / (1000)) % 60;
+  unsigned int chrono_t = (hour_ms / (100)) % 10;
+
+  int n = 0;
+  if (chrono_h >= 100) {
+    glyphs[n++] = (chrono_h / 100) % 10;
+  }
+  if (chrono_h >= 10) {
+    glyphs[n++] = (chrono_h / 10) % 10;
+  }
+  glyphs[n++] = chrono_h % 10;
+  glyphs[n++] = CHRONO_GLYPH_COLON;
+  glyphs[n++] = chrono_m / 10;
+  glyphs[n++] = chrono_m % 10;
+  glyphs[n++] = CHRONO_GLYPH_COLON;
+  glyphs[n++] = chrono_s / 10;
+  glyphs[n++] = chrono_s % 10;
+  glyphs[n++] = CHRONO_GLYPH_POINT;
+  glyphs[n++] = chrono_t;
+  return n;
+}
 
+// Draws one row of the digital readout, right-aligned within the same
+// box the text layers used to occupy.
+void draw_chrono_digital_row(GContext *ctx, GFont font, unsigned int chrono_h, unsigned int hour_ms, int row) {
+  GRect box = GRect(25, LAP_HEIGHT * row, 94, LAP_HEIGHT);
+  uint8_t glyphs[CHRONO_DIGITAL_BUFFER_SIZE];
+  int num_glyphs = get_chrono_glyphs(chrono_h, hour_ms, glyphs);
+
+  if (!chrono_glyph_cache_ready) {
+    // No glyph cache; draw it as text.
+    char buffer[CHRONO_DIGITAL_BUFFER_SIZE];
+    for (int i = 0; i < num_glyphs; ++i) {
+      buffer[i] = chrono_glyph_chars[glyphs[i]];
+    }
+    buffer[num_glyphs] = '\0';
+    graphics_context_set_text_color(ctx, GColorBlack);
+    graphics_draw_text(ctx, buffer, font, box, GTextOverflowModeFill, GTextAlignmentRight, NULL);
+    return;
+  }
+
+  int width = 0;
+  for (int i = 0; i < num_glyphs; ++i) {
+    width += chrono_glyph_width[glyphs[i]];
+  }
+  int x = box.origin.x + box.size.w - width;
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+  for (int i = 0; i < num_glyphs; ++i) {
+    int gi = glyphs[i];
+    graphics_draw_bitmap_in_rect(ctx, chrono_glyph_cache[gi].bitmap, GRect(x, box.origin.y, chrono_glyph_width[gi], LAP_HEIGHT));
+    x += chrono_glyph_width[gi];
+  }
+}
+
+void chrono_digital_layer_update_callback(Layer *me, GContext *ctx) {
   GFont font = fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD);
+  if (!chrono_glyph_cache_ready) {
+    build_chrono_glyph_cache(me, ctx, font);
+  }
 
+  GRect bounds = layer_get_bounds(me);
+  graphics_context_set_fill_color(ctx, GColorWhite);
+  graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+
+  for (int i = 0; i < CHRONO_MAX_LAPS; ++i) {
+    unsigned int lap_ms = chrono_digital_laps[i];
+    if (lap_ms != 0) {
+      draw_chrono_digital_row(ctx, font, lap_ms / (SECONDS_PER_HOUR * 1000), lap_ms % (SECONDS_PER_HOUR * 1000), i);
+    }
+  }
+
+  unsigned int half_day_ms = chrono_digital_elapsed.half_day_ms;
+  unsigned int chrono_h = chrono_digital_elapsed.half_days * 12 + half_day_ms / (SECONDS_PER_HOUR * 1000);
+  draw_chrono_digital_row(ctx, font, chrono_h, half_day_ms % (SECONDS_PER_HOUR * 1000), CHRONO_MAX_LAPS);
+
+  // The line between the laps and the current time.
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, GRect(0, LAP_HEIGHT * CHRONO_MAX_LAPS + 1, bounds.size.w, 1), 0, GCornerNone);
+}
+
+void chrono_digital_window_load_handler(struct Window *window) {
+  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "chrono digital loads");
 
 #ifdef PBL_SDK_3
   Layer *chrono_digital_window_layer = window_get_root_layer(chrono_digital_window);
@@ -427,41 +678,13 @@ void chrono_digital_window_load_handler(struct Window *window) {
   
 #endif  // PBL_SDK_3
 
-  chrono_digital_current_layer = text_layer_create(GRect(25, LAP_HEIGHT * CHRONO_MAX_LAPS, 94, LAP_HEIGHT));
-  if (chrono_digital_current_layer == NULL) {
+  chrono_digital_layer = layer_create(layer_get_bounds(chrono_digital_contents_layer));
+  if (chrono_digital_layer == NULL) {
     trigger_memory_panic(__LINE__);
     return;
   }    
-  int i;
-  for (i = 0; i < CHRONO_MAX_LAPS; ++i) {
-    chrono_digital_laps_layer[i] = text_layer_create(GRect(25, LAP_HEIGHT * i, 94, LAP_HEIGHT));
-    if (chrono_digital_laps_layer[i] == NULL) {
-      trigger_memory_panic(__LINE__);
-      return;
-    }    
-
-    text_layer_set_text(chrono_digital_laps_layer[i], chrono_laps_buffer[i]);
-    text_layer_set_text_color(chrono_digital_laps_layer[i], GColorBlack);
-    text_layer_set_text_alignment(chrono_digital_laps_layer[i], GTextAlignmentRight);
-    text_layer_set_overflow_mode(chrono_digital_laps_layer[i], GTextOverflowModeFill);
-    text_layer_set_font(chrono_digital_laps_layer[i], font);
-    layer_add_child(chrono_digital_contents_layer, (Layer *)chrono_digital_laps_layer[i]);
-  }
-
-  text_layer_set_text(chrono_digital_current_layer, chrono_current_buffer);
-  text_layer_set_text_color(chrono_digital_current_layer, GColorBlack);
-  text_layer_set_text_alignment(chrono_digital_current_layer, GTextAlignmentRight);
-  text_layer_set_overflow_mode(chrono_digital_current_layer, GTextOverflowModeFill);
-  text_layer_set_font(chrono_digital_current_layer, font);
-  layer_add_child(chrono_digital_contents_layer, (Layer *)chrono_digital_current_layer);
-
-  chrono_digital_line_layer = layer_create(GRect(0, LAP_HEIGHT * CHRONO_MAX_LAPS + 1, SCREEN_WIDTH, 1));
-  if (chrono_digital_line_layer == NULL) {
-    trigger_memory_panic(__LINE__);
-    return;
-  }    
-  layer_set_update_proc(chrono_digital_line_layer, &chrono_digital_line_layer_update_callback);
-  layer_add_child(chrono_digital_contents_layer, (Layer *)chrono_digital_line_layer);
+  layer_set_update_proc(chrono_digital_layer, &chrono_digital_layer_update_callback);
+  layer_add_child(chrono_digital_contents_layer, chrono_digital_layer);
 }
 
 void chrono_digital_window_appear_handler(struct Window *window) {
@@ -469,7 +692,16 @@ void chrono_digital_window_appear_handler(struct Window *window) {
   chrono_digital_window_showing = true;
 
   // We never have the lap timer paused while the digital window is visible.
-  chrono_data.lap_paused = false;
+  if (chrono_data.lap_paused) {
+    chrono_data.lap_paused = false;
+    chrono_data_changed();
+  }
+
+  // Always start with the newest laps.
+  if (chrono_lap_scroll != 0) {
+    chrono_lap_scroll = 0;
+    update_chrono_laps_time();
+  }
 
   if (chrono_data.running) {
     window_set_click_config_provider(chrono_digital_window, &started_click_config_provider);
@@ -489,22 +721,11 @@ void chrono_digital_window_disappear_handler(struct Window *window) {
 void chrono_digital_window_unload_handler(struct Window *window) {
   app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "chrono digital unloads");
 
-  if (chrono_digital_line_layer != NULL) {
-    layer_destroy(chrono_digital_line_layer);
-    chrono_digital_line_layer = NULL;
-  }
-  
-  if (chrono_digital_current_layer != NULL) {
-    text_layer_destroy(chrono_digital_current_layer);
-    chrono_digital_current_layer = NULL;
-  }
-  int i;
-  for (i = 0; i < CHRONO_MAX_LAPS; ++i) {
-    if (chrono_digital_laps_layer[i] != NULL) {
-      text_layer_destroy(chrono_digital_laps_layer[i]);
-      chrono_digital_laps_layer[i] = NULL;
-    }
+  if (chrono_digital_layer != NULL) {
+    layer_destroy(chrono_digital_layer);
+    chrono_digital_layer = NULL;
   }
+  destroy_chrono_glyph_cache();
 
 #ifdef PBL_SDK_3
   if (chrono_digital_contents_layer != NULL) {
@@ -520,7 +741,17 @@ void chrono_digital_window_unload_handler(struct Window *window) {
 
 void push_chrono_digital_handler(ClickRecognizerRef recognizer, void *context) {
   //  app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "push chrono digital");
-  if (!chrono_digital_window_showing) {
+  if (chrono_digital_window_showing) {
+    // While the digital window is showing, the same button scrolls
+    // back through the laps instead, a page at a time, and wraps
+    // around to the newest laps after the oldest.
+    chrono_lap_scroll += CHRONO_MAX_LAPS;
+    if (lap_store_count() - chrono_lap_scroll <= lap_store_first()) {
+      chrono_lap_scroll = 0;
+    }
+    update_chrono_laps_time();
+
+  } else {
 
     // Release some caches and repack our memory allocations before we
     // push the window.
@@ -594,49 +825,49 @@ void chrono_set_click_config(struct Window *window) {
 }
 
 
+// Reloads the page of laps shown in the digital window from the lap
+// store.
 void update_chrono_laps_time() {
-  int i;
-
-  for (i = 0; i < CHRONO_MAX_LAPS; ++i) {
-    unsigned int chrono_ms = chrono_data.laps[i];
-    unsigned int chrono_h = chrono_ms / (1000 * 60 * 60);
-    unsigned int chrono_m = (chrono_ms / (1000 * 60)) % 60;
-    unsigned int chrono_s = (chrono_ms / (1000)) % 60;
-    unsigned int chrono_t = (chrono_ms / (100)) % 10;
-
-    if (chrono_ms == 0) {
-      // No data: empty string.
-      chrono_laps_buffer[i][0] = '\0';
-    } else {
-      // Real data: formatted string.
-      snprintf(chrono_laps_buffer[i], CHRONO_DIGITAL_BUFFER_SIZE, "%u:%02u:%02u.%u", 
-	       chrono_h, chrono_m, chrono_s, chrono_t);
-    }
-    if (chrono_digital_laps_layer[i] != NULL) {
-      layer_mark_dirty((Layer *)chrono_digital_laps_layer[i]);
-    }
+  int end = lap_store_count() - chrono_lap_scroll;
+  int first = end - CHRONO_MAX_LAPS;
+  if (first < lap_store_first()) {
+    first = lap_store_first();
+  }
+  int num_laps = end - first;
+  if (num_laps < 0) {
+    num_laps = 0;
+  }
+
+  // The newest lap on the page goes in the bottom row.
+  memset(chrono_digital_laps, 0, sizeof(chrono_digital_laps));
+  lap_store_read(first, num_laps, &chrono_digital_laps[CHRONO_MAX_LAPS - num_laps]);
+
+  if (chrono_digital_layer != NULL) {
+    layer_mark_dirty(chrono_digital_layer);
   }
 }
 
-void record_chrono_lap(int chrono_ms) {
-  // Lose the first one.
-  memmove(&chrono_data.laps[0], &chrono_data.laps[1], sizeof(chrono_data.laps[0]) * (CHRONO_MAX_LAPS - 1));
-  chrono_data.laps[CHRONO_MAX_LAPS - 1] = chrono_ms;
+void record_chrono_lap(int64_t chrono_ms) {
+  // The lap store keeps 32-bit laps, which is good for 49 days.
+  lap_store_append(chrono_ms < 0xffffffff ? (unsigned int)chrono_ms : 0xffffffff);
+  chrono_data_changed();
+  chrono_lap_scroll = 0;
   update_chrono_laps_time();
 }
 
 void update_chrono_current_time() {
-  unsigned int ms = get_time_ms();
-  unsigned int chrono_ms = get_chrono_ms(ms);
-  unsigned int chrono_h = chrono_ms / (1000 * 60 * 60);
-  unsigned int chrono_m = (chrono_ms / (1000 * 60)) % 60;
-  unsigned int chrono_s = (chrono_ms / (1000)) % 60;
-  unsigned int chrono_t = (chrono_ms / (100)) % 10;
-  
-  snprintf(chrono_current_buffer, CHRONO_DIGITAL_BUFFER_SIZE, "%u:%02u:%02u.%u", 
-	   chrono_h, chrono_m, chrono_s, chrono_t);
-  if (chrono_digital_current_layer != NULL) {
-    layer_mark_dirty((Layer *)chrono_digital_current_layer);
+  int64_t chrono_ms = get_chrono_ms(get_time_ms());
+
+  // Only the displayed tenths matter; don't redraw if they haven't
+  // changed (for instance, while the chrono is stopped).
+  uint32_t half_days = chrono_digital_elapsed.half_days;
+  unsigned int tenths = chrono_digital_elapsed.half_day_ms / 100;
+  update_chrono_elapsed(&chrono_digital_elapsed, chrono_ms);
+  if (chrono_digital_elapsed.half_days == half_days && chrono_digital_elapsed.half_day_ms / 100 == tenths) {
+    return;
+  }
+  if (chrono_digital_layer != NULL) {
+    layer_mark_dirty(chrono_digital_layer);
   }
 }
 
@@ -658,32 +889,76 @@ void reset_chrono_digital_timer() {
   }
 }
 
+// Converts a start_ms in the older ChronoData layout, in milliseconds
+// past midnight UTC, to milliseconds since the epoch, assuming the
+// chrono has been running less than a day (which was all the old
+// layout could measure anyway).
+int64_t convert_chrono_start_ms(unsigned int start_ms) {
+  int64_t ms = get_time_ms();
+  unsigned int ms_utc = (unsigned int)(ms % MS_PER_DAY);
+  unsigned int chrono_ms = (ms_utc - start_ms + MS_PER_DAY) % MS_PER_DAY;
+  return ms - chrono_ms;
+}
+
 void
 load_chrono_data() {
+  lap_store_load();
+
   ChronoData local_data;
-  if (persist_read_data(PERSIST_KEY + 0x100, &local_data, sizeof(local_data)) == sizeof(local_data)) {
+  ChronoDataV1 v1_data;
+  int size = persist_get_size(PERSIST_KEY + 0x100);
+  bool loaded = false;
+  if (size == sizeof(v1_data) &&
+      persist_read_data(PERSIST_KEY + 0x100, &v1_data, sizeof(v1_data)) == sizeof(v1_data)) {
+    // The first version saved the last few laps along with the rest
+    // of chrono_data.  Move them into the lap store, oldest first.
+    // The old record is deleted, and saved_chrono_data left cleared,
+    // so the new layout gets written back soon (if it's not empty).
+    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Migrating chrono_data v1");
+    persist_delete(PERSIST_KEY + 0x100);
+    local_data.start_ms = convert_chrono_start_ms(v1_data.start_ms);
+    local_data.hold_ms = v1_data.hold_ms;
+    local_data.running = v1_data.running;
+    local_data.lap_paused = v1_data.lap_paused;
+    memset(&saved_chrono_data, 0, sizeof(saved_chrono_data));
+    lap_store_reset();
+    for (int i = 0; i < 4; ++i) {
+      if (v1_data.laps[i] != 0) {
+        lap_store_append(v1_data.laps[i]);
+      }
+    }
+    chrono_data = local_data;
+    chrono_data_changed();
+    loaded = true;
+
+  } else if (persist_read_data(PERSIST_KEY + 0x100, &local_data, sizeof(local_data)) == sizeof(local_data)) {
     chrono_data = local_data;
     saved_chrono_data = local_data;
-    // Ensure the start time is within modulo 24 hours of the current
-    // day, to minimize the danger of integer overflow after 49 days.
-    // As long as you launch the Chronograph at least once every 49
-    // days, we'll keep an accurate time measurement (but we only ever
-    // show modulo 24 hours).
+    loaded = true;
+  }
+
+  if (loaded) {
     app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Loaded chrono_data");
-    if (chrono_data.running) {
-      unsigned int ms = get_time_ms();
-      unsigned int chrono_ms = (ms - chrono_data.start_ms + MS_PER_DAY) % MS_PER_DAY;
-      app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Modulated start_ms from %u to %u", chrono_data.start_ms, ms - chrono_ms);
-      chrono_data.start_ms = ms - chrono_ms;
-    }
-    
     update_chrono_laps_time();
   } else {
     app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Wrong previous chrono_data size or no previous data.");
   }
 }
 
+// Writes chrono_data to persistent storage now, if it has changed
+// since it was last saved, along with any changes to the lap store.  This is called at exit, and by the
+// deferred save scheduled by chrono_data_changed().
 void save_chrono_data() {
+  if (chrono_save_timer != NULL) {
+    app_timer_cancel(chrono_save_timer);
+    chrono_save_timer = NULL;
+  }
+
+  if (lap_store_dirty()) {
+    lap_store_flush();
+    app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "Saved lap store");
+  }
+
   if (memcmp(&chrono_data, &saved_chrono_data, sizeof(chrono_data)) == 0) {
     app_log(APP_LOG_LEVEL_INFO, __FILE__, __LINE__, "chrono_data unchanged.");
   } else {
@@ -715,6 +990,12 @@ void destroy_chrono_objects() {
     chrono_digital_window = NULL;
   }
 
+  destroy_chrono_color_objects();
+}
+
+// Releases the chrono hand caches and the dial, which are remapped to
+// the current draw_mode and color_mode.
+void destroy_chrono_color_objects() {
   hand_cache_destroy(&chrono_minute_cache);
   hand_cache_destroy(&chrono_second_cache);
   hand_cache_destroy(&chrono_tenth_cache);
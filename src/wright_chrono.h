@@ -5,15 +5,17 @@
 
 #ifdef MAKE_CHRONOGRAPH
 
-// Number of laps preserved for the laps digital display
+// Number of laps shown at once in the laps digital display.  The laps
+// themselves are kept in the lap store (see lap_store.h).
 #define CHRONO_MAX_LAPS 4
 
+// start_ms is in milliseconds since the Unix epoch, and hold_ms is an
+// elapsed time, so the chronograph can run for any number of days.
 typedef struct __attribute__((__packed__)) {
-  unsigned int start_ms;              // consulted if chrono_data.running && !chrono_data.lap_paused
-  unsigned int hold_ms;               // consulted if !chrono_data.running || chrono_data.lap_paused
+  int64_t start_ms;                   // consulted if chrono_data.running && !chrono_data.lap_paused
+  int64_t hold_ms;                    // consulted if !chrono_data.running || chrono_data.lap_paused
   unsigned char running;              // the chronograph has been started
   unsigned char lap_paused;           // the "lap" button has been pressed
-  unsigned int laps[CHRONO_MAX_LAPS];
 } ChronoData;
 
 extern ChronoData chrono_data;
@@ -29,15 +31,16 @@ extern Layer *chrono_minute_layer;
 extern Layer *chrono_second_layer;
 extern Layer *chrono_tenth_layer;
 
-void compute_chrono_hands(unsigned int ms, struct HandPlacement *placement);
+void compute_chrono_hands(int64_t ms, struct HandPlacement *placement);
 void update_chrono_hands(struct HandPlacement *new_placement);
 void reset_chrono_digital_timer();
-void record_chrono_lap(int chrono_ms);
+void record_chrono_lap(int64_t chrono_ms);
 void update_chrono_laps_time();
 void chrono_set_click_config(struct Window *window);
 
 void create_chrono_objects();
 void destroy_chrono_objects();
+void destroy_chrono_color_objects();
 void load_chrono_data();
 void save_chrono_data();
 void draw_chrono_dial(GContext *ctx);
@@ -0,0 +1,142 @@
+#! /usr/bin/env python
+
+import sys
+import os
+import getopt
+import subprocess
+from host.host_build import buildHostProgram, readAppinfo, watchStyles, configureStyle, rootDir, hostDir
+
+help = """
+sync_watch.py
+
+This script exercises the config sync protocol between
+pebble-js-app.js and the watch, on the development host, for the
+watch as currently configured by config_watch.py.  The real code in
+src/ is compiled natively against the SDK stand-in in host/, and the
+generated src/js/pebble-js-app.js is run under Node, in the stand-in
+PebbleKit JS runtime in host/pebble_js_host.js, with its messages
+delivered to the watch code and the watch's replies delivered back.
+
+The phone and the watch are taken through a series of steps--
+reconnects, config changes, restarts, lost messages--and for each
+step the script reports the messages sent to the watch, their size,
+the number lost and retried, the (simulated) time taken, and whether
+the watch's config changed.  At the end, it checks that the watch and
+the phone agree on the config, and exits with a nonzero status if
+they don't.
+
+sync_watch.py [opts]
+
+Options:
+
+    -p platform[,platform...]
+        Specifies the platform(s) to run (aplite, basalt, and/or
+        chalk).  The default is all of the platforms targeted by the
+        current build.
+
+    -s style[,style...]
+        Reconfigures the watch to each of the indicated styles in
+        turn, and runs each one.  The style names are %(styles)s,
+        or "all" for all of them.  This leaves the last style
+        configured.  The default is to run the watch as it is
+        currently configured.
+
+    -S step[,step...]
+        Specifies the steps to run, in place of the default sequence
+        %(defaultSteps)s.  Each step is one of:
+
+          ready          the phone reconnects to the watch
+          set:name=value the user changes a setting on the config
+                         page; use + to change several at once, as
+                         in set:draw_mode=1+second_hand=0
+          restart        the watch app is restarted
+          reinstall      the watch app is reinstalled, losing its
+                         saved config
+          drop:N         the next N messages to the watch are lost
+
+    -v
+        Verbose: show the compile commands, the watch's log output,
+        and the JS app's console output.
+
+"""
+
+defaultSteps = [ 'ready', 'ready', 'set:battery_gauge=2', 'drop:3', 'set:draw_mode=1+second_hand=0',
+                 'restart', 'reinstall', 'ready' ]
+
+help = help % {
+    'styles' : ', '.join([style for style, configArgs in watchStyles]),
+    'defaultSteps' : ','.join(defaultSteps),
+    }
+
+def usage(code, msg = ''):
+    print >> sys.stderr, help
+    print >> sys.stderr, msg
+    sys.exit(code)
+
+def syncPlatform(style, platform, steps, verbose):
+    """ Builds and runs the sync steps for the indicated platform.
+    Returns true if the watch and phone end up in sync. """
+
+    program, manifestFilename = buildHostProgram(platform, 'sync_watch.c', 'sync_watch', verbose = verbose)
+    cmd = [ 'node', os.path.join(hostDir, 'pebble_js_host.js') ]
+    if verbose:
+        cmd.append('-v')
+    cmd += [ os.path.join(rootDir, 'appinfo.json'),
+             os.path.join(rootDir, 'src', 'js', 'pebble-js-app.js'),
+             program, manifestFilename ]
+    cmd += [ step.replace('+', ',') for step in steps ]
+    if verbose:
+        print >> sys.stderr, ' '.join(cmd)
+
+    print "%s %s:" % (style, platform)
+    sys.stdout.flush()
+    result = subprocess.call(cmd)
+    if result != 0:
+        print "%s %s: failed." % (style, platform)
+        return False
+    return True
+
+# Main.
+try:
+    opts, args = getopt.getopt(sys.argv[1:], 'p:s:S:vh')
+except getopt.error, msg:
+    usage(1, msg)
+
+targetPlatforms = []
+styles = []
+steps = []
+verbose = False
+for opt, arg in opts:
+    if opt == '-p':
+        targetPlatforms += arg.split(',')
+    elif opt == '-s':
+        if arg == 'all':
+            styles += [style for style, configArgs in watchStyles]
+        else:
+            styles += arg.split(',')
+    elif opt == '-S':
+        steps += arg.split(',')
+    elif opt == '-v':
+        verbose = True
+    elif opt == '-h':
+        usage(0)
+
+for style in styles:
+    if style not in dict(watchStyles):
+        usage(1, "Unknown style '%s'." % (style))
+
+failed = False
+for style in styles or [ 'current' ]:
+    if style != 'current':
+        configureStyle(style, verbose = verbose)
+
+    appinfo = readAppinfo()
+    platforms = targetPlatforms or appinfo['targetPlatforms']
+    for platform in platforms:
+        if platform not in appinfo['targetPlatforms']:
+            continue
+        if not syncPlatform(style, platform, steps or defaultSteps, verbose):
+            failed = True
+
+if failed:
+    sys.exit(1)